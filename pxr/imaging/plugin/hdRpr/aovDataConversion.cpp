@@ -0,0 +1,105 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "aovDataConversion.h"
+
+#include "pxr/base/gf/half.h"
+#include "pxr/base/work/loops.h"
+
+#include <cstdint>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+template <typename T, size_t NumComponents, typename ConvertOp>
+void ConvertPixels(GfVec4f const* srcData, size_t numPixels, void* dstBuffer, ConvertOp convertOp) {
+    auto dstData = static_cast<T*>(dstBuffer);
+    WorkParallelForN(numPixels,
+        [srcData, dstData, convertOp](size_t begin, size_t end) {
+            // Fixed component count and plain arrays let the compiler vectorize this loop
+            auto src = reinterpret_cast<float const*>(srcData + begin);
+            auto dst = dstData + begin * NumComponents;
+            for (size_t i = 0; i < end - begin; ++i) {
+                for (size_t c = 0; c < NumComponents; ++c) {
+                    dst[i * NumComponents + c] = convertOp(src[i * 4 + c]);
+                }
+            }
+        }
+    );
+}
+
+template <typename T, typename ConvertOp>
+bool ConvertPixels(GfVec4f const* srcData, size_t numPixels, size_t numComponents, void* dstBuffer, ConvertOp convertOp) {
+    switch (numComponents) {
+        case 1: ConvertPixels<T, 1>(srcData, numPixels, dstBuffer, convertOp); return true;
+        case 2: ConvertPixels<T, 2>(srcData, numPixels, dstBuffer, convertOp); return true;
+        case 3: ConvertPixels<T, 3>(srcData, numPixels, dstBuffer, convertOp); return true;
+        case 4: ConvertPixels<T, 4>(srcData, numPixels, dstBuffer, convertOp); return true;
+        default: return false;
+    }
+}
+
+} // namespace anonymous
+
+bool HdRprConvertFramebufferData(GfVec4f const* srcData, size_t numPixels, HdFormat format, void* dstBuffer) {
+    auto numComponents = HdGetComponentCount(format);
+    switch (HdGetComponentFormat(format)) {
+        case HdFormatFloat32:
+            return ConvertPixels<float>(srcData, numPixels, numComponents, dstBuffer,
+                [](float value) { return value; });
+        case HdFormatFloat16:
+            return ConvertPixels<GfHalf>(srcData, numPixels, numComponents, dstBuffer,
+                [](float value) { return GfHalf(value); });
+        case HdFormatUNorm8:
+            return ConvertPixels<uint8_t>(srcData, numPixels, numComponents, dstBuffer,
+                [](float value) {
+                    // Written this way to map NaN to zero
+                    float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+                    return uint8_t(clamped * 255.0f + 0.5f);
+                });
+        default:
+            return false;
+    }
+}
+
+void HdRprConvertPrimIdData(GfVec4f const* srcData, size_t numPixels, int* dstData) {
+    WorkParallelForN(numPixels,
+        [srcData, dstData](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                // c[i].x = i;
+                // c[i].y = i/256;
+                // c[i].z = i/(256*256);
+                // The alpha channel is ignored
+                auto& color = srcData[i];
+                uint32_t id = uint32_t(uint8_t(color[0] * 255 + 0.5f)) |
+                    (uint32_t(uint8_t(color[1] * 255 + 0.5f)) << 8) |
+                    (uint32_t(uint8_t(color[2] * 255 + 0.5f)) << 16);
+                dstData[i] = int(id) - 1;
+            }
+        }
+    );
+}
+
+void HdRprDecodePrimIdData(int* data, size_t numPixels) {
+    WorkParallelForN(numPixels,
+        [data](size_t begin, size_t end) {
+            // The filter output is uchar4, interpreted as int with the alpha channel dropped
+            for (size_t i = begin; i < end; ++i) {
+                data[i] = (data[i] & 0xFFFFFF) - 1;
+            }
+        }
+    );
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,36 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_AOV_DATA_CONVERSION_H
+#define HDRPR_AOV_DATA_CONVERSION_H
+
+#include "pxr/imaging/hd/types.h"
+#include "pxr/base/gf/vec4f.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Converts float4 framebuffer data into the format of the Hydra render buffer.
+/// Supports Float32, Float16 and UNorm8 component formats with any component count.
+/// UNorm8 values are clamped to [0, 1] and rounded to nearest, NaN is mapped to zero
+bool HdRprConvertFramebufferData(GfVec4f const* srcData, size_t numPixels, HdFormat format, void* dstBuffer);
+
+/// Decodes IDs from float4 framebuffer data. RPR stores an ID as a little endian int24 in the RGB channels
+/// (normalized to [0, 1]) and offsets it by one so that zero means no object
+void HdRprConvertPrimIdData(GfVec4f const* srcData, size_t numPixels, int* dstData);
+
+/// Decodes IDs in place from the uchar4 data of a RIF filter output
+void HdRprDecodePrimIdData(int* data, size_t numPixels);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_AOV_DATA_CONVERSION_H
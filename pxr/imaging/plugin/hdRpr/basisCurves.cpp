@@ -12,6 +12,7 @@ limitations under the License.
 ************************************************************************/
 
 #include "basisCurves.h"
+#include "curveSegments.h"
 #include "material.h"
 #include "renderParam.h"
 #include "primvarUtil.h"
@@ -19,6 +20,7 @@ limitations under the License.
 
 #include "pxr/imaging/rprUsd/material.h"
 #include "pxr/imaging/rprUsd/debugCodes.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -54,6 +56,8 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
                             HdRenderParam* renderParam,
                             HdDirtyBits* dirtyBits,
                             TfToken const& reprSelector) {
+    RprUsdTimelineZone zone("HdRprBasisCurves::Sync", GetId().GetText());
+
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
     auto rprApi = rprRenderParam->AcquireRprApiForEdit();
 
@@ -102,6 +106,7 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
     );
 
     bool isVisibilityMaskDirty = false;
+    bool displayColorChanged = false;
     if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
         HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, id, &primvarDescsPerInterpolation);
 
@@ -113,12 +118,38 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (HdRprIsPrimvarExists(*uvPrimvarName, primvarDescsPerInterpolation, &m_uvsInterpolation)) {
-            m_uvs = sceneDelegate->Get(id, *uvPrimvarName).Get<VtVec2fArray>();
-        } else {
-            m_uvs = VtVec2fArray();
+        VtVec2fArray uvs;
+        HdInterpolation uvsInterpolation = m_uvsInterpolation;
+        if (HdRprIsPrimvarExists(*uvPrimvarName, primvarDescsPerInterpolation, &uvsInterpolation)) {
+            uvs = sceneDelegate->Get(id, *uvPrimvarName).Get<VtVec2fArray>();
+        }
+
+        // Primvars that are not baked into the curve (e.g. geometry settings) do not require to recreate it
+        if (uvs != m_uvs || (!uvs.empty() && uvsInterpolation != m_uvsInterpolation)) {
+            m_uvs = uvs;
+            m_uvsInterpolation = uvsInterpolation;
+            newCurve = true;
+        }
+
+        // Display color is used by the fallback material when the curve has no material bound
+        GfVec3f displayColor(0.18f);
+        if (HdRprIsPrimvarExists(HdTokens->displayColor, primvarDescsPerInterpolation)) {
+            VtValue val = sceneDelegate->Get(id, HdTokens->displayColor);
+            if (!val.IsEmpty()) {
+                if (val.IsHolding<VtVec3fArray>()) {
+                    auto colors = val.UncheckedGet<VtVec3fArray>();
+                    if (!colors.empty()) {
+                        displayColor = colors[0];
+                    }
+                } else if (val.IsHolding<GfVec3f>()) {
+                    displayColor = val.UncheckedGet<GfVec3f>();
+                }
+            }
+        }
+        if (m_displayColor != displayColor) {
+            m_displayColor = displayColor;
+            displayColorChanged = true;
         }
-        newCurve = true;
 
         HdRprGeometrySettings geomSettings = {};
         geomSettings.visibilityMask = kVisibleAll;
@@ -132,7 +163,6 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
 
     if (*dirtyBits & HdChangeTracker::DirtyTransform) {
         m_transform = GfMatrix4f(sceneDelegate->GetTransform(id));
-        newCurve = true;
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
@@ -193,27 +223,21 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
     }
 
     if (m_rprCurve) {
-        if (newCurve || (*dirtyBits & HdChangeTracker::DirtyMaterialId)) {
-            if (material && material->GetRprMaterialObject()) {
+        bool hasMaterial = material && material->GetRprMaterialObject();
+        if (newCurve || (*dirtyBits & HdChangeTracker::DirtyMaterialId) ||
+            (displayColorChanged && !hasMaterial)) {
+            if (hasMaterial) {
                 rprApi->SetCurveMaterial(m_rprCurve, material->GetRprMaterialObject());
+
+                if (m_fallbackMaterial) {
+                    rprApi->Release(m_fallbackMaterial);
+                    m_fallbackMaterial = nullptr;
+                }
             } else {
-                GfVec3f color(0.18f);
-
-                if (HdRprIsPrimvarExists(HdTokens->displayColor, primvarDescsPerInterpolation)) {
-                    VtValue val = sceneDelegate->Get(id, HdTokens->displayColor);
-                    if (!val.IsEmpty()) {
-                        if (val.IsHolding<VtVec3fArray>()) {
-                            auto colors = val.UncheckedGet<VtVec3fArray>();
-                            if (!colors.empty()) {
-                                color = colors[0];
-                            }
-                        } else if (val.IsHolding<GfVec3f>()) {
-                            color = val.UncheckedGet<GfVec3f>();
-                        }
-                    }
+                if (m_fallbackMaterial) {
+                    rprApi->Release(m_fallbackMaterial);
                 }
-
-                m_fallbackMaterial = rprApi->CreateDiffuseMaterial(color);
+                m_fallbackMaterial = rprApi->CreateDiffuseMaterial(m_displayColor);
                 rprApi->SetCurveMaterial(m_rprCurve, m_fallbackMaterial);
 
                 if (RprUsdIsLeakCheckEnabled()) {
@@ -234,313 +258,44 @@ void HdRprBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
     *dirtyBits = HdChangeTracker::Clean;
 }
 
-static const int kRprNumPointsPerSegment = 4;
-
 rpr::Curve* HdRprBasisCurves::CreateLinearRprCurve(HdRprApi* rprApi) {
-    // Each segment of USD linear curves defined by two vertices
-    // For tapered curve we need to convert it to RPR representation:
-    //   4 vertices and 2 radiuses per segment
-    // For cylindrical curve we can leave indices data in the same format as in USD,
-    //   but we have to ensure that number of indices in each curve multiple of kRprNumPointsPerSegment
-
-    const bool periodic = m_topology.GetCurveWrap() == HdTokens->periodic;
-    const bool strip = periodic || m_topology.GetCurveWrap() == HdTokens->nonperiodic;
-    const bool isCurveTapered = m_widthsInterpolation != HdInterpolationConstant && m_widthsInterpolation != HdInterpolationUniform;
-
-    const int kNumPointsPerSegment = 2;
-    const int kVstep = strip ? 1 : 2;
-
-    VtIntArray rprIndices;
-    VtIntArray rprSegmentPerCurve;
-    VtFloatArray rprRadiuses;
-    VtVec2fArray rprUvs;
-
-    std::function<float(int, bool)> sampleTaperRadius;
-    if (isCurveTapered) {
-        if (m_widthsInterpolation == HdInterpolationVarying) {
-            sampleTaperRadius = [this](int iSegment, bool front) {
-                return 0.5f * m_widths[iSegment + (front ? 0 : 1)];
-            };
-        } else if (m_widthsInterpolation == HdInterpolationVertex) {
-            sampleTaperRadius = [=](int iSegment, bool front) {
-                return 0.5f * m_widths[iSegment * kVstep + (front ? 0 : (kNumPointsPerSegment - 1))];
-            };
-        }
-    }
-
-    std::function<int(int)> indexSampler;
-    if (m_indices.empty()) {
-        indexSampler = [](int idx) { return idx; };
-    } else {
-        indexSampler = [this](int idx) { return m_indices.cdata()[idx]; };
-    }
-
-    auto& curveCounts = m_topology.GetCurveVertexCounts();
-    rprSegmentPerCurve.reserve(curveCounts.size());
-
-    // Validate Hydra curve data and calculate amount of required memory.
-    //
-    size_t numRadiuses = 0;
-    size_t numIndices = 0;
-    int curveSegmentOffset = 0;
-    int curveIndicesOffset = 0;
-    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
-        auto numVertices = curveCounts[iCurve];
-        if (numVertices < 2) {
-            continue;
-        }
-
-        if (!strip && numVertices % 2 != 0) {
-            TF_RUNTIME_ERROR("[%s] corrupted curve data: segmented linear curve should contain even number of vertices", GetId().GetText());
-            return nullptr;
-        }
-
-        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
-        if (periodic) numSegments++;
-
-        if ((m_widthsInterpolation == HdInterpolationVarying && m_widths.size() < (curveSegmentOffset + numSegments)) ||
-            (m_widthsInterpolation == HdInterpolationVertex && m_widths.size() < (curveIndicesOffset + numVertices))) {
-            TF_RUNTIME_ERROR("[%s] corrupted curve data: insufficient amount of widths", GetId().GetText());
-            return nullptr;
-        }
-
-        if (isCurveTapered) {
-            numRadiuses += numSegments * 2;
-            numIndices += numSegments * 4;
-        } else {
-            if (m_widthsInterpolation == HdInterpolationUniform ||
-                m_widthsInterpolation == HdInterpolationConstant) {
-                ++numRadiuses;
-            }
-            numIndices += numSegments * 2;
-
-            // RPR requires curves to consist only of segments of kRprNumPointsPerSegment length
-            auto numPointsInCurve = (numVertices - 1) * 2;
-            auto numTrailingPoints = numPointsInCurve % kRprNumPointsPerSegment;
-            if (numTrailingPoints > 0) {
-                numIndices += kRprNumPointsPerSegment - numTrailingPoints;
-            }
-        }
-
-        curveSegmentOffset += numSegments;
-        curveIndicesOffset += numVertices;
-    }
-    rprRadiuses.reserve(numRadiuses);
-    rprIndices.reserve(numIndices);
-
-    // Convert Hydra curve data to RPR data.
-    //
-    curveIndicesOffset = 0;
-    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
-        auto numVertices = curveCounts[iCurve];
-        if (numVertices < 2) {
-            continue;
-        }
-
-        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
-        if (periodic) numSegments++;
-
-        if (isCurveTapered) {
-            rprSegmentPerCurve.push_back(numVertices - 1);
-            for (int iSegment = 0; iSegment < numSegments; ++iSegment) {
-                const int segmentIndicesOffset = iSegment * kVstep;
-
-                const int i0 = indexSampler(curveIndicesOffset + segmentIndicesOffset);
-                const int i1 = indexSampler(curveIndicesOffset + (segmentIndicesOffset + 1) % numVertices);
-
-                // Each 2 vertices of USD curve corresponds to 1 tapered RPR curve segment
-                rprIndices.push_back(i0);
-                rprIndices.push_back(i0);
-                rprIndices.push_back(i1);
-                rprIndices.push_back(i1);
-
-                // Each segment of tapered curve have 2 radiuses
-                rprRadiuses.push_back(sampleTaperRadius(iSegment, true));
-                rprRadiuses.push_back(sampleTaperRadius(iSegment, false));
-            }
-        } else {
-            for (int iSegment = 0; iSegment < numSegments; ++iSegment) {
-                const int segmentIndicesOffset = iSegment * kVstep;
-
-                rprIndices.push_back(indexSampler(curveIndicesOffset + segmentIndicesOffset));
-                rprIndices.push_back(indexSampler(curveIndicesOffset + (segmentIndicesOffset + 1) % numVertices));
-            }
-
-            // RPR requires curves to consist only of segments of kRprNumPointsPerSegment length
-            auto numPointsInCurve = (numVertices - 1) * 2;
-            auto extraPoints = numPointsInCurve % kRprNumPointsPerSegment;
-            if (extraPoints) {
-                extraPoints = kRprNumPointsPerSegment - extraPoints;
-
-                auto lastPointIndex = indexSampler(curveIndicesOffset + numVertices - 1);
-                for (int i = 0; i < extraPoints; ++i) {
-                    rprIndices.push_back(lastPointIndex);
-                }
-            }
-
-            // Each cylindrical curve must have 1 radius
-            if (m_widthsInterpolation == HdInterpolationUniform) {
-                rprRadiuses.push_back(m_widths[iCurve] * 0.5f);
-            } else if (m_widthsInterpolation == HdInterpolationConstant) {
-                rprRadiuses.push_back(m_widths[0] * 0.5f);
-            }
-
-            rprSegmentPerCurve.push_back((numPointsInCurve + extraPoints) / kRprNumPointsPerSegment);
-        }
-
-        curveIndicesOffset += numVertices;
+    HdRprCurveSegments segments;
+    std::string error;
+    if (!HdRprBuildLinearCurveSegments(m_topology, m_indices, m_widths, m_widthsInterpolation, &segments, &error)) {
+        TF_RUNTIME_ERROR("[%s] corrupted curve data: %s", GetId().GetText(), error.c_str());
+        return nullptr;
     }
 
+    VtVec2fArray rprUvs;
     if (!m_uvs.empty()) {
         if (m_uvsInterpolation == HdInterpolationUniform) {
             rprUvs = m_uvs;
         } else if (m_uvsInterpolation == HdInterpolationConstant) {
-            rprUvs = VtVec2fArray(rprSegmentPerCurve.size(), m_uvs[0]);
+            rprUvs = VtVec2fArray(segments.segmentPerCurve.size(), m_uvs[0]);
         }
     }
 
-    return rprApi->CreateCurve(m_points, rprIndices, rprRadiuses, rprUvs, rprSegmentPerCurve);
+    return rprApi->CreateCurve(m_points, segments.indices, segments.radiuses, rprUvs, segments.segmentPerCurve);
 }
 
 rpr::Curve* HdRprBasisCurves::CreateBezierRprCurve(HdRprApi* rprApi) {
-    if (m_topology.GetCurveWrap() == HdTokens->segmented) {
-        TF_RUNTIME_ERROR("[%s] corrupted curve data: bezier curve can not be of segmented wrap type", GetId().GetText());
+    HdRprCurveSegments segments;
+    std::string error;
+    if (!HdRprBuildBezierCurveSegments(m_topology, m_indices, m_widths, m_widthsInterpolation, &segments, &error)) {
+        TF_RUNTIME_ERROR("[%s] corrupted curve data: %s", GetId().GetText(), error.c_str());
         return nullptr;
     }
 
-    VtIntArray rprIndices;
-    VtIntArray rprSegmentPerCurve;
-    VtFloatArray rprRadiuses;
     VtVec2fArray rprUvs;
-
-    auto& curveCounts = m_topology.GetCurveVertexCounts();
-    rprSegmentPerCurve.reserve(curveCounts.size());
-
-    const int kNumPointsPerSegment = 4;
-    const int kVstep = 3;
-
-    const bool periodic = m_topology.GetCurveWrap() == HdTokens->periodic;
-    const bool isCurveTapered = m_widthsInterpolation != HdInterpolationConstant && m_widthsInterpolation != HdInterpolationUniform;
-
-    std::function<float(int, bool)> sampleTaperRadius;
-    if (isCurveTapered) {
-        if (m_widthsInterpolation == HdInterpolationVarying) {
-            sampleTaperRadius = [this](int iSegment, bool front) {
-                return 0.5f * m_widths[iSegment + (front ? 0 : 1)];
-            };
-        } else if (m_widthsInterpolation == HdInterpolationVertex) {
-            sampleTaperRadius = [=](int iSegment, bool front) {
-                return 0.5f * m_widths[iSegment * kVstep + (front ? 0 : (kNumPointsPerSegment - 1))];
-            };
-        }
-    }
-
-    std::function<int(int)> indexSampler;
-    if (m_indices.empty()) {
-        indexSampler = [](int idx) { return idx; };
-    } else {
-        indexSampler = [this](int idx) { return m_indices.cdata()[idx]; };
-    }
-
-    // Validate Hydra curve data and calculate amount of required memory.
-    //
-    size_t numRadiuses = 0;
-    size_t numIndices = 0;
-    int curveSegmentOffset = 0;
-    int curveIndicesOffset = 0;
-    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
-        auto numVertices = curveCounts[iCurve];
-        if (numVertices < kNumPointsPerSegment) {
-            continue;
-        }
-
-        // Validity check from the USD docs
-        if ((periodic && numVertices % kVstep != 0) ||
-            (!periodic && (numVertices - 4) % kVstep != 0)) {
-            TF_RUNTIME_ERROR("[%s] corrupted curve data: invalid topology", GetId().GetText());
-            return nullptr;
-        }
-
-        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
-        if (periodic) numSegments++;
-
-        if ((m_widthsInterpolation == HdInterpolationVarying && m_widths.size() < (curveSegmentOffset + numSegments)) ||
-            (m_widthsInterpolation == HdInterpolationVertex && m_widths.size() < (curveIndicesOffset + numVertices))) {
-            TF_RUNTIME_ERROR("[%s] corrupted curve data: insufficient amount of widths", GetId().GetText());
-            return nullptr;
-        }
-
-        numIndices += numSegments * kNumPointsPerSegment;
-        if (isCurveTapered) {
-            numRadiuses += numSegments * 2;
-        } else {
-            if (m_widthsInterpolation == HdInterpolationUniform ||
-                m_widthsInterpolation == HdInterpolationConstant) {
-                numRadiuses++;
-            }
-        }
-
-        curveSegmentOffset += numSegments;
-        curveIndicesOffset += numVertices;
-    }
-    rprRadiuses.reserve(numRadiuses);
-    rprIndices.reserve(numIndices);
-
-    // Convert Hydra curve data to RPR data.
-    //
-    curveIndicesOffset = 0;
-    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
-        auto numVertices = curveCounts[iCurve];
-        if (numVertices < kNumPointsPerSegment) {
-            continue;
-        }
-
-        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
-        if (periodic) numSegments++;
-
-        rprSegmentPerCurve.push_back(numSegments);
-
-        for (int iSegment = 0; iSegment < numSegments; ++iSegment) {
-            const int segmentIndicesOffset = iSegment * kVstep;
-
-            const int i0 = indexSampler(curveIndicesOffset + segmentIndicesOffset + 0);
-            const int i1 = indexSampler(curveIndicesOffset + segmentIndicesOffset + 1);
-            const int i2 = indexSampler(curveIndicesOffset + segmentIndicesOffset + 2);
-            const int i3 = indexSampler(curveIndicesOffset + (segmentIndicesOffset + 3) % numVertices);
-
-            rprIndices.push_back(i0);
-            rprIndices.push_back(i1);
-            rprIndices.push_back(i2);
-            rprIndices.push_back(i3);
-
-            if (isCurveTapered) {
-                // XXX: We consciously losing data here because RPR supports only two radius samples per segment
-                rprRadiuses.push_back(sampleTaperRadius(iSegment, true));
-                rprRadiuses.push_back(sampleTaperRadius(iSegment, false));
-            }
-        }
-
-        if (!isCurveTapered) {
-            // Each cylindrical curve must have 1 radius
-            if (m_widthsInterpolation == HdInterpolationUniform) {
-                rprRadiuses.push_back(m_widths[iCurve] * 0.5f);
-            } else if (m_widthsInterpolation == HdInterpolationConstant) {
-                rprRadiuses.push_back(m_widths[0] * 0.5f);
-            }
-        }
-
-        curveIndicesOffset += numVertices;
-    }
-
     if (!m_uvs.empty()) {
         if (m_uvsInterpolation == HdInterpolationUniform) {
             rprUvs = m_uvs;
         } else if (m_uvsInterpolation == HdInterpolationConstant) {
-            rprUvs = VtVec2fArray(rprSegmentPerCurve.size(), m_uvs[0]);
+            rprUvs = VtVec2fArray(segments.segmentPerCurve.size(), m_uvs[0]);
         }
     }
 
-    return rprApi->CreateCurve(m_points, rprIndices, rprRadiuses, rprUvs, rprSegmentPerCurve);
+    return rprApi->CreateCurve(m_points, segments.indices, segments.radiuses, rprUvs, segments.segmentPerCurve);
 }
 
 void HdRprBasisCurves::Finalize(HdRenderParam* renderParam) {
@@ -62,13 +62,14 @@ private:
     HdBasisCurvesTopology m_topology;
     VtIntArray m_indices;
     VtFloatArray m_widths;
-    HdInterpolation m_widthsInterpolation;
+    HdInterpolation m_widthsInterpolation = HdInterpolationConstant;
     VtVec2fArray m_uvs;
-    HdInterpolation m_uvsInterpolation;
+    HdInterpolation m_uvsInterpolation = HdInterpolationConstant;
     VtVec3fArray m_points;
     GfMatrix4f m_transform;
+    GfVec3f m_displayColor = GfVec3f(0.18f);
 
-    uint32_t m_visibilityMask;
+    uint32_t m_visibilityMask = kVisibleAll;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,323 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "curveSegments.h"
+
+#include "pxr/imaging/hd/tokens.h"
+#include "pxr/base/work/loops.h"
+
+#include <algorithm>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+const int kRprNumPointsPerSegment = 4;
+
+// Location of a Hydra curve in the source buffers and of its converted data in the RPR buffers
+struct CurveRange {
+    size_t curveIndex;
+    int numVertices;
+    int numSegments;
+    int hydraIndicesOffset;
+    // Width samples of tapered curves, one per vertex or one per varying value
+    int widthsOffset;
+    int numWidths;
+    size_t rprIndicesOffset;
+    size_t rprRadiusesOffset;
+};
+
+// RPR requires curves to consist only of segments of kRprNumPointsPerSegment length
+int GetNumPaddingIndices(int numIndices) {
+    return (kRprNumPointsPerSegment - numIndices % kRprNumPointsPerSegment) % kRprNumPointsPerSegment;
+}
+
+// Samples wrap around for periodic curves
+float SampleTaperRadius(float const* widths, CurveRange const& range, int iSample) {
+    return 0.5f * widths[range.widthsOffset + iSample % range.numWidths];
+}
+
+} // namespace anonymous
+
+bool HdRprBuildLinearCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtIntArray const& hydraIndicesArray,
+    VtFloatArray const& widthsArray,
+    HdInterpolation widthsInterpolation,
+    HdRprCurveSegments* segments,
+    std::string* error) {
+    // Each segment of USD linear curves defined by two vertices
+    // For tapered curve we need to convert it to RPR representation:
+    //   4 vertices and 2 radiuses per segment
+    // For cylindrical curve we can leave indices data in the same format as in USD,
+    //   but we have to ensure that number of indices in each curve multiple of kRprNumPointsPerSegment
+
+    const bool periodic = topology.GetCurveWrap() == HdTokens->periodic;
+    const bool strip = periodic || topology.GetCurveWrap() == HdTokens->nonperiodic;
+    const bool isCurveTapered = widthsInterpolation != HdInterpolationConstant && widthsInterpolation != HdInterpolationUniform;
+
+    const int kNumPointsPerSegment = 2;
+    const int kVstep = strip ? 1 : 2;
+
+    auto& curveCounts = topology.GetCurveVertexCounts();
+
+    // Validate Hydra curve data and compute the offsets of each curve in the RPR buffers.
+    //
+    std::vector<CurveRange> curveRanges;
+    curveRanges.reserve(curveCounts.size());
+
+    size_t numRadiuses = 0;
+    size_t numIndices = 0;
+    int curveIndicesOffset = 0;
+    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
+        auto numVertices = curveCounts[iCurve];
+        if (numVertices < 2) {
+            curveIndicesOffset += std::max(numVertices, 0);
+            continue;
+        }
+
+        if (!strip && numVertices % 2 != 0) {
+            *error = "segmented linear curve should contain even number of vertices";
+            return false;
+        }
+
+        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
+        if (periodic) numSegments++;
+
+        // Varying widths of linear curves are specified per vertex too
+        if ((isCurveTapered && widthsArray.size() < size_t(curveIndicesOffset + numVertices)) ||
+            (widthsInterpolation == HdInterpolationUniform && widthsArray.size() <= iCurve) ||
+            widthsArray.empty()) {
+            *error = "insufficient amount of widths";
+            return false;
+        }
+
+        curveRanges.push_back({iCurve, numVertices, numSegments, curveIndicesOffset, curveIndicesOffset, numVertices, numIndices, numRadiuses});
+
+        if (isCurveTapered) {
+            numRadiuses += numSegments * 2;
+            numIndices += numSegments * 4;
+        } else {
+            // Each cylindrical curve must have 1 radius
+            ++numRadiuses;
+            numIndices += numSegments * 2 + GetNumPaddingIndices(numSegments * 2);
+        }
+
+        curveIndicesOffset += numVertices;
+    }
+
+    segments->indices = VtIntArray(numIndices);
+    segments->segmentPerCurve = VtIntArray(curveRanges.size());
+    segments->radiuses = VtFloatArray(numRadiuses);
+
+    // Convert Hydra curve data to RPR data. Curves are independent of each other
+    // and write into their own ranges of the preallocated buffers.
+    //
+    const int* hydraIndices = hydraIndicesArray.empty() ? nullptr : hydraIndicesArray.cdata();
+    const float* widths = widthsArray.cdata();
+
+    auto sampleIndex = [hydraIndices](int idx) {
+        return hydraIndices ? hydraIndices[idx] : idx;
+    };
+
+    int* indicesData = segments->indices.data();
+    int* segmentPerCurveData = segments->segmentPerCurve.data();
+    float* radiusesData = segments->radiuses.data();
+
+    WorkParallelForN(curveRanges.size(),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& range = curveRanges[i];
+                int* indices = indicesData + range.rprIndicesOffset;
+                float* radiuses = radiusesData + range.rprRadiusesOffset;
+
+                if (isCurveTapered) {
+                    for (int iSegment = 0; iSegment < range.numSegments; ++iSegment) {
+                        const int segmentIndicesOffset = iSegment * kVstep;
+
+                        const int i0 = sampleIndex(range.hydraIndicesOffset + segmentIndicesOffset);
+                        const int i1 = sampleIndex(range.hydraIndicesOffset + (segmentIndicesOffset + 1) % range.numVertices);
+
+                        // Each 2 vertices of USD curve corresponds to 1 tapered RPR curve segment
+                        *indices++ = i0;
+                        *indices++ = i0;
+                        *indices++ = i1;
+                        *indices++ = i1;
+
+                        // Each segment of tapered curve have 2 radiuses
+                        *radiuses++ = SampleTaperRadius(widths, range, segmentIndicesOffset);
+                        *radiuses++ = SampleTaperRadius(widths, range, segmentIndicesOffset + 1);
+                    }
+
+                    segmentPerCurveData[i] = range.numSegments;
+                } else {
+                    for (int iSegment = 0; iSegment < range.numSegments; ++iSegment) {
+                        const int segmentIndicesOffset = iSegment * kVstep;
+
+                        *indices++ = sampleIndex(range.hydraIndicesOffset + segmentIndicesOffset);
+                        *indices++ = sampleIndex(range.hydraIndicesOffset + (segmentIndicesOffset + 1) % range.numVertices);
+                    }
+
+                    const int numCurveIndices = range.numSegments * 2;
+                    const int numPaddingIndices = GetNumPaddingIndices(numCurveIndices);
+                    std::fill_n(indices, numPaddingIndices, indices[-1]);
+
+                    if (widthsInterpolation == HdInterpolationUniform) {
+                        *radiuses = widths[range.curveIndex] * 0.5f;
+                    } else {
+                        *radiuses = widths[0] * 0.5f;
+                    }
+
+                    segmentPerCurveData[i] = (numCurveIndices + numPaddingIndices) / kRprNumPointsPerSegment;
+                }
+            }
+        });
+
+    return true;
+}
+
+bool HdRprBuildBezierCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtIntArray const& hydraIndicesArray,
+    VtFloatArray const& widthsArray,
+    HdInterpolation widthsInterpolation,
+    HdRprCurveSegments* segments,
+    std::string* error) {
+    if (topology.GetCurveWrap() == HdTokens->segmented) {
+        *error = "bezier curve can not be of segmented wrap type";
+        return false;
+    }
+
+    auto& curveCounts = topology.GetCurveVertexCounts();
+
+    const int kNumPointsPerSegment = 4;
+    const int kVstep = 3;
+
+    const bool periodic = topology.GetCurveWrap() == HdTokens->periodic;
+    const bool isCurveTapered = widthsInterpolation != HdInterpolationConstant && widthsInterpolation != HdInterpolationUniform;
+
+    // Validate Hydra curve data and compute the offsets of each curve in the RPR buffers.
+    //
+    std::vector<CurveRange> curveRanges;
+    curveRanges.reserve(curveCounts.size());
+
+    size_t numRadiuses = 0;
+    size_t numIndices = 0;
+    int curveVaryingOffset = 0;
+    int curveIndicesOffset = 0;
+    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
+        auto numVertices = curveCounts[iCurve];
+        if (numVertices < kNumPointsPerSegment) {
+            curveIndicesOffset += std::max(numVertices, 0);
+            continue;
+        }
+
+        // Validity check from the USD docs
+        if ((periodic && numVertices % kVstep != 0) ||
+            (!periodic && (numVertices - 4) % kVstep != 0)) {
+            *error = "invalid topology";
+            return false;
+        }
+
+        int numSegments = (numVertices - (kNumPointsPerSegment - kVstep)) / kVstep;
+        if (periodic) numSegments++;
+
+        // Varying values are specified at the segment ends, periodic curves share the first one
+        const int numVarying = periodic ? numSegments : numSegments + 1;
+        const bool isVarying = widthsInterpolation == HdInterpolationVarying;
+        const int widthsOffset = isVarying ? curveVaryingOffset : curveIndicesOffset;
+        const int numWidths = isVarying ? numVarying : numVertices;
+
+        if ((isCurveTapered && widthsArray.size() < size_t(widthsOffset + numWidths)) ||
+            (widthsInterpolation == HdInterpolationUniform && widthsArray.size() <= iCurve) ||
+            widthsArray.empty()) {
+            *error = "insufficient amount of widths";
+            return false;
+        }
+
+        curveRanges.push_back({iCurve, numVertices, numSegments, curveIndicesOffset, widthsOffset, numWidths, numIndices, numRadiuses});
+
+        numIndices += numSegments * kNumPointsPerSegment;
+        if (isCurveTapered) {
+            numRadiuses += numSegments * 2;
+        } else {
+            // Each cylindrical curve must have 1 radius
+            numRadiuses++;
+        }
+
+        curveVaryingOffset += numVarying;
+        curveIndicesOffset += numVertices;
+    }
+
+    segments->indices = VtIntArray(numIndices);
+    segments->segmentPerCurve = VtIntArray(curveRanges.size());
+    segments->radiuses = VtFloatArray(numRadiuses);
+
+    // Convert Hydra curve data to RPR data. Curves are independent of each other
+    // and write into their own ranges of the preallocated buffers.
+    //
+    const int* hydraIndices = hydraIndicesArray.empty() ? nullptr : hydraIndicesArray.cdata();
+    const float* widths = widthsArray.cdata();
+
+    auto sampleIndex = [hydraIndices](int idx) {
+        return hydraIndices ? hydraIndices[idx] : idx;
+    };
+
+    int* indicesData = segments->indices.data();
+    int* segmentPerCurveData = segments->segmentPerCurve.data();
+    float* radiusesData = segments->radiuses.data();
+
+    WorkParallelForN(curveRanges.size(),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& range = curveRanges[i];
+                int* indices = indicesData + range.rprIndicesOffset;
+                float* radiuses = radiusesData + range.rprRadiusesOffset;
+
+                for (int iSegment = 0; iSegment < range.numSegments; ++iSegment) {
+                    const int segmentIndicesOffset = iSegment * kVstep;
+
+                    *indices++ = sampleIndex(range.hydraIndicesOffset + segmentIndicesOffset + 0);
+                    *indices++ = sampleIndex(range.hydraIndicesOffset + segmentIndicesOffset + 1);
+                    *indices++ = sampleIndex(range.hydraIndicesOffset + segmentIndicesOffset + 2);
+                    *indices++ = sampleIndex(range.hydraIndicesOffset + (segmentIndicesOffset + 3) % range.numVertices);
+
+                    if (isCurveTapered) {
+                        // XXX: We consciously losing data here because RPR supports only two radius samples per segment
+                        if (widthsInterpolation == HdInterpolationVarying) {
+                            *radiuses++ = SampleTaperRadius(widths, range, iSegment);
+                            *radiuses++ = SampleTaperRadius(widths, range, iSegment + 1);
+                        } else {
+                            *radiuses++ = SampleTaperRadius(widths, range, segmentIndicesOffset);
+                            *radiuses++ = SampleTaperRadius(widths, range, segmentIndicesOffset + 3);
+                        }
+                    }
+                }
+
+                if (!isCurveTapered) {
+                    if (widthsInterpolation == HdInterpolationUniform) {
+                        *radiuses = widths[range.curveIndex] * 0.5f;
+                    } else {
+                        *radiuses = widths[0] * 0.5f;
+                    }
+                }
+
+                segmentPerCurveData[i] = range.numSegments;
+            }
+        });
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,57 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_CURVE_SEGMENTS_H
+#define HDRPR_CURVE_SEGMENTS_H
+
+#include "pxr/imaging/hd/basisCurvesTopology.h"
+#include "pxr/imaging/hd/enums.h"
+#include "pxr/base/vt/array.h"
+
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Curve data in the layout of rpr::Curve: each segment consists of 4 control point indices
+struct HdRprCurveSegments {
+    VtIntArray indices;
+    /// One radius per curve for cylindrical curves, two radiuses per segment for tapered curves
+    VtFloatArray radiuses;
+    VtIntArray segmentPerCurve;
+};
+
+/// Converts Hydra linear curves into RPR curve segments. Curves are converted in parallel,
+/// each one writes into its own range of the output buffers computed from the prefix sums of segment counts.
+/// Curves with less than 2 vertices are skipped.
+/// Returns false and describes the problem in \p error when the curve data is corrupted
+bool HdRprBuildLinearCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtIntArray const& indices,
+    VtFloatArray const& widths,
+    HdInterpolation widthsInterpolation,
+    HdRprCurveSegments* segments,
+    std::string* error);
+
+/// Converts Hydra cubic bezier curves into RPR curve segments the same way as HdRprBuildLinearCurveSegments.
+/// Curves with less than 4 vertices are skipped
+bool HdRprBuildBezierCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtIntArray const& indices,
+    VtFloatArray const& widths,
+    HdInterpolation widthsInterpolation,
+    HdRprCurveSegments* segments,
+    std::string* error);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_CURVE_SEGMENTS_H
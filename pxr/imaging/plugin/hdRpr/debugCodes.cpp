@@ -21,6 +21,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 TF_REGISTRY_FUNCTION(TfDebug) {
     TF_DEBUG_ENVIRONMENT_SYMBOL(HD_RPR_DEBUG_CONTEXT_CREATION, "hdRpr context creation");
     TF_DEBUG_ENVIRONMENT_SYMBOL(HD_RPR_DEBUG_CORE_UNSUPPORTED_ERROR, "hdRpr signal about unsupported errors");
+    TF_DEBUG_ENVIRONMENT_SYMBOL(HD_RPR_DEBUG_VDB_CACHE, "hdRpr .vdb grid cache");
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -21,7 +21,8 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DEBUG_CODES(
     HD_RPR_DEBUG_CONTEXT_CREATION,
-    HD_RPR_DEBUG_CORE_UNSUPPORTED_ERROR
+    HD_RPR_DEBUG_CORE_UNSUPPORTED_ERROR,
+    HD_RPR_DEBUG_VDB_CACHE
 );
 
 PXR_NAMESPACE_CLOSE_SCOPE
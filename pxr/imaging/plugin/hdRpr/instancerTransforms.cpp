@@ -0,0 +1,313 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "instancerTransforms.h"
+
+#include "pxr/base/gf/quatd.h"
+#include "pxr/base/gf/quatf.h"
+#include "pxr/base/gf/quath.h"
+#include "pxr/base/gf/rotation.h"
+#include "pxr/base/gf/matrix4f.h"
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/gf/vec3h.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/work/loops.h"
+
+#include <functional>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Helper to accumulate sample times from the largest set of
+// samples seen, up to maxNumSamples.
+template <typename T1, typename T2, unsigned int C>
+void AccumulateSampleTimes(HdTimeSampleArray<T1, C> const& in, HdTimeSampleArray<T2, C> *out) {
+    if (in.count > out->count) {
+        out->Resize(in.count);
+        out->times = in.times;
+    }
+}
+
+// Applies transforms of one primvar to a range of instances
+using TransformApplier = std::function<void(size_t begin, size_t end, GfMatrix4d* transforms)>;
+
+// Apply transforms referenced by instanceIndices
+template <typename Op, typename T>
+TransformApplier GetTransformApplier(
+    VtValue const& allTransformsValue,
+    VtIntArray const& instanceIndices) {
+    auto& allTransforms = allTransformsValue.Get<VtArray<T>>();
+    if (allTransforms.empty()) {
+        TF_RUNTIME_ERROR("No transforms");
+        return {};
+    }
+
+    return [&allTransforms, &instanceIndices](size_t begin, size_t end, GfMatrix4d* transforms) {
+        for (size_t i = begin; i < end; ++i) {
+            Op::Apply(allTransforms[instanceIndices[i]], &transforms[i]);
+        }
+    };
+}
+
+// Apply interpolated transforms referenced by instanceIndices
+template <typename Op, typename T>
+TransformApplier GetTransformApplier(
+    float alpha,
+    VtValue const& allTransformsValue0,
+    VtValue const& allTransformsValue1,
+    VtIntArray const& instanceIndices) {
+    auto& allTransforms0 = allTransformsValue0.Get<VtArray<T>>();
+    auto& allTransforms1 = allTransformsValue1.Get<VtArray<T>>();
+    if (allTransforms0.empty() ||
+        allTransforms1.empty()) {
+        TF_RUNTIME_ERROR("No transforms");
+        return {};
+    }
+
+    return [alpha, &allTransforms0, &allTransforms1, &instanceIndices](size_t begin, size_t end, GfMatrix4d* transforms) {
+        for (size_t i = begin; i < end; ++i) {
+            auto transform = HdResampleNeighbors(alpha, allTransforms0[instanceIndices[i]], allTransforms1[instanceIndices[i]]);
+            Op::Apply(transform, &transforms[i]);
+        }
+    };
+}
+
+template <typename Op, typename T>
+TransformApplier GetTransformApplier(
+    HdTimeSampleArray<VtValue, 2> const& samples,
+    VtIntArray const& instanceIndices,
+    float time) {
+
+    size_t i = 0;
+    for (; i < samples.count; ++i) {
+        if (samples.times[i] == time) {
+            // Exact time match
+            return GetTransformApplier<Op, T>(samples.values[i], instanceIndices);
+        }
+        if (samples.times[i] > time) {
+            break;
+        }
+    }
+
+    if (i == 0) {
+        // time is before the first sample.
+        return GetTransformApplier<Op, T>(samples.values[0], instanceIndices);
+    } else if (i == samples.count) {
+        // time is after the last sample.
+        return GetTransformApplier<Op, T>(samples.values[samples.count - 1], instanceIndices);
+    } else if (samples.times[i] == samples.times[i - 1]) {
+        // Neighboring samples have identical parameter.
+        // Arbitrarily choose a sample.
+        TF_WARN("overlapping samples at %f; using first sample", samples.times[i]);
+        return GetTransformApplier<Op, T>(samples.values[i - 1], instanceIndices);
+    } else {
+        // Linear blend of neighboring samples.
+        float alpha = (time - samples.times[i - 1]) / (samples.times[i] - samples.times[i - 1]);
+        return GetTransformApplier<Op, T>(alpha, samples.values[i - 1], samples.values[i], instanceIndices);
+    }
+}
+
+// Ops premultiply the instance transform: transform = Op(value) * transform.
+// Translate and scale touch only the affected rows instead of doing full matrix multiplication
+
+struct TranslateOp {
+    template <typename T>
+    static void Apply(T const& translate, GfMatrix4d* transform) {
+        GfVec3d t(translate);
+        auto m = transform->GetArray();
+        for (int i = 0; i < 4; ++i) {
+            m[12 + i] += t[0] * m[i] + t[1] * m[4 + i] + t[2] * m[8 + i];
+        }
+    }
+};
+
+struct RotateOp {
+    template <typename T>
+    static void Apply(T const& rotate, GfMatrix4d* transform) {
+        *transform = GfMatrix4d(1).SetRotate(GfRotation(GfQuatd(rotate))) * *transform;
+    }
+};
+
+struct ScaleOp {
+    template <typename T>
+    static void Apply(T const& scale, GfMatrix4d* transform) {
+        GfVec3d s(scale);
+        auto m = transform->GetArray();
+        for (int i = 0; i < 4; ++i) {
+            m[i] *= s[0];
+            m[4 + i] *= s[1];
+            m[8 + i] *= s[2];
+        }
+    }
+};
+
+struct TransformOp {
+    static void Apply(GfMatrix4d const& instanceTransform, GfMatrix4d* transform) {
+        *transform = instanceTransform * *transform;
+    }
+
+    static void Apply(GfMatrix4f const& instanceTransform, GfMatrix4d* transform) {
+        *transform = GfMatrix4d(instanceTransform) * *transform;
+    }
+};
+
+// Returns the sample at the given time avoiding a copy when there is an exact match
+VtMatrix4dArray const& GetSample(HdTimeSampleArray<VtMatrix4dArray, 2> const& samples, float time, VtMatrix4dArray* resampled) {
+    for (size_t i = 0; i < samples.count; ++i) {
+        if (samples.times[i] == time) {
+            return samples.values[i];
+        }
+    }
+
+    *resampled = samples.Resample(time);
+    return *resampled;
+}
+
+} // namespace anonymous
+
+HdTimeSampleArray<VtMatrix4dArray, 2> HdRprComputeInstanceTransforms(
+    VtIntArray const& instanceIndices,
+    HdTimeSampleArray<GfMatrix4d, 2> const& instancerXform,
+    HdTimeSampleArray<VtValue, 2> const& instanceXforms,
+    HdTimeSampleArray<VtValue, 2> const& translates,
+    HdTimeSampleArray<VtValue, 2> const& rotates,
+    HdTimeSampleArray<VtValue, 2> const& scales) {
+    // As a simple resampling strategy, find the input with the max #
+    // of samples and use its sample placement.  In practice we expect
+    // them to all be the same, i.e. to not require resampling.
+    HdTimeSampleArray<VtMatrix4dArray, 2> sa;
+    sa.Resize(0);
+    AccumulateSampleTimes(instancerXform, &sa);
+    AccumulateSampleTimes(instanceXforms, &sa);
+    AccumulateSampleTimes(translates, &sa);
+    AccumulateSampleTimes(scales, &sa);
+    AccumulateSampleTimes(rotates, &sa);
+
+    for (size_t i = 0; i < sa.count; ++i) {
+        const float t = sa.times[i];
+
+        GfMatrix4d xf(1);
+        if (instancerXform.count > 0) {
+            xf = instancerXform.Resample(t);
+        }
+
+        // The order of appliers defines the order of transformations: translate, rotate, scale, instanceTransform
+        TransformApplier appliers[4];
+
+        if (translates.count > 0 && translates.values[0].IsArrayValued()) {
+            auto& type = translates.values[0].GetElementTypeid();
+            if (type == typeid(GfVec3f)) {
+                appliers[0] = GetTransformApplier<TranslateOp, GfVec3f>(translates, instanceIndices, t);
+            } else if (type == typeid(GfVec3d)) {
+                appliers[0] = GetTransformApplier<TranslateOp, GfVec3d>(translates, instanceIndices, t);
+            } else if (type == typeid(GfVec3h)) {
+                appliers[0] = GetTransformApplier<TranslateOp, GfVec3h>(translates, instanceIndices, t);
+            }
+        }
+
+        if (rotates.count > 0 && rotates.values[0].IsArrayValued()) {
+            auto& type = rotates.values[0].GetElementTypeid();
+            if (type == typeid(GfQuath)) {
+                appliers[1] = GetTransformApplier<RotateOp, GfQuath>(rotates, instanceIndices, t);
+            } else if (type == typeid(GfQuatf)) {
+                appliers[1] = GetTransformApplier<RotateOp, GfQuatf>(rotates, instanceIndices, t);
+            } else if (type == typeid(GfQuatd)) {
+                appliers[1] = GetTransformApplier<RotateOp, GfQuatd>(rotates, instanceIndices, t);
+            }
+        }
+
+        if (scales.count > 0 && scales.values[0].IsArrayValued()) {
+            auto& type = scales.values[0].GetElementTypeid();
+            if (type == typeid(GfVec3f)) {
+                appliers[2] = GetTransformApplier<ScaleOp, GfVec3f>(scales, instanceIndices, t);
+            } else if (type == typeid(GfVec3d)) {
+                appliers[2] = GetTransformApplier<ScaleOp, GfVec3d>(scales, instanceIndices, t);
+            } else if (type == typeid(GfVec3h)) {
+                appliers[2] = GetTransformApplier<ScaleOp, GfVec3h>(scales, instanceIndices, t);
+            }
+        }
+
+        if (instanceXforms.count > 0 && instanceXforms.values[0].IsArrayValued()) {
+            auto& type = instanceXforms.values[0].GetElementTypeid();
+            if (type == typeid(GfMatrix4d)) {
+                appliers[3] = GetTransformApplier<TransformOp, GfMatrix4d>(instanceXforms, instanceIndices, t);
+            } else if (type == typeid(GfMatrix4f)) {
+                appliers[3] = GetTransformApplier<TransformOp, GfMatrix4f>(instanceXforms, instanceIndices, t);
+            }
+        }
+
+        auto& transforms = sa.values[i];
+        transforms = VtMatrix4dArray(instanceIndices.size(), xf);
+
+        // Each chunk of instances goes through all primvars while it's still in the cache
+        GfMatrix4d* transformsData = transforms.data();
+        WorkParallelForN(instanceIndices.size(),
+            [&appliers, transformsData](size_t begin, size_t end) {
+                for (auto& applier : appliers) {
+                    if (applier) {
+                        applier(begin, end, transformsData);
+                    }
+                }
+            }
+        );
+    }
+
+    return sa;
+}
+
+HdTimeSampleArray<VtMatrix4dArray, 2> HdRprFlattenInstanceTransforms(
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf,
+    HdTimeSampleArray<VtMatrix4dArray, 2> const& parentXf) {
+    HdTimeSampleArray<VtMatrix4dArray, 2> sa;
+    sa.Resize(0);
+    // Merge sample times, taking the densest sampling.
+    AccumulateSampleTimes(childXf, &sa);
+    AccumulateSampleTimes(parentXf, &sa);
+    // Apply parent xforms to the children.
+    for (size_t i = 0; i < sa.count; ++i) {
+        const float t = sa.times[i];
+        // Resample transforms at the same time.
+        VtMatrix4dArray resampledParentXf;
+        VtMatrix4dArray resampledChildXf;
+        VtMatrix4dArray const& curParentXf = GetSample(parentXf, t, &resampledParentXf);
+        VtMatrix4dArray const& curChildXf = GetSample(childXf, t, &resampledChildXf);
+
+        // Multiply out each combination.
+        // The result is allocated once and filled in parallel chunks of the flattened index
+        size_t numChildren = curChildXf.size();
+        VtMatrix4dArray result(curParentXf.size() * numChildren);
+        GfMatrix4d* resultData = result.data();
+        GfMatrix4d const* parentData = curParentXf.cdata();
+        GfMatrix4d const* childData = curChildXf.cdata();
+        WorkParallelForN(result.size(),
+            [resultData, parentData, childData, numChildren](size_t begin, size_t end) {
+                size_t j = begin / numChildren;
+                size_t k = begin % numChildren;
+                for (size_t idx = begin; idx < end; ++idx) {
+                    resultData[idx] = childData[k] * parentData[j];
+                    if (++k == numChildren) {
+                        k = 0;
+                        ++j;
+                    }
+                }
+            }
+        );
+        sa.values[i] = std::move(result);
+    }
+
+    return sa;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
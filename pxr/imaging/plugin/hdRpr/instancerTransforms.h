@@ -0,0 +1,42 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_INSTANCER_TRANSFORMS_H
+#define HDRPR_INSTANCER_TRANSFORMS_H
+
+#include "pxr/imaging/hd/timeSampleArray.h"
+
+#include "pxr/base/vt/array.h"
+#include "pxr/base/vt/value.h"
+#include "pxr/base/gf/matrix4d.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Computes transforms of the instances referenced by instanceIndices from the sampled instancer primvars.
+/// Transforms are applied in order: instancerXform, translate, rotate, scale, instanceTransform
+HdTimeSampleArray<VtMatrix4dArray, 2> HdRprComputeInstanceTransforms(
+    VtIntArray const& instanceIndices,
+    HdTimeSampleArray<GfMatrix4d, 2> const& instancerXform,
+    HdTimeSampleArray<VtValue, 2> const& instanceXforms,
+    HdTimeSampleArray<VtValue, 2> const& translates,
+    HdTimeSampleArray<VtValue, 2> const& rotates,
+    HdTimeSampleArray<VtValue, 2> const& scales);
+
+/// Multiplies out each combination of child instance transforms and the transforms of the parent instancer
+HdTimeSampleArray<VtMatrix4dArray, 2> HdRprFlattenInstanceTransforms(
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf,
+    HdTimeSampleArray<VtMatrix4dArray, 2> const& parentXf);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_INSTANCER_TRANSFORMS_H
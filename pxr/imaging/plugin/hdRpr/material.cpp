@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "material.h"
 #include "pxr/imaging/rprUsd/materialNodes/rpr/materialXNode.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 #include "pxr/usd/sdf/assetPath.h"
 #include "pxr/imaging/hd/sceneDelegate.h"
 
@@ -28,6 +29,7 @@ HdRprMaterial::HdRprMaterial(SdfPath const& id) : HdMaterial(id) {
 void HdRprMaterial::Sync(HdSceneDelegate* sceneDelegate,
                          HdRenderParam* renderParam,
                          HdDirtyBits* dirtyBits) {
+    RprUsdTimelineZone zone("HdRprMaterial::Sync", GetId().GetText());
 
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
     auto rprApi = rprRenderParam->AcquireRprApiForEdit();
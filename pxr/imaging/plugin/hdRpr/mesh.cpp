@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "pxr/imaging/rprUsd/material.h"
 #include "pxr/imaging/rprUsd/debugCodes.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 
 #include "pxr/imaging/pxOsd/tokens.h"
 #include "pxr/imaging/pxOsd/subdivTags.h"
@@ -31,9 +32,37 @@ limitations under the License.
 
 #include "pxr/base/gf/matrix4f.h"
 #include "pxr/base/gf/vec4f.h"
+#include "pxr/base/tf/envSetting.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_ENV_SETTING(HDRPR_PER_FACE_MATERIALS, true,
+    "Assign geomSubset materials per face of a single shape instead of splitting the mesh into a shape per geomSubset, when the plugin supports it");
+
+namespace {
+
+template <typename T>
+VtArray<VtArray<T>> GatherSubsetSamples(VtArray<VtArray<T>> const& samples, VtIntArray const& sourceIndices) {
+    VtArray<VtArray<T>> subsetSamples(samples.size());
+    for (size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex) {
+        auto const& sourceValues = samples.cdata()[sampleIndex];
+
+        VtArray<T> values(sourceIndices.size());
+        auto valuesData = values.data();
+        for (size_t i = 0; i < sourceIndices.size(); ++i) {
+            int sourceIndex = sourceIndices.cdata()[i];
+            if (sourceIndex < 0 || size_t(sourceIndex) >= sourceValues.size()) {
+                return {};
+            }
+            valuesData[i] = sourceValues.cdata()[sourceIndex];
+        }
+        subsetSamples[sampleIndex] = std::move(values);
+    }
+    return subsetSamples;
+}
+
+} // namespace anonymous
+
 HdRprMesh::HdRprMesh(SdfPath const& id HDRPR_INSTANCER_ID_ARG_DECL)
     : HdRprBaseRprim(id HDRPR_INSTANCER_ID_ARG) {
 
@@ -121,6 +150,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                      TfToken const& reprName) {
     HD_TRACE_FUNCTION();
     HF_MALLOC_TAG_FUNCTION();
+    RprUsdTimelineZone zone("HdRprMesh::Sync", GetId().GetText());
 
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
     auto rprApi = rprRenderParam->AcquireRprApiForEdit();
@@ -132,6 +162,10 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
 
     bool newMesh = false;
 
+    // Vertex data may be updated without the topology being changed.
+    // In such case, the mesh is recreated from the already prepared topology
+    bool isVertexDataDirty = false;
+
     std::map<HdInterpolation, HdPrimvarDescriptorVector> primvarDescsPerInterpolation;
 
     bool isRefineLevelDirty = false;
@@ -219,7 +253,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                     m_normalsValid = false;
                     pointsIsComputed = true;
 
-                    newMesh = true;
+                    isVertexDataDirty = true;
                 }
             }
 #else // PXR_VERSION < 2105
@@ -233,7 +267,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                 m_normalsValid = false;
                 pointsIsComputed = true;
 
-                newMesh = true;
+                isVertexDataDirty = true;
             }
 #endif // PXR_VERSION >= 2105
         }
@@ -248,7 +282,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
         }
 
         m_normalsValid = false;
-        newMesh = true;
+        isVertexDataDirty = true;
     }
 
     if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
@@ -339,16 +373,23 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
         HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, id, &primvarDescsPerInterpolation);
         HdInterpolation interpolation;
         m_authoredNormals = HdRprSamplePrimvar(id, HdTokens->normals, sceneDelegate, primvarDescsPerInterpolation, m_numGeometrySamples, &m_normalSamples, &interpolation);
+        VtIntArray normalIndices;
         if (m_authoredNormals) {
-            HdRprGetPrimvarIndices(interpolation, m_faceVertexIndices, &m_normalIndices);
+            HdRprGetPrimvarIndices(interpolation, m_faceVertexIndices, &normalIndices);
         } else {
             m_normalSamples.clear();
-            m_normalIndices.clear();
         }
 
-        newMesh = true;
+        // Normal indices are a part of the topology prepared for RPR
+        if (normalIndices != m_normalIndices) {
+            m_normalIndices = std::move(normalIndices);
+            newMesh = true;
+        }
+
+        isVertexDataDirty = true;
     }
 
+    bool isVertexColorDirty = false;
     if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->displayColor)) {
         HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, id, &primvarDescsPerInterpolation);
         m_authoredColors = HdRprSamplePrimvar(id, HdTokens->displayColor, sceneDelegate, primvarDescsPerInterpolation, m_numGeometrySamples, &m_colorSamples, &m_colorInterpolation);
@@ -356,8 +397,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             m_colorSamples.clear();
         }
 
-        newMesh = true;
-        m_colorsSet = false;
+        isVertexColorDirty = true;
     }
 
     if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->displayOpacity)) {
@@ -367,8 +407,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             m_opacitySamples.clear();
         }
 
-        newMesh = true;
-        m_opacitySet = false;
+        isVertexColorDirty = true;
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
@@ -397,6 +436,18 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
 		return material;
 	};
 
+    auto getSubsetMaterial = [sceneDelegate, &getPerFaceMeshMaterial](SdfPath const& materialId) -> const HdRprMaterial* {
+        if (materialId.IsEmpty()) {
+            return nullptr;
+        }
+        auto material = static_cast<const HdRprMaterial*>(sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, materialId));
+        if (!material) {
+            // geomSubset may have only relative material path. Relative to mesh.
+            material = getPerFaceMeshMaterial(materialId);
+        }
+        return material;
+    };
+
     // Check all materials, including those from geomSubsets
     if (!material || !material->GetRprMaterialObject()) {
         for (auto& subset : m_geomSubsets) {
@@ -444,14 +495,19 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, id, &primvarDescsPerInterpolation);
 
             HdInterpolation interpolation;
+            VtIntArray uvIndices;
             if (HdRprSamplePrimvar(id, *uvPrimvarName, sceneDelegate, primvarDescsPerInterpolation, m_numGeometrySamples, &m_uvSamples, &interpolation)) {
-                HdRprGetPrimvarIndices(interpolation, m_faceVertexIndices, &m_uvIndices);
+                HdRprGetPrimvarIndices(interpolation, m_faceVertexIndices, &uvIndices);
             } else {
                 m_uvSamples.clear();
-                m_uvIndices.clear();
             }
 
-            newMesh = true;
+            if (uvIndices != m_uvIndices) {
+                m_uvIndices = std::move(uvIndices);
+                newMesh = true;
+            }
+
+            isVertexDataDirty = true;
         }
     }
 
@@ -477,11 +533,11 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
             m_normalsValid = true;
 
-            newMesh = true;
+            isVertexDataDirty = true;
         }
     }
 
-    bool updateTransform = newMesh;
+    bool updateTransform = false;
     if (*dirtyBits & HdChangeTracker::DirtyTransform) {
         sceneDelegate->SampleTransform(id, &m_transformSamples);
         updateTransform = true;
@@ -490,20 +546,106 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
     ////////////////////////////////////////////////////////////////////////
     // 3. Create RPR meshes
 
+    // Keep a mesh with geomSubsets as a single shape and bind subset materials per face when possible.
+    // Per-shape material properties (displacement, volume, catchers) can not be bound per face,
+    // meshes with such subset materials are split into a shape per subset
+    bool usePerFaceMaterials = !m_geomSubsets.empty() && TfGetEnvSetting(HDRPR_PER_FACE_MATERIALS) &&
+        rprApi->IsPerFaceMaterialSupported();
+    for (size_t i = 0; i < m_geomSubsets.size() && usePerFaceMaterials; ++i) {
+        auto& subset = m_geomSubsets[i];
+        if (subset.type != HdGeomSubset::TypeFaceSet) {
+            usePerFaceMaterials = false;
+        } else if (auto subsetMaterial = getSubsetMaterial(subset.materialId)) {
+            auto rprMaterial = subsetMaterial->GetRprMaterialObject();
+            usePerFaceMaterials = !rprMaterial || rprMaterial->CanAttachToFaces();
+        }
+    }
+    if (!newMesh && !m_geomSubsets.empty() && usePerFaceMaterials != m_usePerFaceMaterials) {
+        newMesh = true;
+    }
+
+    // Subdivision, displacement and vertex colors are properties of RPR geometry,
+    // meshes that use them get their own geometry instead of sharing it with identical meshes
+    bool canShareGeometry = m_refineLevel == 0 && m_colorSamples.empty() && m_opacitySamples.empty() &&
+        m_geomSubsets.empty() && !IsDisplacementUsed(sceneDelegate);
+    if (!newMesh && m_isGeometryShared && !canShareGeometry) {
+        // The mesh diverges from the geometry it shares, it needs its own copy
+        newMesh = true;
+    }
+
+    if (!newMesh && (isVertexDataDirty || isVertexColorDirty)) {
+        // Fast path is possible only when all meshes were created from the prepared topology
+        if (m_rprMeshes.empty() || m_rprMeshTopologies.size() != m_rprMeshes.size()) {
+            newMesh = true;
+        }
+    }
+
+    auto setMeshVertexColor = [this, &rprApi](rpr::Shape* rprMesh, RprMeshTopology const& meshTopology) {
+        if (!IsSplitByGeomSubsets()) {
+            m_colorsSet = rprApi->SetMeshVertexColor(rprMesh, m_colorSamples, m_colorInterpolation);
+            m_opacitySet = rprApi->SetMeshVertexOpacity(rprMesh, m_opacitySamples, m_opacityInterpolation);
+        } else {
+            auto subsetColorSamples = GatherSubsetSamples(m_colorSamples, meshTopology.pointIndices);
+            if (subsetColorSamples.empty() && !m_colorSamples.empty()) {
+                TF_WARN("Vertex index does not match displayColor primvar size");
+            }
+            auto subsetOpacitySamples = GatherSubsetSamples(m_opacitySamples, meshTopology.pointIndices);
+            if (subsetOpacitySamples.empty() && !m_opacitySamples.empty()) {
+                TF_WARN("Vertex index does not match displayOpacity primvar size");
+            }
+
+            m_colorsSet = rprApi->SetMeshVertexColor(rprMesh, subsetColorSamples, m_colorInterpolation);
+            m_opacitySet = rprApi->SetMeshVertexOpacity(rprMesh, subsetOpacitySamples, m_opacityInterpolation);
+        }
+    };
+
+    auto createMesh = [&rprApi, canShareGeometry](VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples,
+                                                VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology) {
+        return canShareGeometry ?
+            rprApi->CreateSharedMesh(pointSamples, normalSamples, uvSamples, topology) :
+            rprApi->CreateMesh(pointSamples, normalSamples, uvSamples, topology);
+    };
+
+    auto createRprMesh = [this, &createMesh, &setMeshVertexColor](RprMeshTopology const& meshTopology) {
+        rpr::Shape* rprMesh;
+        if (!IsSplitByGeomSubsets()) {
+            rprMesh = createMesh(m_pointSamples, m_normalSamples, m_uvSamples, meshTopology.topology);
+        } else {
+            auto& normalIndices = m_normalIndices.empty() ? meshTopology.pointIndices : meshTopology.normalIndices;
+            auto& uvIndices = m_uvIndices.empty() ? meshTopology.pointIndices : meshTopology.uvIndices;
+            rprMesh = createMesh(
+                GatherSubsetSamples(m_pointSamples, meshTopology.pointIndices),
+                GatherSubsetSamples(m_normalSamples, normalIndices),
+                GatherSubsetSamples(m_uvSamples, uvIndices),
+                meshTopology.topology);
+        }
+
+        if (rprMesh) {
+            setMeshVertexColor(rprMesh, meshTopology);
+        }
+        return rprMesh;
+    };
+
+    bool colorsSet = m_colorsSet;
+    bool opacitySet = m_opacitySet;
+
     if (newMesh) {
         for (auto mesh : m_rprMeshes) {
             rprApi->Release(mesh);
         }
         ReleaseInstances(rprApi);
         m_rprMeshes.clear();
+        m_rprMeshTopologies.clear();
+        m_usePerFaceMaterials = usePerFaceMaterials;
 
-        if (m_geomSubsets.empty()) {
+        if (!IsSplitByGeomSubsets()) {
             // HybridPro will return non-nullptr mesh even in case if points are empty, it will lead to crash subsequently, so let's avoid mesh creation in case if there no vertices present.
             if (m_pointSamples.size() > 0) {
-                if (auto rprMesh = rprApi->CreateMesh(m_pointSamples, m_faceVertexIndices, m_normalSamples, m_normalIndices, m_uvSamples, m_uvIndices, m_faceVertexCounts, m_topology.GetOrientation())) {
-                    m_colorsSet = rprApi->SetMeshVertexColor(rprMesh, m_colorSamples, m_colorInterpolation);
-                    m_opacitySet = rprApi->SetMeshVertexOpacity(rprMesh, m_opacitySamples, m_opacityInterpolation);
+                RprMeshTopology meshTopology;
+                meshTopology.topology = rprApi->PrepareMeshTopology(m_faceVertexIndices, m_normalIndices, m_uvIndices, m_faceVertexCounts, m_topology.GetOrientation());
+                if (auto rprMesh = createRprMesh(meshTopology)) {
                     m_rprMeshes.push_back(rprMesh);
+                    m_rprMeshTopologies.push_back(std::move(meshTopology));
                 }
             }
         } else {
@@ -517,9 +659,13 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                 offset += numVerticesInFace;
             }
 
-            VtIntArray vertexIndexRemapping;
-            VtIntArray normalIndexRemapping;
-            VtIntArray uvIndexRemapping;
+            size_t numPoints = !m_pointSamples.empty() ? m_pointSamples.cdata()[0].size() : 0;
+            size_t numNormals = !m_normalSamples.empty() ? m_normalSamples.cdata()[0].size() : 0;
+            size_t numUvs = !m_uvSamples.empty() ? m_uvSamples.cdata()[0].size() : 0;
+
+            std::vector<int> vertexIndexRemapping;
+            std::vector<int> normalIndexRemapping;
+            std::vector<int> uvIndexRemapping;
 
             for (auto it = m_geomSubsets.begin(); it != m_geomSubsets.end();) {
                 auto const& subset = *it;
@@ -529,28 +675,24 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                     continue;
                 }
 
-                VtArray<VtVec3fArray> subsetPointSamples(m_pointSamples.size());
-                VtArray<VtVec3fArray> subsetNormalSamples(m_normalSamples.size());
-                VtArray<VtVec3fArray> subsetColorSamples(m_colorSamples.size());
-                VtArray<VtFloatArray> subsetOpacitySamples(m_opacitySamples.size());
-                VtArray<VtVec2fArray> subsetUvSamples(m_uvSamples.size());
+                // Subset topology holds subset-local indices, the mapping from subset-local
+                // to source indices is stored in meshTopology and reused on vertex data updates
+                RprMeshTopology meshTopology;
                 VtIntArray subsetNormalIndices;
                 VtIntArray subsetUvIndices;
                 VtIntArray subsetIndexes;
                 VtIntArray subsetVertexPerFace;
                 subsetVertexPerFace.reserve(subset.indices.size());
 
-                vertexIndexRemapping.reserve(m_pointSamples.front().size());
-                std::fill(vertexIndexRemapping.begin(), vertexIndexRemapping.begin() + m_pointSamples.front().size(), -1);
+                vertexIndexRemapping.assign(numPoints, -1);
                 if (!m_normalIndices.empty()) {
-                    normalIndexRemapping.reserve(m_normalSamples.front().size());
-                    std::fill(normalIndexRemapping.begin(), normalIndexRemapping.begin() + m_normalSamples.front().size(), -1);
+                    normalIndexRemapping.assign(numNormals, -1);
                 }
                 if (!m_uvIndices.empty()) {
-                    uvIndexRemapping.reserve(m_uvSamples.front().size());
-                    std::fill(uvIndexRemapping.begin(), uvIndexRemapping.begin() + m_uvSamples.front().size(), -1);
+                    uvIndexRemapping.assign(numUvs, -1);
                 }
 
+                bool isValidSubset = true;
                 for (auto faceIndex : subset.indices) {
                     int numVerticesInFace = m_faceVertexCounts[faceIndex];
                     subsetVertexPerFace.push_back(numVerticesInFace);
@@ -559,99 +701,107 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
 
                     for (int i = 0; i < numVerticesInFace; ++i) {
                         const int pointIndex = m_faceVertexIndices[faceIndexesOffset + i];
-                        int subsetPointIndex = vertexIndexRemapping[pointIndex];
+                        if (pointIndex < 0 || size_t(pointIndex) >= numPoints) {
+                            isValidSubset = false;
+                            break;
+                        }
 
-                        bool newPoint = subsetPointIndex == -1;
-                        if (newPoint) {
-                            subsetPointIndex = static_cast<int>(subsetPointSamples.front().size());
+                        int subsetPointIndex = vertexIndexRemapping[pointIndex];
+                        if (subsetPointIndex == -1) {
+                            subsetPointIndex = static_cast<int>(meshTopology.pointIndices.size());
                             vertexIndexRemapping[pointIndex] = subsetPointIndex;
-
-                            for (int sampleIndex = 0; sampleIndex < m_pointSamples.size(); ++sampleIndex) {
-                                subsetPointSamples[sampleIndex].push_back(m_pointSamples[sampleIndex][pointIndex]);
-                            }
+                            meshTopology.pointIndices.push_back(pointIndex);
                         }
                         subsetIndexes.push_back(subsetPointIndex);
 
-                        if (!m_normalSamples.empty()) {
-                            if (m_normalIndices.empty()) {
-                                if (newPoint) {
-                                    for (int sampleIndex = 0; sampleIndex < m_normalSamples.size(); ++sampleIndex) {
-                                        subsetNormalSamples[sampleIndex].push_back(m_normalSamples[sampleIndex][pointIndex]);
-                                    }
-                                }
-                            } else {
-                                const int normalIndex = m_normalIndices[faceIndexesOffset + i];
-                                int subsetNormalIndex = normalIndexRemapping[normalIndex];
-                                if (subsetNormalIndex == -1) {
-                                    subsetNormalIndex = static_cast<int>(subsetNormalSamples.front().size());
-                                    normalIndexRemapping[normalIndex] = subsetNormalIndex;
-
-                                    for (int sampleIndex = 0; sampleIndex < m_normalSamples.size(); ++sampleIndex) {
-                                        subsetNormalSamples[sampleIndex].push_back(m_normalSamples[sampleIndex][normalIndex]);
-                                    }
-                                }
-                                subsetNormalIndices.push_back(subsetNormalIndex);
+                        if (!m_normalSamples.empty() && !m_normalIndices.empty()) {
+                            const int normalIndex = m_normalIndices[faceIndexesOffset + i];
+                            if (normalIndex < 0 || size_t(normalIndex) >= numNormals) {
+                                isValidSubset = false;
+                                break;
                             }
-                        }
-
-                        if (!m_uvSamples.empty()) {
-                            if (m_uvIndices.empty()) {
-                                if (newPoint) {
-                                    for (int sampleIndex = 0; sampleIndex < m_uvSamples.size(); ++sampleIndex) {
-                                        subsetUvSamples[sampleIndex].push_back(m_uvSamples[sampleIndex][pointIndex]);
-                                    }
-                                }
-                            } else {
-                                const int uvIndex = m_uvIndices[faceIndexesOffset + i];
-                                int subsetuvIndex = uvIndexRemapping[uvIndex];
-                                if (subsetuvIndex == -1) {
-                                    subsetuvIndex = static_cast<int>(subsetUvSamples.front().size());
-                                    uvIndexRemapping[uvIndex] = subsetuvIndex;
-
-                                    for (int sampleIndex = 0; sampleIndex < m_uvSamples.size(); ++sampleIndex) {
-                                        subsetUvSamples[sampleIndex].push_back(m_uvSamples[sampleIndex][uvIndex]);
-                                    }
-                                }
-                                subsetUvIndices.push_back(subsetuvIndex);
+                            int subsetNormalIndex = normalIndexRemapping[normalIndex];
+                            if (subsetNormalIndex == -1) {
+                                subsetNormalIndex = static_cast<int>(meshTopology.normalIndices.size());
+                                normalIndexRemapping[normalIndex] = subsetNormalIndex;
+                                meshTopology.normalIndices.push_back(normalIndex);
                             }
+                            subsetNormalIndices.push_back(subsetNormalIndex);
                         }
 
-                        if (!m_colorSamples.empty()) {
-                            if (newPoint) {
-                                for (int sampleIndex = 0; sampleIndex < m_uvSamples.size(); ++sampleIndex) {
-                                    if (sampleIndex >= m_colorSamples.size() || pointIndex >= m_colorSamples[sampleIndex].size()) {
-                                        TF_WARN("Vertex index does not match displayColor primvar size");
-                                        continue;
-                                    }
-                                    subsetColorSamples[sampleIndex].push_back(m_colorSamples[sampleIndex][pointIndex]);
-                                }
+                        if (!m_uvSamples.empty() && !m_uvIndices.empty()) {
+                            const int uvIndex = m_uvIndices[faceIndexesOffset + i];
+                            if (uvIndex < 0 || size_t(uvIndex) >= numUvs) {
+                                isValidSubset = false;
+                                break;
                             }
-                        }
-
-                        if (!m_opacitySamples.empty()) {
-                            if (newPoint) {
-                                for (int sampleIndex = 0; sampleIndex < m_uvSamples.size(); ++sampleIndex) {
-                                    if (sampleIndex >= m_opacitySamples.size() || pointIndex >= m_opacitySamples[sampleIndex].size()) {
-                                        TF_WARN("Vertex index does not match displayOpacity primvar size");
-                                        continue;
-                                    }
-                                    subsetOpacitySamples[sampleIndex].push_back(m_opacitySamples[sampleIndex][pointIndex]);
-                                }
+                            int subsetUvIndex = uvIndexRemapping[uvIndex];
+                            if (subsetUvIndex == -1) {
+                                subsetUvIndex = static_cast<int>(meshTopology.uvIndices.size());
+                                uvIndexRemapping[uvIndex] = subsetUvIndex;
+                                meshTopology.uvIndices.push_back(uvIndex);
                             }
+                            subsetUvIndices.push_back(subsetUvIndex);
                         }
                     }
+
+                    if (!isValidSubset) {
+                        break;
+                    }
+                }
+
+                rpr::Shape* rprMesh = nullptr;
+                if (isValidSubset) {
+                    meshTopology.topology = rprApi->PrepareMeshTopology(subsetIndexes, subsetNormalIndices, subsetUvIndices, subsetVertexPerFace, m_topology.GetOrientation());
+                    rprMesh = createRprMesh(meshTopology);
+                } else {
+                    TF_RUNTIME_ERROR("GeomSubset of %s references out of range vertex", id.GetText());
                 }
 
-                if (auto rprMesh = rprApi->CreateMesh(subsetPointSamples, subsetIndexes, subsetNormalSamples, subsetNormalIndices, subsetUvSamples, subsetUvIndices, subsetVertexPerFace, m_topology.GetOrientation())) {
-                    m_colorsSet = rprApi->SetMeshVertexColor(rprMesh, subsetColorSamples, m_colorInterpolation);
-                    m_opacitySet = rprApi->SetMeshVertexOpacity(rprMesh, subsetOpacitySamples, m_opacityInterpolation);
+                if (rprMesh) {
                     m_rprMeshes.push_back(rprMesh);
+                    m_rprMeshTopologies.push_back(std::move(meshTopology));
                     ++it;
                 } else {
                     it = m_geomSubsets.erase(it);
                 }
             }
         }
+    } else if (isVertexDataDirty) {
+        // Topology has not changed: RPR does not allow to re-upload vertex data of an existing shape,
+        // so meshes are recreated directly from the prepared topology skipping polygon splitting,
+        // winding conversion and geomSubset remapping
+        for (auto mesh : m_rprMeshes) {
+            rprApi->Release(mesh);
+        }
+        ReleaseInstances(rprApi);
+        m_rprMeshes.clear();
+
+        auto meshTopologies = std::move(m_rprMeshTopologies);
+        m_rprMeshTopologies.clear();
+        for (auto& meshTopology : meshTopologies) {
+            if (auto rprMesh = createRprMesh(meshTopology)) {
+                m_rprMeshes.push_back(rprMesh);
+                m_rprMeshTopologies.push_back(std::move(meshTopology));
+            } else if (IsSplitByGeomSubsets()) {
+                // Keep geomSubsets in sync with meshes
+                m_geomSubsets.erase(m_geomSubsets.begin() + m_rprMeshes.size());
+            }
+        }
+    } else if (isVertexColorDirty) {
+        // Vertex colors are stored as shape primvars, they can be updated in-place
+        for (size_t i = 0; i < m_rprMeshes.size(); ++i) {
+            setMeshVertexColor(m_rprMeshes[i], m_rprMeshTopologies[i]);
+        }
+    }
+
+    // Fallback material depends on whether vertex colors are set or not
+    bool isVertexColorSetDirty = colorsSet != m_colorsSet || opacitySet != m_opacitySet;
+
+    bool isMeshRecreated = newMesh || isVertexDataDirty;
+    if (isMeshRecreated) {
+        updateTransform = true;
+        m_isGeometryShared = canShareGeometry;
     }
 
     if (!m_rprMeshes.empty()) {
@@ -660,7 +810,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             rprApi->SetName(rprMesh, name);
         }
 
-        if (newMesh || (*dirtyBits & HdChangeTracker::DirtySubdivTags)) {
+        if (isMeshRecreated || (*dirtyBits & HdChangeTracker::DirtySubdivTags)) {
             PxOsdSubdivTags subdivTags = sceneDelegate->GetSubdivTags(id);
 
             // XXX: RPR does not support this
@@ -684,15 +834,16 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (newMesh || isRefineLevelDirty) {
+        if (isMeshRecreated || isRefineLevelDirty) {
             for (auto& rprMesh : m_rprMeshes) {
                 rprApi->SetMeshRefineLevel(rprMesh, m_refineLevel, m_subdivisionCreaseWeight);
             }
         }
 
-        if (newMesh || (*dirtyBits & HdChangeTracker::DirtyMaterialId) ||
+        if (isMeshRecreated || (*dirtyBits & HdChangeTracker::DirtyMaterialId) ||
             (*dirtyBits & HdChangeTracker::DirtyDoubleSided) || // update twosided material node
-            (*dirtyBits & HdChangeTracker::DirtyDisplayStyle) || isRefineLevelDirty) { // update displacement material
+            (*dirtyBits & HdChangeTracker::DirtyDisplayStyle) || isRefineLevelDirty || // update displacement material
+            isVertexColorSetDirty) {
             auto getMeshMaterial = [sceneDelegate, &rprApi, dirtyBits, &primvarDescsPerInterpolation, this](SdfPath const& materialId) {
                 auto material = static_cast<const HdRprMaterial*>(sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, materialId));
                 if (material && material->GetRprMaterialObject()) {
@@ -703,36 +854,36 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
                 }
             };
 
+            auto getSubsetRprMaterial = [&](SdfPath const& materialId) -> RprUsdMaterial const* {
+                auto material = getSubsetMaterial(materialId);
+                if (material && material->GetRprMaterialObject()) {
+                    return material->GetRprMaterialObject();
+                }
+                HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, GetId(), &primvarDescsPerInterpolation);
+                return GetFallbackMaterial(sceneDelegate, rprApi, *dirtyBits, primvarDescsPerInterpolation);
+            };
+
             if (m_geomSubsets.empty()) {
                 auto material = getMeshMaterial(m_materialId);
                 for (auto& mesh : m_rprMeshes) {
                     rprApi->SetMeshMaterial(mesh, material, m_displayStyle.displacementEnabled);
                 }
+            } else if (m_usePerFaceMaterials) {
+                // Subsets cover all faces of the mesh. The material of the first subset is attached
+                // to the whole shape to reset per-shape properties, then each subset overrides its faces
+                for (size_t i = 0; i < m_geomSubsets.size(); ++i) {
+                    auto material = getSubsetRprMaterial(m_geomSubsets[i].materialId);
+                    for (auto& mesh : m_rprMeshes) {
+                        if (i == 0) {
+                            rprApi->SetMeshMaterial(mesh, material, false);
+                        }
+                        rprApi->SetMeshMaterialFaces(mesh, material, m_geomSubsets[i].indices, m_faceVertexCounts);
+                    }
+                }
             } else {
                 if (m_geomSubsets.size() == m_rprMeshes.size()) {
-                    for (int i = 0; i < m_rprMeshes.size(); ++i) {
-						bool hasMaterialByShortPath
-							= (sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, m_geomSubsets[i].materialId)) != nullptr;
-
-						RprUsdMaterial const* material;
-						if (!hasMaterialByShortPath) {
-							// geomSubset has only relative material path. Relative to mesh.
-							// materials however are stored by full material path
-							// so when relative material path is passed material is not found
-							// thus we have to get full material path to get pointer to material
-							auto pMaterial = getPerFaceMeshMaterial(m_geomSubsets[i].materialId);
-							if (pMaterial && pMaterial->GetRprMaterialObject()) {
-								material = pMaterial->GetRprMaterialObject();
-							}
-							else {
-								HdRprFillPrimvarDescsPerInterpolation(sceneDelegate, GetId(), &primvarDescsPerInterpolation);
-								material = GetFallbackMaterial(sceneDelegate, rprApi, *dirtyBits, primvarDescsPerInterpolation);
-							}
-						}
-						else {
-							material = getMeshMaterial(m_geomSubsets[i].materialId);
-						}
-
+                    for (size_t i = 0; i < m_rprMeshes.size(); ++i) {
+                        auto material = getSubsetRprMaterial(m_geomSubsets[i].materialId);
                         rprApi->SetMeshMaterial(m_rprMeshes[i], material, m_displayStyle.displacementEnabled);
                     }
                 } else {
@@ -741,7 +892,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (newMesh || (*dirtyBits & HdChangeTracker::DirtyInstancer)) {
+        if (isMeshRecreated || (*dirtyBits & HdChangeTracker::DirtyInstancer)) {
             forceVisibilityUpdate = true;
 
 #ifdef USE_DECOUPLED_INSTANCER
@@ -813,7 +964,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (newMesh || ((*dirtyBits & HdChangeTracker::DirtyVisibility) || forceVisibilityUpdate)) {
+        if (isMeshRecreated || ((*dirtyBits & HdChangeTracker::DirtyVisibility) || forceVisibilityUpdate)) {
             auto visibilityMask = GetVisibilityMask();
             if (m_instancer) {
                 // Prototypes are always hidden
@@ -833,7 +984,7 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (newMesh || isIdDirty) {
+        if (isMeshRecreated || isIdDirty) {
             uint32_t id = m_id >= 0 ? uint32_t(m_id) : GetPrimId();
             for (auto& rprMesh : m_rprMeshes) {
                 rprApi->SetMeshId(rprMesh, id);
@@ -845,13 +996,13 @@ void HdRprMesh::Sync(HdSceneDelegate* sceneDelegate,
             }
         }
 
-        if (newMesh || isIgnoreContourDirty) {
+        if (isMeshRecreated || isIgnoreContourDirty) {
             for (auto& rprMesh : m_rprMeshes) {
                 rprApi->SetMeshIgnoreContour(rprMesh, m_ignoreContour);
             }
         }
 
-        if (!newMesh && (*dirtyBits & HdChangeTracker::DirtyMaterialId)) {
+        if (!isMeshRecreated && (*dirtyBits & HdChangeTracker::DirtyMaterialId)) {
             for (auto& rprMesh : m_rprMeshes) {
                 if (!m_colorSamples.empty()) {
                     m_colorsSet = rprApi->SetMeshVertexColor(rprMesh, m_colorSamples, m_colorInterpolation);
@@ -881,6 +1032,7 @@ void HdRprMesh::Finalize(HdRenderParam* renderParam) {
     }
     ReleaseInstances(rprApi);
     m_rprMeshes.clear();
+    m_rprMeshTopologies.clear();
 
     rprApi->Release(m_fallbackMaterial);
     m_fallbackMaterial = nullptr;
@@ -894,6 +1046,15 @@ void HdRprMesh::Finalize(HdRenderParam* renderParam) {
     HdRprBaseRprim::Finalize(renderParam);
 }
 
+bool HdRprMesh::IsDisplacementUsed(HdSceneDelegate* sceneDelegate) const {
+    if (!m_displayStyle.displacementEnabled) {
+        return false;
+    }
+
+    auto material = static_cast<const HdRprMaterial*>(sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, m_materialId));
+    return material && material->GetRprMaterialObject() && material->GetRprMaterialObject()->HasDisplacement();
+}
+
 void HdRprMesh::ReleaseInstances(HdRprApi* rprApi) {
     for (auto instances : m_rprMeshInstances) {
         for (auto instance : instances) {
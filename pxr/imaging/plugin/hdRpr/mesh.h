@@ -58,11 +58,31 @@ private:
         HdDirtyBits dirtyBits,
         std::map<HdInterpolation, HdPrimvarDescriptorVector> const& primvarDescsPerInterpolation);
 
+    bool IsDisplacementUsed(HdSceneDelegate* sceneDelegate) const;
+
+    bool IsSplitByGeomSubsets() const { return !m_geomSubsets.empty() && !m_usePerFaceMaterials; }
+
     void ReleaseInstances(HdRprApi* rprApi);
 
 private:
     std::vector<rpr::Shape*> m_rprMeshes;
     std::vector<std::vector<rpr::Shape*>> m_rprMeshInstances;
+
+    struct RprMeshTopology {
+        HdRprApiMeshTopology topology;
+
+        // Mapping of subset-local indices to the source ones.
+        // Used only when the mesh is split by geomSubsets, see IsSplitByGeomSubsets
+        VtIntArray pointIndices;
+        VtIntArray normalIndices;
+        VtIntArray uvIndices;
+    };
+    // Topology that was used to create each of m_rprMeshes, reused when only vertex data changes
+    std::vector<RprMeshTopology> m_rprMeshTopologies;
+    // Whether m_rprMeshes were created with geometry sharing, see HdRprApi::CreateSharedMesh
+    bool m_isGeometryShared = false;
+    // Whether the mesh with geomSubsets is a single shape with per-face materials instead of a shape per subset
+    bool m_usePerFaceMaterials = false;
     RprUsdMaterial* m_fallbackMaterial = nullptr;
 
     static constexpr int kDefaultNumTimeSamples = 2;
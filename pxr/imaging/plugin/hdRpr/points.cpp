@@ -19,11 +19,61 @@ limitations under the License.
 #include "instancer.h"
 
 #include "pxr/imaging/rprUsd/debugCodes.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 #include "pxr/imaging/hd/extComputationUtils.h"
+#include "pxr/base/tf/envSetting.h"
+#include "pxr/base/work/loops.h"
 #include "pxr/usdImaging/usdImaging/implicitSurfaceMeshUtils.h"
 
+#include <algorithm>
+#include <cmath>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
+TF_DEFINE_ENV_SETTING(HDRPR_POINTS_MERGE_THRESHOLD, 100000,
+    "Points prims with more points (including instancer copies) than this are merged into chunked meshes instead of per-point sphere instances. Zero disables merging");
+
+namespace {
+
+// Number of points baked into one mesh of the merged representation
+constexpr size_t kMergedPointsPerChunk = 1 << 16;
+
+struct LowPolySphere {
+    VtVec3fArray points;
+    VtVec3fArray normals;
+    std::vector<int> indices;
+};
+
+// Icosahedron inscribed into the unit sphere mesh of UsdImaging, i.e. with a diameter of 1
+LowPolySphere const& GetLowPolySphere() {
+    static LowPolySphere const sphere = []() {
+        const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+        LowPolySphere ret;
+        ret.normals = {
+            {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+            {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+            {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+        };
+        ret.points.reserve(ret.normals.size());
+        for (auto& normal : ret.normals) {
+            normal.Normalize();
+            ret.points.push_back(normal * 0.5f);
+        }
+
+        ret.indices = {
+            0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+            1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+            3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+            4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1,
+        };
+        return ret;
+    }();
+    return sphere;
+}
+
+} // namespace anonymous
+
 HdRprPoints::HdRprPoints(SdfPath const& id HDRPR_INSTANCER_ID_ARG_DECL)
     : HdRprBaseRprim(id HDRPR_INSTANCER_ID_ARG)
     , m_visibilityMask(kVisibleAll)
@@ -37,6 +87,7 @@ void HdRprPoints::Sync(
     HdRenderParam* renderParam,
     HdDirtyBits* dirtyBits,
     TfToken const& reprSelector) {
+    RprUsdTimelineZone zone("HdRprPoints::Sync", GetId().GetText());
 
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
     auto rprApi = rprRenderParam->AcquireRprApiForEdit();
@@ -133,23 +184,6 @@ void HdRprPoints::Sync(
         }
     }
 
-    if (dirtyDisplayColors) {
-        if (m_material) {
-            rprApi->Release(m_material);
-            m_material = nullptr;
-        }
-
-        if (m_colorsInterpolation == HdInterpolationVertex) {
-            m_material = rprApi->CreatePointsMaterial(m_colors);
-        } else if (!m_colors.empty()) {
-            m_material = rprApi->CreateDiffuseMaterial(m_colors[0]);
-        }
-
-        if (m_material && RprUsdIsLeakCheckEnabled()) {
-            rprApi->SetName(m_material, id.GetText());
-        }
-    }
-
     if (*dirtyBits & HdChangeTracker::DirtyInstancer){
         m_instanceTransforms.clear();
 #ifdef USE_DECOUPLED_INSTANCER
@@ -174,6 +208,39 @@ void HdRprPoints::Sync(
 
     size_t numInstances = m_points.size() * m_instanceTransforms.size();
 
+    // Large point clouds are merged into a few chunked meshes instead of creating an RPR object per point
+    int mergeThreshold = TfGetEnvSetting(HDRPR_POINTS_MERGE_THRESHOLD);
+    bool isMerged = mergeThreshold > 0 && numInstances > size_t(mergeThreshold);
+    bool dirtyRepresentation = isMerged != m_isMerged;
+    if (dirtyRepresentation) {
+        ReleaseRprObjects(rprApi);
+        m_isMerged = isMerged;
+    }
+
+    if (m_isMerged) {
+        SyncMergedPoints(sceneDelegate, rprApi, *dirtyBits, dirtyRepresentation || dirtyPoints || dirtyDisplayColors,
+                         dirtyMaterialOverride, dirtyVisibilityMask, dirtySubdivisionLevel);
+        *dirtyBits = HdChangeTracker::Clean;
+        return;
+    }
+
+    if (dirtyDisplayColors || dirtyRepresentation) {
+        if (m_material) {
+            rprApi->Release(m_material);
+            m_material = nullptr;
+        }
+
+        if (m_colorsInterpolation == HdInterpolationVertex) {
+            m_material = rprApi->CreatePointsMaterial(m_colors);
+        } else if (!m_colors.empty()) {
+            m_material = rprApi->CreateDiffuseMaterial(m_colors[0]);
+        }
+
+        if (m_material && RprUsdIsLeakCheckEnabled()) {
+            rprApi->SetName(m_material, id.GetText());
+        }
+    }
+
     bool dirtyPrototypeMesh = false;
     bool dirtyInstances = false;
     if (m_instances.size() != numInstances) {
@@ -282,9 +349,218 @@ void HdRprPoints::Sync(
     *dirtyBits = HdChangeTracker::Clean;
 }
 
-void HdRprPoints::Finalize(HdRenderParam* renderParam) {
-    auto rprApi = static_cast<HdRprRenderParam*>(renderParam)->AcquireRprApiForEdit();
+void HdRprPoints::SyncMergedPoints(
+    HdSceneDelegate* sceneDelegate,
+    HdRprApi* rprApi,
+    HdDirtyBits dirtyBits,
+    bool dirtyGeometry,
+    bool dirtyMaterialOverride,
+    bool dirtyVisibilityMask,
+    bool dirtySubdivisionLevel) {
+    SdfPath const& id = GetId();
+
+    bool dirtyMeshes = dirtyGeometry || (dirtyBits & HdChangeTracker::DirtyWidths);
+    if (dirtyMeshes) {
+        ReleaseMergedMeshes(rprApi);
+        CreateMergedMeshes(rprApi);
+
+        if (m_material) {
+            rprApi->Release(m_material);
+            m_material = nullptr;
+        }
+
+        if (m_mergedColorsSet) {
+            m_material = rprApi->CreatePrimvarLookupMaterial(true, false);
+        } else if (!m_colors.empty()) {
+            m_material = rprApi->CreateDiffuseMaterial(m_colors[0]);
+        }
+
+        if (m_material && RprUsdIsLeakCheckEnabled()) {
+            rprApi->SetName(m_material, id.GetText());
+        }
+    }
 
+    // Each instancer transform except the first one gets instances of all merged meshes
+    size_t numMeshInstances = m_mergedMeshes.size() * (m_instanceTransforms.size() - 1);
+    bool dirtyMeshInstances = m_mergedMeshInstances.size() != numMeshInstances;
+    if (dirtyMeshInstances) {
+        for (auto instance : m_mergedMeshInstances) {
+            rprApi->Release(instance);
+        }
+        m_mergedMeshInstances.clear();
+
+        m_mergedMeshInstances.reserve(numMeshInstances);
+        for (size_t i = 1; i < m_instanceTransforms.size(); ++i) {
+            for (auto mesh : m_mergedMeshes) {
+                m_mergedMeshInstances.push_back(mesh ? rprApi->CreateMeshInstance(mesh) : nullptr);
+            }
+        }
+    }
+
+    auto forEachShape = [this](auto&& func) {
+        for (size_t i = 0; i < m_instanceTransforms.size(); ++i) {
+            for (size_t j = 0; j < m_mergedMeshes.size(); ++j) {
+                auto shape = i == 0 ? m_mergedMeshes[j] : m_mergedMeshInstances[(i - 1) * m_mergedMeshes.size() + j];
+                if (shape) {
+                    func(shape, i);
+                }
+            }
+        }
+    };
+
+    bool dirtyShapes = dirtyMeshes || dirtyMeshInstances;
+
+    if (dirtyShapes ||
+        (dirtyBits & HdChangeTracker::DirtyTransform) ||
+        (dirtyBits & HdChangeTracker::DirtyInstancer)) {
+        forEachShape([this, rprApi](rpr::Shape* shape, size_t transformIndex) {
+            rprApi->SetTransform(shape, m_transform * m_instanceTransforms[transformIndex]);
+        });
+    }
+
+    if (dirtyMeshes || dirtySubdivisionLevel) {
+        for (auto mesh : m_mergedMeshes) {
+            if (mesh) {
+                rprApi->SetMeshRefineLevel(mesh, m_subdivisionLevel, m_subdivisionCreaseWeight);
+            }
+        }
+    }
+
+    if (m_materialId.IsEmpty()) {
+        if (dirtyShapes) {
+            forEachShape([this, rprApi](rpr::Shape* shape, size_t) {
+                rprApi->SetMeshMaterial(shape, m_material, false);
+            });
+        }
+    } else if (dirtyMaterialOverride || dirtyShapes) {
+        auto material = static_cast<const HdRprMaterial*>(
+            sceneDelegate->GetRenderIndex().GetSprim(HdPrimTypeTokens->material, m_materialId));
+
+        if (material && material->GetRprMaterialObject()) {
+            forEachShape([rprApi, material](rpr::Shape* shape, size_t) {
+                rprApi->SetMeshMaterial(shape, material->GetRprMaterialObject(), false);
+            });
+        }
+    }
+
+    if (!_sharedData.visible) {
+        // if primitive is fully invisible then visibility mask has no effect
+        dirtyVisibilityMask = false;
+    }
+    if ((dirtyBits & HdChangeTracker::DirtyVisibility) ||
+        dirtyVisibilityMask || dirtyShapes) {
+        auto visibilityMask = _sharedData.visible ? m_visibilityMask : kInvisible;
+        forEachShape([rprApi, visibilityMask](rpr::Shape* shape, size_t) {
+            rprApi->SetMeshVisibility(shape, visibilityMask);
+        });
+    }
+}
+
+void HdRprPoints::CreateMergedMeshes(HdRprApi* rprApi) {
+    SdfPath const& id = GetId();
+
+    bool hasVertexColors = m_colorsInterpolation == HdInterpolationVertex && m_colors.size() == m_points.size();
+    if (m_widthsInterpolation != HdInterpolationVertex && m_widthsInterpolation != HdInterpolationConstant) {
+        TF_WARN("[%s] Unsupported widths interpolation. Fallback value is 1.0f with a constant interpolation", id.GetText());
+    }
+
+    auto& sphere = GetLowPolySphere();
+
+    struct Chunk {
+        VtVec3fArray points;
+        VtIntArray pointIndices;
+        VtIntArray normalIndices;
+        VtIntArray vpf;
+        VtVec3fArray colors;
+    };
+    size_t numChunks = (m_points.size() + kMergedPointsPerChunk - 1) / kMergedPointsPerChunk;
+    std::vector<Chunk> chunks(numChunks);
+
+    // Bake all points into chunks of low-poly spheres in parallel, the sphere vertices of a point share its color
+    WorkParallelForN(numChunks,
+        [&](size_t begin, size_t end) {
+            for (size_t chunkIndex = begin; chunkIndex < end; ++chunkIndex) {
+                auto& chunk = chunks[chunkIndex];
+
+                size_t pointsBegin = chunkIndex * kMergedPointsPerChunk;
+                size_t numPoints = std::min(m_points.size() - pointsBegin, kMergedPointsPerChunk);
+                size_t numVertices = sphere.points.size();
+                size_t numIndices = sphere.indices.size();
+
+                chunk.points.resize(numPoints * numVertices);
+                chunk.pointIndices.resize(numPoints * numIndices);
+                chunk.normalIndices.resize(numPoints * numIndices);
+                chunk.vpf.assign(numPoints * numIndices / 3, 3);
+                if (hasVertexColors) {
+                    chunk.colors.resize(numPoints * numVertices);
+                }
+
+                auto points = chunk.points.data();
+                auto pointIndices = chunk.pointIndices.data();
+                auto normalIndices = chunk.normalIndices.data();
+                auto colors = hasVertexColors ? chunk.colors.data() : nullptr;
+
+                for (size_t i = 0; i < numPoints; ++i) {
+                    size_t pointIndex = pointsBegin + i;
+
+                    float width = 1.0f;
+                    if (m_widthsInterpolation == HdInterpolationVertex) {
+                        if (pointIndex < m_widths.size()) {
+                            width = m_widths[pointIndex];
+                        }
+                    } else if (m_widthsInterpolation == HdInterpolationConstant && !m_widths.empty()) {
+                        width = m_widths[0];
+                    }
+
+                    auto& position = m_points[pointIndex];
+                    for (size_t j = 0; j < numVertices; ++j) {
+                        points[i * numVertices + j] = position + sphere.points[j] * width;
+                    }
+
+                    for (size_t j = 0; j < numIndices; ++j) {
+                        pointIndices[i * numIndices + j] = int(i * numVertices) + sphere.indices[j];
+                        normalIndices[i * numIndices + j] = sphere.indices[j];
+                    }
+
+                    if (colors) {
+                        std::fill(colors + i * numVertices, colors + (i + 1) * numVertices, m_colors[pointIndex]);
+                    }
+                }
+            }
+        }
+    );
+
+    m_mergedColorsSet = hasVertexColors;
+    m_mergedMeshes.reserve(numChunks);
+    for (auto& chunk : chunks) {
+        auto mesh = rprApi->CreateMesh(chunk.points, chunk.pointIndices, sphere.normals, chunk.normalIndices, VtVec2fArray(), VtIntArray(), chunk.vpf, HdTokens->rightHanded);
+        if (mesh) {
+            if (hasVertexColors) {
+                m_mergedColorsSet &= rprApi->SetMeshVertexColor(mesh, VtArray<VtVec3fArray>(1, chunk.colors), HdInterpolationVertex);
+            }
+
+            if (RprUsdIsLeakCheckEnabled()) {
+                rprApi->SetName(mesh, id.GetText());
+            }
+        }
+        m_mergedMeshes.push_back(mesh);
+    }
+}
+
+void HdRprPoints::ReleaseMergedMeshes(HdRprApi* rprApi) {
+    // Instances are released before the meshes they were created from
+    for (auto instance : m_mergedMeshInstances) {
+        rprApi->Release(instance);
+    }
+    m_mergedMeshInstances.clear();
+
+    for (auto mesh : m_mergedMeshes) {
+        rprApi->Release(mesh);
+    }
+    m_mergedMeshes.clear();
+}
+
+void HdRprPoints::ReleaseRprObjects(HdRprApi* rprApi) {
     rprApi->Release(m_prototypeMesh);
     m_prototypeMesh = nullptr;
 
@@ -293,8 +569,16 @@ void HdRprPoints::Finalize(HdRenderParam* renderParam) {
     }
     m_instances.clear();
 
+    ReleaseMergedMeshes(rprApi);
+
     rprApi->Release(m_material);
     m_material = nullptr;
+}
+
+void HdRprPoints::Finalize(HdRenderParam* renderParam) {
+    auto rprApi = static_cast<HdRprRenderParam*>(renderParam)->AcquireRprApiForEdit();
+
+    ReleaseRprObjects(rprApi);
  
     HdPoints::Finalize(renderParam);
 }
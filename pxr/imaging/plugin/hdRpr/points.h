@@ -26,6 +26,7 @@ namespace rpr { class Shape; }
 PXR_NAMESPACE_OPEN_SCOPE
 
 class RprUsdMaterial;
+class HdRprApi;
 
 class HdRprPoints : public HdRprBaseRprim<HdPoints> {
 public:
@@ -48,11 +49,25 @@ protected:
     void _InitRepr(TfToken const& reprName,
                    HdDirtyBits* dirtyBits) override;
 
+private:
+    void SyncMergedPoints(HdSceneDelegate* sceneDelegate, HdRprApi* rprApi, HdDirtyBits dirtyBits, bool dirtyGeometry,
+                          bool dirtyMaterialOverride, bool dirtyVisibilityMask, bool dirtySubdivisionLevel);
+    void CreateMergedMeshes(HdRprApi* rprApi);
+    void ReleaseMergedMeshes(HdRprApi* rprApi);
+    void ReleaseRprObjects(HdRprApi* rprApi);
+
 private:
     rpr::Shape* m_prototypeMesh = nullptr;
     std::vector<rpr::Shape*> m_instances;
     RprUsdMaterial* m_material = nullptr;
 
+    // Merged representation of large point clouds: points are baked into chunks of low-poly spheres.
+    // Instancer transforms except the first one are applied to instances of the chunk meshes
+    bool m_isMerged = false;
+    bool m_mergedColorsSet = false;
+    std::vector<rpr::Shape*> m_mergedMeshes;
+    std::vector<rpr::Shape*> m_mergedMeshInstances;
+
     GfMatrix4f m_transform;
     std::vector<GfMatrix4f> m_instanceTransforms;
 
@@ -412,6 +412,39 @@ render_setting_categories = [
                 'houdini': {
                     'hidewhen': lambda settings: hidewhen_render_quality('!=', 'HybridPro', settings)
                 }
+            },
+            {
+                'name': 'quality:maxTextureResolution',
+                'ui_name': 'Max Texture Resolution',
+                'help': 'Maximum resolution of textures in batch rendering. Larger textures are loaded from a smaller mip level of the file when it has one, otherwise they are downsampled. Zero disables the limit.',
+                'defaultValue': 0,
+                'minValue': 0,
+                'maxValue': 65536
+            },
+            {
+                'name': 'quality:reduceTexturePrecision',
+                'ui_name': 'Reduce Texture Precision',
+                'help': 'Analyze the values of float and 16-bit textures when they are loaded and store them with the smallest component type that represents them: 8-bit for LDR data, half float for HDR data. Reduces memory usage of textures that are stored with excessive precision.',
+                'defaultValue': False
+            },
+            {
+                'name': 'quality:reduceTexturePrecisionMaxError',
+                'ui_name': 'Reduce Texture Precision Max Error',
+                'help': 'Maximum error that is allowed when texture precision is reduced. The error is absolute for 8-bit data and relative for half float data. Zero allows only lossless reduction.',
+                'defaultValue': 0.0,
+                'minValue': 0.0,
+                'maxValue': 0.01,
+                'houdini': {
+                    'hidewhen': 'quality:reduceTexturePrecision == 0'
+                }
+            },
+            {
+                'name': 'quality:imageCacheRetentionBudget',
+                'ui_name': 'Unused Texture Memory Budget (MB)',
+                'help': 'Amount of memory in megabytes that can be occupied by textures that are not used by any material anymore but are kept for reuse, e.g. when a material is reassigned or edited. The least recently released textures are evicted first. Zero disables the retention.',
+                'defaultValue': 512,
+                'minValue': 0,
+                'maxValue': 65536
             }
         ]
     },
@@ -448,6 +481,53 @@ render_setting_categories = [
                 'houdini': {
                     'hidewhen': hidewhen_not_northstar
                 }
+            },
+            {
+                'name': 'quality:interactive:volumeVoxelBudget',
+                'ui_name': 'Interactive Volume Voxel Budget',
+                'help': 'Maximum number of active voxels (in millions) per volume in interactive mode. Volumes that exceed the budget are rendered at a coarser resolution until interactive mode ends. Zero disables the budget.',
+                'defaultValue': 4,
+                'minValue': 0,
+                'maxValue': 1000,
+                'houdini': {
+                    'hidewhen': hidewhen_hybrid
+                }
+            },
+            {
+                'name': 'quality:interactive:maxTextureResolution',
+                'ui_name': 'Interactive Max Texture Resolution',
+                'help': 'Controls value of \'Max Texture Resolution\' in non-batch rendering, e.g. in the viewport. Zero disables the limit.',
+                'defaultValue': 4096,
+                'minValue': 0,
+                'maxValue': 65536
+            },
+            {
+                'name': 'quality:interactive:auto:enable',
+                'ui_name': 'Automatic Interactive Mode',
+                'help': 'Automatically switch to interactive mode while camera or scene edits arrive in quick succession and back to full quality once they stop. Has no effect in batch rendering.',
+                'defaultValue': True
+            },
+            {
+                'name': 'quality:interactive:auto:editInterval',
+                'ui_name': 'Automatic Interactive Edit Interval (ms)',
+                'help': 'Edits that arrive within this time of the previous edit are treated as interaction. A few such edits in a row are required to enter interactive mode.',
+                'defaultValue': 250,
+                'minValue': 10,
+                'maxValue': 5000,
+                'houdini': {
+                    'hidewhen': 'quality:interactive:auto:enable == 0'
+                }
+            },
+            {
+                'name': 'quality:interactive:auto:idleTime',
+                'ui_name': 'Automatic Interactive Idle Time (ms)',
+                'help': 'Time without edits after which full quality rendering is restored. Values lower than the edit interval are clamped to it.',
+                'defaultValue': 500,
+                'minValue': 10,
+                'maxValue': 10000,
+                'houdini': {
+                    'hidewhen': 'quality:interactive:auto:enable == 0'
+                }
             }
         ]
     },
@@ -811,6 +891,10 @@ render_setting_categories = [
             {
                 'name': 'progressive',
                 'defaultValue': True
+            },
+            {
+                'name': 'asyncResolve',
+                'defaultValue': True
             }
         ]
     },
@@ -72,12 +72,15 @@ bool HdRprRenderBuffer::Allocate(GfVec3i const& dimensions,
     m_multiSampled = multiSampled;
     m_isConverged.store(false);
 
+    m_isSwapPending = false;
+
     size_t dataByteSize = m_width * m_height * HdDataSizeOfFormat(m_format);
     if (dataByteSize) {
-        m_mappedBuffer.reserve(dataByteSize);
-        std::memset(m_mappedBuffer.data(), 0, dataByteSize);
+        m_mappedBuffer.assign(dataByteSize, 0);
+        m_backBuffer.assign(dataByteSize, 0);
     } else {
         m_mappedBuffer = std::vector<uint8_t>();
+        m_backBuffer = std::vector<uint8_t>();
     }
 
     return true;
@@ -94,23 +97,22 @@ void HdRprRenderBuffer::_Deallocate() {
     m_height = 0u;
     m_format = HdFormatInvalid;
     m_isConverged.store(false);
+    m_isSwapPending = false;
     m_mappedBuffer = std::vector<uint8_t>();
+    m_backBuffer = std::vector<uint8_t>();
 }
 
 void* HdRprRenderBuffer::Map() {
     m_rprApi->Resolve(GetId());
 
-#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
+    // Resolves write into the back buffer so mapping never has to wait for them
     std::unique_lock<std::mutex> lock(m_mapMutex);
-#endif // ENABLE_MULTITHREADED_RENDER_BUFFER
 
     ++m_numMappers;
     return m_mappedBuffer.data();
 }
 
 void HdRprRenderBuffer::Unmap() {
-
-#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
     bool isLastMapper;
     {
         std::unique_lock<std::mutex> lock(m_mapMutex);
@@ -118,15 +120,20 @@ void HdRprRenderBuffer::Unmap() {
             TF_CODING_ERROR("Invalid HdRenderBuffer usage detected. Over-use of Unmap.");
             return;
         }
-#endif // ENABLE_MULTITHREADED_RENDER_BUFFER
 
         --m_numMappers;
         TF_VERIFY(m_numMappers >= 0);
 
-#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
         isLastMapper = m_numMappers == 0;
+
+        // The resolve has completed while the buffer was mapped, publish its result now
+        if (isLastMapper && m_isSwapPending) {
+            std::swap(m_mappedBuffer, m_backBuffer);
+            m_isSwapPending = false;
+        }
     }
 
+#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
     if (isLastMapper) {
         m_mapConditionVar.notify_one();
     }
@@ -140,6 +147,25 @@ void HdRprRenderBuffer::Unmap() {
     //}
 }
 
+void* HdRprRenderBuffer::GetPointerForWriting() {
+    std::unique_lock<std::mutex> lock(m_mapMutex);
+
+    // The back buffer is about to be overwritten, the previous pending data is stale now
+    m_isSwapPending = false;
+    return m_backBuffer.data();
+}
+
+void HdRprRenderBuffer::SwapBuffers() {
+    std::unique_lock<std::mutex> lock(m_mapMutex);
+
+    if (m_numMappers == 0) {
+        std::swap(m_mappedBuffer, m_backBuffer);
+        m_isSwapPending = false;
+    } else {
+        m_isSwapPending = true;
+    }
+}
+
 bool HdRprRenderBuffer::IsMapped() const {
     // There is no point to lock this read because HdRenderBuffer user has no idea about internal synchronization.
     // Calling this function to check if they need to unmap a render buffer is just wrong and should not happen.
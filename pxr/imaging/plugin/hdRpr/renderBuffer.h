@@ -17,6 +17,7 @@ limitations under the License.
 #include "pxr/imaging/hd/renderBuffer.h"
 
 #include <condition_variable>
+#include <mutex>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -59,7 +60,10 @@ public:
 
     void SetConverged(bool converged);
 
-    void* GetPointerForWriting() { return m_mappedBuffer.data(); }
+    // Render buffer is double-buffered: resolves write into the back buffer while the front one is mapped.
+    // Written data becomes visible to Map() only after SwapBuffers call
+    void* GetPointerForWriting();
+    void SwapBuffers();
 
     // HdRprRenderBuffer should hold actual framebuffer
     // But for now just take it from HdRprApi in order to provide valid API
@@ -70,6 +74,8 @@ protected:
 
 private:
     std::vector<uint8_t> m_mappedBuffer;
+    std::vector<uint8_t> m_backBuffer;
+    bool m_isSwapPending = false;
     uint32_t m_width = 0u;
     uint32_t m_height = 0u;
     HdFormat m_format = HdFormat::HdFormatInvalid;
@@ -79,8 +85,8 @@ private:
 
     HdRprApi* m_rprApi = nullptr;
     
-#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
     std::mutex m_mapMutex;
+#ifdef ENABLE_MULTITHREADED_RENDER_BUFFER
     std::condition_variable m_mapConditionVar;
 #endif // ENABLE_MULTITHREADED_RENDER_BUFFER
 
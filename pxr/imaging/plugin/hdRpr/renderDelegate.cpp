@@ -49,6 +49,13 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 static HdRprApi* g_rprApi = nullptr;
 
+static size_t GetVolumeVoxelBudget(HdRprConfig const& config) {
+    if (config.GetInteractiveMode()) {
+        return size_t(config.GetQualityInteractiveVolumeVoxelBudget()) * 1000000;
+    }
+    return 0;
+}
+
 class HdRprDiagnosticMgrDelegate : public TfDiagnosticMgr::Delegate {
 public:
     explicit HdRprDiagnosticMgrDelegate(std::string const& logFile) : m_outputFile(nullptr) {
@@ -167,6 +174,14 @@ HdRprDelegate::HdRprDelegate(HdRenderSettingsMap const& renderSettings) {
     m_settingDescriptors = HdRprConfig::GetRenderSettingDescriptors();
     _PopulateDefaultSettings(m_settingDescriptors);
 
+    {
+        // Volumes read the budget on their first sync, which happens before any render pass executes
+        HdRprConfig* config;
+        auto configInstanceLock = LockConfigInstance(&config);
+        config->Sync(this);
+        m_renderParam->SetVolumeVoxelBudget(GetVolumeVoxelBudget(*config), nullptr);
+    }
+
     m_renderThread.SetRenderCallback([this]() {
         m_rprApi->Render(&m_renderThread);
     });
@@ -199,9 +214,41 @@ HdRenderParam* HdRprDelegate::GetRenderParam() const {
 }
 
 void HdRprDelegate::CommitResources(HdChangeTracker* tracker) {
+    RprUsdTextureLoadOptions textureLoadOptions;
+    size_t volumeVoxelBudget;
+    size_t imageCacheRetentionBudget;
+    {
+        HdRprConfig* config;
+        auto configInstanceLock = LockConfigInstance(&config);
+        // Catch up with the settings before the render pass does it to load textures with the actual options
+        config->Sync(this);
+        textureLoadOptions.maxResolution = config->GetRenderMode() == HdRprRenderModeTokens->batch ?
+            config->GetQualityMaxTextureResolution() : config->GetQualityInteractiveMaxTextureResolution();
+        textureLoadOptions.reducePrecision = config->GetQualityReduceTexturePrecision();
+        textureLoadOptions.maxPrecisionError = config->GetQualityReduceTexturePrecisionMaxError();
+        volumeVoxelBudget = GetVolumeVoxelBudget(*config);
+        imageCacheRetentionBudget = size_t(config->GetQualityImageCacheRetentionBudget()) * 1024 * 1024;
+    }
+    if (!m_isTextureLoadOptionsSet || m_textureLoadOptions != textureLoadOptions) {
+        m_rprApi->SetTextureLoadOptions(textureLoadOptions);
+        if (m_isTextureLoadOptionsSet) {
+            // Materials reload their textures with the new options on the next sync
+            m_renderParam->MarkMaterialsDirty(tracker);
+        }
+        m_textureLoadOptions = textureLoadOptions;
+        m_isTextureLoadOptionsSet = true;
+    }
+    m_rprApi->SetImageCacheRetentionBudget(imageCacheRetentionBudget);
+
+    // Volumes pick up the new budget on the next sync
+    m_renderParam->SetVolumeVoxelBudget(volumeVoxelBudget, tracker);
+
     // CommitResources() is called after prim sync has finished, but before any
     // tasks (such as draw tasks) have run.
     m_rprApi->CommitResources();
+
+    // All edits of the current sync pass are done, the render can be restarted
+    m_renderParam->CommitEditTransaction();
 }
 
 TfTokenVector HdRprDelegate::GetMaterialRenderContexts() const {
@@ -378,6 +425,17 @@ VtDictionary HdRprDelegate::GetRenderStats() const {
     
     stats["cacheCreationTime"] = rprStats.cacheCreationTime;
     stats["syncTime"] = rprStats.syncTime;
+    stats["numDeduplicatedMaterials"] = rprStats.numDeduplicatedMaterials;
+    stats["numDeduplicatedMeshes"] = rprStats.numDeduplicatedMeshes;
+    stats["imageCacheNumHits"] = rprStats.imageCacheNumHits;
+    stats["imageCacheNumMisses"] = rprStats.imageCacheNumMisses;
+    stats["imageCacheNumEvictions"] = rprStats.imageCacheNumEvictions;
+    stats["imageCacheNumRetainedImages"] = rprStats.imageCacheNumRetainedImages;
+    stats["imageCacheRetainedDataSize"] = rprStats.imageCacheRetainedDataSize;
+
+    auto editTransactionStats = m_renderParam->GetEditTransactionStats();
+    stats["numRenderStops"] = editTransactionStats.numRenderStops;
+    stats["renderStopStallTime"] = editTransactionStats.renderStopStallTime;
 
     return stats;
 }
@@ -18,6 +18,8 @@ limitations under the License.
 #include "renderThread.h"
 #include "config.h"
 
+#include "pxr/imaging/rprUsd/util.h"
+
 #include "pxr/imaging/hd/renderDelegate.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
@@ -127,6 +129,10 @@ private:
 
     // Config should be retrieved with LockConfigInstance() to provide thread-safety
     HdRprConfig m_configInstance;
+
+    // Options that textures were loaded with, not set until the first CommitResources
+    RprUsdTextureLoadOptions m_textureLoadOptions;
+    bool m_isTextureLoadOptionsSet = false;
 };
 
 
@@ -14,8 +14,11 @@ limitations under the License.
 #include "renderParam.h"
 #include "volume.h"
 
+#include "pxr/imaging/hd/material.h"
 #include "pxr/imaging/hd/sceneDelegate.h"
 
+#include <chrono>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 HdRprVolumeFieldSubscription HdRprRenderParam::SubscribeVolumeForFieldUpdates(
@@ -55,6 +58,24 @@ void HdRprRenderParam::NotifyVolumesAboutFieldChange(HdSceneDelegate* sceneDeleg
     }
 }
 
+void HdRprRenderParam::SetVolumeVoxelBudget(size_t voxelBudget, HdChangeTracker* changeTracker) {
+    if (m_volumeVoxelBudget.exchange(voxelBudget) == voxelBudget) {
+        return;
+    }
+    if (!changeTracker) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_subscribedVolumesMutex);
+    for (auto& entry : m_subscribedVolumes) {
+        for (auto& subscription : entry.second) {
+            if (auto volume = subscription.lock()) {
+                changeTracker->MarkRprimDirty(volume->GetId(), HdChangeTracker::DirtyTopology);
+            }
+        }
+    }
+}
+
 void HdRprRenderParam::SubscribeForMaterialUpdates(SdfPath const& materialId, SdfPath const& rPrimId) {
     std::lock_guard<std::mutex> lock(m_materialSubscriptionsMutex);
     m_materialSubscriptions[materialId].insert(rPrimId);
@@ -82,45 +103,63 @@ void HdRprRenderParam::MaterialDidChange(HdSceneDelegate* sceneDelegate, SdfPath
     }
 }
 
-size_t RprApiSafeWrapper::m_ptrCounter = 0;
-std::mutex RprApiSafeWrapper::m_threadControlMutex;
+void HdRprRenderParam::MarkMaterialsDirty(HdChangeTracker* changeTracker) {
+    std::lock_guard<std::mutex> lock(m_materialSubscriptionsMutex);
+    for (auto& entry : m_materialSubscriptions) {
+        changeTracker->MarkSprimDirty(entry.first, HdMaterial::DirtyResource);
+    }
+}
+
+void HdRprRenderParam::BeginEdit() {
+    if (m_isEditTransactionOpen.load()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_editTransactionMutex);
+    if (m_isEditTransactionOpen.load()) {
+        return;
+    }
+
+    // Concurrent editors wait on the mutex until the render thread is fully stopped
+    if (m_renderThread->IsRendering()) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        m_renderThread->StopRender();
+        std::chrono::duration<double> stallTime = std::chrono::high_resolution_clock::now() - startTime;
+
+        m_editTransactionStats.numRenderStops++;
+        m_editTransactionStats.renderStopStallTime += stallTime.count();
+    }
+
+    m_isEditTransactionOpen.store(true);
+}
+
+void HdRprRenderParam::CommitEditTransaction() {
+    std::lock_guard<std::mutex> lock(m_editTransactionMutex);
+    if (m_isEditTransactionOpen.exchange(false)) {
+        RestartRender();
+    }
+}
+
+HdRprRenderParam::EditTransactionStats HdRprRenderParam::GetEditTransactionStats() {
+    std::lock_guard<std::mutex> lock(m_editTransactionMutex);
+    return m_editTransactionStats;
+}
 
 RprApiSafeWrapper::RprApiSafeWrapper(HdRprRenderParam* renderParam, HdRprApi* rprApi)
     : m_renderParam(renderParam)
     , m_rprApi(rprApi)
 {
-    std::lock_guard<std::mutex> lock(m_threadControlMutex);
-    if (m_ptrCounter == 0)
-    {
-        m_renderParam->GetRenderThread()->StopRender();
-    }
-
-    ++m_ptrCounter;
+    m_renderParam->BeginEdit();
 }
 
 RprApiSafeWrapper::RprApiSafeWrapper(RprApiSafeWrapper&& other)
+    : m_renderParam(other.m_renderParam)
+    , m_rprApi(other.m_rprApi)
 {
-    std::lock_guard<std::mutex> lock(m_threadControlMutex);
-    if (this == &other)
-        return;
-
-    m_renderParam = other.m_renderParam;
     other.m_renderParam = nullptr;
-
-    m_rprApi = other.m_rprApi;
     other.m_rprApi = nullptr;
-
-    ++m_ptrCounter;
 }
 
-RprApiSafeWrapper::~RprApiSafeWrapper()
-{
-    std::lock_guard<std::mutex> lock(m_threadControlMutex);
-    if (--m_ptrCounter != 0)
-        return;
-
-    if (m_renderParam)
-        m_renderParam->RestartRender();
-}
+RprApiSafeWrapper::~RprApiSafeWrapper() = default;
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -22,6 +22,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 class HdRprApi;
 class HdRprVolume;
+class HdChangeTracker;
 
 using HdRprVolumeFieldSubscription = std::shared_ptr<HdRprVolume>;
 using HdRprVolumeFieldSubscriptionHandle = std::weak_ptr<HdRprVolume>;
@@ -50,8 +51,6 @@ public:
 private:
     HdRprRenderParam* m_renderParam;
     HdRprApi* m_rprApi;
-    static size_t m_ptrCounter;
-    static std::mutex m_threadControlMutex;
 };
 
 class HdRprRenderParam final : public HdRenderParam {
@@ -74,6 +73,12 @@ public:
     HdRprVolumeFieldSubscription SubscribeVolumeForFieldUpdates(HdRprVolume* volume, SdfPath const& fieldId);
     void NotifyVolumesAboutFieldChange(HdSceneDelegate* sceneDelegate, SdfPath const& fieldId);
 
+    // Maximum amount of active voxels per volume, zero means full resolution.
+    // Volumes with fields are re-synced when the budget changes, i.e. when interactive mode toggles.
+    // changeTracker may be null when the budget is seeded before any volume is synced
+    size_t GetVolumeVoxelBudget() const { return m_volumeVoxelBudget; }
+    void SetVolumeVoxelBudget(size_t voxelBudget, HdChangeTracker* changeTracker);
+
     // Hydra does not always mark HdRprim as changed if HdMaterial used by it has been changed.
     // HdStorm marks all existing rprims as dirty when a material is changed.
     // We instead mark only those rprims that use the changed material.
@@ -81,20 +86,41 @@ public:
     void UnsubscribeFromMaterialUpdates(SdfPath const& materialId, SdfPath const& rPrimId);
     void MaterialDidChange(HdSceneDelegate* sceneDelegate, SdfPath const materialId);
 
+    // Marks all materials that are used by rprims dirty, e.g. to reload their textures
+    void MarkMaterialsDirty(HdChangeTracker* changeTracker);
+
     void RestartRender() { m_restartRender.store(true); }
     bool IsRenderShouldBeRestarted() { return m_restartRender.exchange(false); }
 
+    // Edit transaction spans all edits of one Hydra sync pass.
+    // It's opened by the first AcquireRprApiForEdit, which stops the render thread,
+    // and stays open until it's committed by HdRprDelegate::CommitResources.
+    // So the render thread is stopped at most once per Hydra frame
+    void BeginEdit();
+    void CommitEditTransaction();
+
+    struct EditTransactionStats {
+        size_t numRenderStops = 0;
+        double renderStopStallTime = 0.0;
+    };
+    EditTransactionStats GetEditTransactionStats();
+
 private:
     HdRprApi* m_rprApi;
     HdRprRenderThread* m_renderThread;
 
     std::mutex m_subscribedVolumesMutex;
     std::map<SdfPath, std::vector<HdRprVolumeFieldSubscriptionHandle>> m_subscribedVolumes;
+    std::atomic<size_t> m_volumeVoxelBudget{0};
 
     std::mutex m_materialSubscriptionsMutex;
     std::map<SdfPath, std::set<SdfPath>> m_materialSubscriptions;
 
     std::atomic<bool> m_restartRender;
+
+    std::mutex m_editTransactionMutex;
+    std::atomic<bool> m_isEditTransactionOpen{false};
+    EditTransactionStats m_editTransactionStats;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -88,6 +88,9 @@ void HdRprRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState
         m_renderParam->AcquireRprApiForEdit()->SetCamera(renderPassState->GetCamera());
     }
 
+    // Commit edits that were made outside of the sync pass, e.g. above
+    m_renderParam->CommitEditTransaction();
+
     if (m_renderParam->IsRenderShouldBeRestarted() ||
         rprApiConst->IsChanged()) {
         for (auto& aovBinding : renderPassState->GetAovBindings()) {
@@ -14,6 +14,8 @@ limitations under the License.
 #include "rifFilter.h"
 #include "rifError.h"
 
+#include "pxr/imaging/rprUsd/timeline.h"
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 namespace rif {
@@ -311,6 +313,7 @@ void Filter::Update() {
 }
 
 void Filter::Resolve() {
+    RprUsdTimelineZone zone("rif::Filter::Resolve");
     UpdateInputs(m_inputs.begin(), m_inputs.end(), m_rifContext);
     UpdateInputs(m_namedInputs.begin(), m_namedInputs.end(), m_rifContext);
 }
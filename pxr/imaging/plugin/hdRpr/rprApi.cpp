@@ -39,11 +39,13 @@ using json = nlohmann::json;
 #include "pxr/imaging/rprUsd/materialRegistry.h"
 #include "pxr/imaging/rprUsd/contextMetadata.h"
 #include "pxr/imaging/rprUsd/contextHelpers.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 
 #include "pxr/base/gf/math.h"
 #include "pxr/base/gf/vec2f.h"
 #include "pxr/base/gf/rotation.h"
 #include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/arch/hash.h"
 #include "pxr/base/plug/plugin.h"
 #include "pxr/base/plug/thisPlugin.h"
 #include "pxr/imaging/pxOsd/tokens.h"
@@ -82,6 +84,12 @@ using json = nlohmann::json;
 #include <chrono>
 #include <vector>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <map>
+#include <memory>
+#include <atomic>
 
 #include <ghc/filesystem.hpp>
 namespace fs = ghc::filesystem;
@@ -90,6 +98,14 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DEFINE_ENV_SETTING(HDRPR_RENDER_QUALITY_OVERRIDE, "",
     "Set this to override render quality coming from the render settings");
+TF_DEFINE_ENV_SETTING(HDRPR_RENDER_STATS_FILE, "",
+    "Path to the file where render statistics are appended as a JSON line after each render");
+TF_DEFINE_ENV_SETTING(HDRPR_NULL_RENDER, false,
+    "Do not create RPR context: objects are replaced with placeholders, only the delegate side work is done and nothing is rendered");
+TF_DEFINE_ENV_SETTING(HDRPR_GEOMETRY_DEDUPLICATION, true,
+    "Share one RPR shape between meshes with identical geometry using shape instancing");
+TF_DEFINE_ENV_SETTING(HDRPR_API_RECORD_FILE, "",
+    "Path to the JSON file where the number of calls, passed data sizes and time spent in HdRprApi entry points are written on exit");
 
 TF_DEFINE_PRIVATE_TOKENS(_tokens,
     (usdFilename)
@@ -199,6 +215,21 @@ std::unique_ptr<T[]> MergeSamples(VtArray<VtArray<T>>* samples, size_t requiredN
     return mergedSamples;
 }
 
+template <typename T>
+uint64_t HashArray(VtArray<T> const& array, uint64_t seed) {
+    seed = ArchHash64((const char*)&seed, sizeof(seed), array.size());
+    return array.empty() ? seed : ArchHash64((const char*)array.cdata(), array.size() * sizeof(T), seed);
+}
+
+template <typename T>
+uint64_t HashSamples(VtArray<VtArray<T>> const& samples, uint64_t seed) {
+    seed = ArchHash64((const char*)&seed, sizeof(seed), samples.size());
+    for (auto& sample : samples) {
+        seed = HashArray(sample, seed);
+    }
+    return seed;
+}
+
 } // namespace anonymous
 
 TfToken GetRprLpeAovName(rpr::Aov aov) {
@@ -452,6 +483,15 @@ public:
     }
 
     ~HdRprApiImpl() {
+        if (m_asyncResolve.thread.joinable()) {
+            {
+                std::unique_lock<std::mutex> lock(m_asyncResolve.mutex);
+                m_asyncResolve.isStopRequested = true;
+            }
+            m_asyncResolve.cv.notify_all();
+            m_asyncResolve.thread.join();
+        }
+
         RemoveDefaultLight();
     }
 
@@ -467,6 +507,13 @@ public:
             return;
         }
 
+        if (TfGetEnvSetting(HDRPR_NULL_RENDER)) {
+            // HdRprApi hands out placeholder objects instead, see HdRprApiNullBackend
+            TF_STATUS("HDRPR_NULL_RENDER is set, RPR context is not created");
+            m_state = kStateInvalid;
+            return;
+        }
+
         try {
             m_cacheCreationRequired = !CacheCreated();
             InitRpr();
@@ -511,28 +558,56 @@ public:
         return CreateMesh(pointSamples, pointIndices, normalSamples, normalIndices, uvSamples, uvIndices, vpf, polygonWinding);
     }
 
-    rpr::Shape* CreateMesh(VtArray<VtVec3fArray> pointSamples, VtIntArray const& pointIndices,
-                           VtArray<VtVec3fArray> normalSamples, VtIntArray const& normalIndices,
-                           VtArray<VtVec2fArray> uvSamples, VtIntArray const& uvIndices,
+    rpr::Shape* CreateMesh(VtArray<VtVec3fArray> const& pointSamples, VtIntArray const& pointIndices,
+                           VtArray<VtVec3fArray> const& normalSamples, VtIntArray const& normalIndices,
+                           VtArray<VtVec2fArray> const& uvSamples, VtIntArray const& uvIndices,
                            VtIntArray const& vpf, TfToken const& polygonWinding) {
         if (!m_rprContext) {
             return nullptr;
         }
 
-        VtIntArray newIndices, newVpf;
-        SplitPolygons(pointIndices, vpf, newIndices, newVpf);
-        ConvertIndices(&newIndices, newVpf, polygonWinding);
+        auto topology = PrepareMeshTopology(pointIndices, normalIndices, uvIndices, vpf, polygonWinding);
+        return CreateMesh(pointSamples, normalSamples, uvSamples, topology);
+    }
+
+    HdRprApiMeshTopology PrepareMeshTopology(VtIntArray const& pointIndices, VtIntArray const& normalIndices,
+                                             VtIntArray const& uvIndices, VtIntArray const& vpf, TfToken const& polygonWinding) {
+        HdRprApiMeshTopology topology;
+        SplitPolygons(pointIndices, vpf, topology.pointIndices, topology.vpf);
+        ConvertIndices(&topology.pointIndices, topology.vpf, polygonWinding);
+
+        if (!normalIndices.empty()) {
+            SplitPolygons(normalIndices, vpf, topology.normalIndices);
+            ConvertIndices(&topology.normalIndices, topology.vpf, polygonWinding);
+        }
+
+        if (!uvIndices.empty()) {
+            SplitPolygons(uvIndices, vpf, topology.uvIndices);
+            ConvertIndices(&topology.uvIndices, topology.vpf, polygonWinding);
+        }
+
+        return topology;
+    }
+
+    rpr::Shape* CreateMesh(VtArray<VtVec3fArray> pointSamples, VtArray<VtVec3fArray> normalSamples,
+                           VtArray<VtVec2fArray> uvSamples, HdRprApiMeshTopology const& topology) {
+        if (!m_rprContext) {
+            return nullptr;
+        }
+
+        // Topology arrays are shared with the caller, access them through const references only to avoid detaching
+        VtIntArray const& newIndices = topology.pointIndices;
+        VtIntArray const& newVpf = topology.vpf;
 
         VtIntArray newNormalIndices;
         if (normalSamples.empty()) {
-            if (RprUsdIsHybrid(m_rprContextMetadata.pluginType)) {
+            if (RprUsdIsHybrid(m_rprContextMetadata.pluginType) && !pointSamples.empty()) {
                 // XXX (Hybrid): we need to generate geometry normals by ourself
                 VtVec3fArray normals;
                 normals.reserve(newVpf.size());
-                newNormalIndices.clear();
                 newNormalIndices.reserve(newIndices.size());
 
-                auto& points = pointSamples[0];
+                auto& points = pointSamples.cdata()[0];
 
                 size_t indicesOffset = 0u;
                 for (auto numVerticesPerFace : newVpf) {
@@ -540,7 +615,7 @@ public:
                         newNormalIndices.push_back(normals.size());
                     }
 
-                    auto indices = &newIndices[indicesOffset];
+                    auto indices = newIndices.cdata() + indicesOffset;
                     indicesOffset += numVerticesPerFace;
 
                     auto p0 = points[indices[0]];
@@ -558,36 +633,26 @@ public:
                 normalSamples.push_back(normals);
             }
         } else {
-            if (!normalIndices.empty()) {
-                SplitPolygons(normalIndices, vpf, newNormalIndices);
-                ConvertIndices(&newNormalIndices, newVpf, polygonWinding);
-            } else {
-                newNormalIndices = newIndices;
-            }
+            newNormalIndices = !topology.normalIndices.empty() ? topology.normalIndices : newIndices;
         }
 
         VtIntArray newUvIndices;
         if (uvSamples.empty()) {
-            if (RprUsdIsHybrid(m_rprContextMetadata.pluginType)) {
+            if (RprUsdIsHybrid(m_rprContextMetadata.pluginType) && !pointSamples.empty()) {
                 newUvIndices = newIndices;
-                VtVec2fArray uvs(pointSamples[0].size(), GfVec2f(0.0f));
+                VtVec2fArray uvs(pointSamples.cdata()[0].size(), GfVec2f(0.0f));
                 uvSamples.push_back(uvs);
             }
         } else {
-            if (!uvIndices.empty()) {
-                SplitPolygons(uvIndices, vpf, newUvIndices);
-                ConvertIndices(&newUvIndices, newVpf, polygonWinding);
-            } else {
-                newUvIndices = newIndices;
-            }
+            newUvIndices = !topology.uvIndices.empty() ? topology.uvIndices : newIndices;
         }
 
-        auto normalIndicesData = !newNormalIndices.empty() ? newNormalIndices.data() : newIndices.data();
+        rpr_int const* normalIndicesData = !newNormalIndices.empty() ? newNormalIndices.cdata() : newIndices.cdata();
         if (normalSamples.empty()) {
             normalIndicesData = nullptr;
         }
 
-        auto uvIndicesData = !newUvIndices.empty() ? newUvIndices.data() : uvIndices.data();
+        rpr_int const* uvIndicesData = !newUvIndices.empty() ? newUvIndices.cdata() : newIndices.cdata();
         if (uvSamples.empty()) {
             uvIndicesData = nullptr;
         }
@@ -625,16 +690,16 @@ public:
             if (pointSamples.empty()) {
                 return nullptr;
             }
-            pointsData = (rpr_float const*)pointSamples[0].cdata();
+            pointsData = (rpr_float const*)pointSamples.cdata()[0].cdata();
             numPoints = pointSamples[0].size();
 
             if (!normalSamples.empty()) {
-                normalsData = (rpr_float const*)normalSamples[0].data();
+                normalsData = (rpr_float const*)normalSamples.cdata()[0].cdata();
                 numNormals = normalSamples[0].size();
             }
             
             if (!uvSamples.empty()) {
-                uvsData = (rpr_float const*)uvSamples[0].data();
+                uvsData = (rpr_float const*)uvSamples.cdata()[0].cdata();
                 numUvs = uvSamples[0].size();
             }
         }
@@ -650,10 +715,10 @@ public:
             normalsData, numNormals, sizeof(GfVec3f),
             nullptr, 0, 0,
             1, &uvsData, &numUvs, &texCoordStride,
-            newIndices.data(), sizeof(rpr_int),
+            newIndices.cdata(), sizeof(rpr_int),
             normalIndicesData, sizeof(rpr_int),
             &uvIndicesData, &texCoordIdxStride,
-            newVpf.data(), newVpf.size(), meshProperties.data(), &status);
+            newVpf.cdata(), newVpf.size(), meshProperties.data(), &status);
         if (!mesh) {
             RPR_ERROR_CHECK(status, "Failed to create mesh");
             return nullptr;
@@ -673,19 +738,70 @@ public:
         }
 
         LockGuard rprLock(m_rprContext->GetMutex());
+        return CreateMeshInstanceLocked(prototype, false);
+    }
 
-        rpr::Status status;
-        auto mesh = m_rprContext->CreateShapeInstance(prototype, &status);
-        if (!mesh) {
-            RPR_ERROR_CHECK(status, "Failed to create mesh instance");
+    // Same as CreateMesh but meshes with identical geometry share one RPR shape:
+    // the first mesh is created as usual, all subsequent ones are instances of it.
+    // Shared meshes must not be subdivided, displaced or have vertex primvars, these are properties of the geometry
+    rpr::Shape* CreateSharedMesh(VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples,
+                                 VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology) {
+        if (!m_rprContext) {
             return nullptr;
         }
 
-        if (RPR_ERROR_CHECK(m_scene->Attach(mesh), "Failed to attach mesh to scene")) {
-            delete mesh;
+        // XXX (Hybrid): mesh visibility is emulated by detaching meshes from the scene,
+        // it cannot be used to hide the shared geometry of a released mesh
+        if (!m_isGeometryDeduplicationEnabled || RprUsdIsHybrid(m_rprContextMetadata.pluginType)) {
+            return CreateMesh(pointSamples, normalSamples, uvSamples, topology);
+        }
+
+        uint64_t hash = HashSamples(pointSamples, 0);
+        hash = HashSamples(normalSamples, hash);
+        hash = HashSamples(uvSamples, hash);
+        hash = HashArray(topology.pointIndices, hash);
+        hash = HashArray(topology.normalIndices, hash);
+        hash = HashArray(topology.uvIndices, hash);
+        hash = HashArray(topology.vpf, hash);
+
+        {
+            LockGuard rprLock(m_rprContext->GetMutex());
+
+            auto it = m_sharedGeometries.find(hash);
+            if (it != m_sharedGeometries.end()) {
+                auto& geometry = it->second;
+                if (geometry.pointSamples == pointSamples &&
+                    geometry.normalSamples == normalSamples &&
+                    geometry.uvSamples == uvSamples &&
+                    geometry.topology.pointIndices == topology.pointIndices &&
+                    geometry.topology.normalIndices == topology.normalIndices &&
+                    geometry.topology.uvIndices == topology.uvIndices &&
+                    geometry.topology.vpf == topology.vpf) {
+                    return CreateMeshInstanceLocked(geometry.base, true);
+                }
+                // Otherwise it's a hash collision, such a mesh is created as usual and is not shared
+            }
+        }
+
+        auto mesh = CreateMesh(pointSamples, normalSamples, uvSamples, topology);
+        if (!mesh) {
             return nullptr;
         }
-        m_dirtyFlags |= ChangeTracker::DirtyScene;
+
+        LockGuard rprLock(m_rprContext->GetMutex());
+
+        // Identical geometry might have been registered by a concurrent sync, this mesh stays unique then
+        SharedGeometry geometry;
+        geometry.base = mesh;
+        geometry.numUsers = 1;
+        geometry.pointSamples = pointSamples;
+        geometry.normalSamples = normalSamples;
+        geometry.uvSamples = uvSamples;
+        geometry.topology = topology;
+        if (m_sharedGeometries.emplace(hash, std::move(geometry)).second) {
+            m_sharedGeometryUsers.emplace(mesh, SharedGeometryUser{hash, false});
+        }
+
         return mesh;
     }
 
@@ -701,6 +817,11 @@ public:
 
         LockGuard rprLock(m_rprContext->GetMutex());
 
+        if (IsSharedGeometryInstance(mesh)) {
+            // Shared geometry is never subdivided
+            return;
+        }
+
         bool dirty = true;
 
         size_t dummy;
@@ -744,6 +865,10 @@ public:
 
         LockGuard rprLock(m_rprContext->GetMutex());
 
+        if (IsSharedGeometryInstance(mesh)) {
+            return;
+        }
+
         bool dirty = true;
 
         size_t dummy;
@@ -768,6 +893,39 @@ public:
         m_dirtyFlags |= ChangeTracker::DirtyScene;
     }
 
+    void SetMeshMaterialFaces(rpr::Shape* mesh, RprUsdMaterial const* material, VtIntArray const& faceIndices, VtIntArray const& vpf) {
+        if (!material) {
+            return;
+        }
+
+        // Polygons with more than four vertices are split into triangles by SplitPolygons,
+        // map the source faces to the range of RPR faces they were split into
+        std::vector<int> rprFaceOffsets(vpf.size() + 1, 0);
+        for (size_t i = 0; i < vpf.size(); ++i) {
+            int numRprFaces = (vpf[i] == 3 || vpf[i] == 4) ? 1 : std::max(vpf[i] - 2, 0);
+            rprFaceOffsets[i + 1] = rprFaceOffsets[i] + numRprFaces;
+        }
+
+        std::vector<rpr_int> rprFaceIndices;
+        rprFaceIndices.reserve(faceIndices.size());
+        for (int faceIndex : faceIndices) {
+            if (faceIndex < 0 || size_t(faceIndex) >= vpf.size()) {
+                continue;
+            }
+            for (int rprFaceIndex = rprFaceOffsets[faceIndex]; rprFaceIndex < rprFaceOffsets[faceIndex + 1]; ++rprFaceIndex) {
+                rprFaceIndices.push_back(rprFaceIndex);
+            }
+        }
+
+        if (rprFaceIndices.empty()) {
+            return;
+        }
+
+        LockGuard rprLock(m_rprContext->GetMutex());
+        material->AttachToFaces(mesh, rprFaceIndices.data(), rprFaceIndices.size());
+        m_dirtyFlags |= ChangeTracker::DirtyScene;
+    }
+
     void SetCurveMaterial(rpr::Curve* curve, RprUsdMaterial const* material) {
         LockGuard rprLock(m_rprContext->GetMutex());
         if (material) {
@@ -820,11 +978,81 @@ public:
         if (shape) {
             LockGuard rprLock(m_rprContext->GetMutex());
 
-            if (!RPR_ERROR_CHECK(m_scene->Detach(shape), "Failed to detach mesh from scene")) {
-                m_dirtyFlags |= ChangeTracker::DirtyScene;
-            };
-            delete shape;
+            auto userIt = m_sharedGeometryUsers.find(shape);
+            if (userIt != m_sharedGeometryUsers.end()) {
+                auto geometryIt = m_sharedGeometries.find(userIt->second.hash);
+                if (userIt->second.isDeduplicated) {
+                    --m_numDeduplicatedMeshes;
+                }
+                m_sharedGeometryUsers.erase(userIt);
+
+                auto& geometry = geometryIt->second;
+                if (--geometry.numUsers) {
+                    if (shape == geometry.base) {
+                        // Instances reference the base shape, keep it hidden until the last of them is released
+                        RprUsdMaterial::DetachFrom(shape);
+                        RPR_ERROR_CHECK(rprShapeSetVisibility(GetRprObject(shape), RPR_FALSE), "Failed to hide shared mesh");
+                        m_dirtyFlags |= ChangeTracker::DirtyScene;
+                        return;
+                    }
+                } else {
+                    if (shape != geometry.base) {
+                        ReleaseShapeLocked(geometry.base);
+                    }
+                    m_sharedGeometries.erase(geometryIt);
+                }
+            }
+
+            ReleaseShapeLocked(shape);
+        }
+    }
+
+    void ReleaseShapeLocked(rpr::Shape* shape) {
+        if (!RPR_ERROR_CHECK(m_scene->Detach(shape), "Failed to detach mesh from scene")) {
+            m_dirtyFlags |= ChangeTracker::DirtyScene;
+        };
+        delete shape;
+    }
+
+    rpr::Shape* CreateMeshInstanceLocked(rpr::Shape* prototype, bool isDeduplicated) {
+        // Instances of shared geometry are created from its base shape and keep it alive
+        SharedGeometry* sharedGeometry = nullptr;
+        uint64_t sharedGeometryHash = 0;
+        auto userIt = m_sharedGeometryUsers.find(prototype);
+        if (userIt != m_sharedGeometryUsers.end()) {
+            sharedGeometryHash = userIt->second.hash;
+            sharedGeometry = &m_sharedGeometries[sharedGeometryHash];
+            prototype = sharedGeometry->base;
+        }
+
+        rpr::Status status;
+        auto mesh = m_rprContext->CreateShapeInstance(prototype, &status);
+        if (!mesh) {
+            RPR_ERROR_CHECK(status, "Failed to create mesh instance");
+            return nullptr;
+        }
+
+        if (RPR_ERROR_CHECK(m_scene->Attach(mesh), "Failed to attach mesh to scene")) {
+            delete mesh;
+            return nullptr;
+        }
+        m_dirtyFlags |= ChangeTracker::DirtyScene;
+
+        if (sharedGeometry) {
+            ++sharedGeometry->numUsers;
+            m_sharedGeometryUsers.emplace(mesh, SharedGeometryUser{sharedGeometryHash, isDeduplicated});
+            if (isDeduplicated) {
+                ++m_numDeduplicatedMeshes;
+            }
         }
+
+        return mesh;
+    }
+
+    bool IsSharedGeometryInstance(rpr::Shape* mesh) const {
+        auto userIt = m_sharedGeometryUsers.find(mesh);
+        return userIt != m_sharedGeometryUsers.end() &&
+            m_sharedGeometries.at(userIt->second.hash).base != mesh;
     }
 
     void SetMeshVisibility(rpr::Shape* mesh, uint32_t visibilityMask) {
@@ -1524,7 +1752,7 @@ public:
     }
 
     void Release(RprUsdMaterial* material) {
-        if (material) {
+        if (material && RprUsdMaterialRegistry::GetInstance().ReleaseMaterial(material)) {
             LockGuard rprLock(m_rprContext->GetMutex());
             delete material;
         }
@@ -1777,8 +2005,6 @@ public:
             if (auto outputRb = registerAovBinding(aovBinding)) {
                 auto rprRenderBuffer = static_cast<HdRprRenderBuffer*>(aovBinding.renderBuffer);
                 outputRb->isMultiSampled = rprRenderBuffer->IsMultiSampled();
-                outputRb->mappedData = rprRenderBuffer->GetPointerForWriting();
-                outputRb->mappedDataSize = HdDataSizeOfFormat(rprRenderBuffer->GetFormat()) * rprRenderBuffer->GetWidth() * rprRenderBuffer->GetHeight();
             }
         }
     }
@@ -1787,41 +2013,171 @@ public:
         return m_aovBindings;
     }
 
-    void ResolveFramebuffers() {
-        auto startTime = std::chrono::high_resolution_clock::now();
+    size_t GetOutputDataSize(OutputRenderBuffer const& outRb) {
+        auto rprRenderBuffer = static_cast<HdRprRenderBuffer*>(outRb.aovBinding->renderBuffer);
+        return HdDataSizeOfFormat(rprRenderBuffer->GetFormat()) * rprRenderBuffer->GetWidth() * rprRenderBuffer->GetHeight();
+    }
 
+    // Resolves the current state of RPR framebuffers, applies post-processing filters
+    // and reads the result into host memory of each output render buffer.
+    // Must be called from the thread that renders because it touches RPR and RIF objects
+    void SnapshotFramebuffers(bool isFirstSample) {
+        RprUsdTimelineZone zone("SnapshotFramebuffers");
         m_resolveData.ForAllAovs([&](ResolveData::AovEntry& e) {
-            if (m_isFirstSample || e.isMultiSampled) {
+            if (isFirstSample || e.isMultiSampled) {
                 e.aov->Resolve();
             }
         });
 
         if (m_rifContext) {
+            RprUsdTimelineZone filtersZone("ExecuteRifFilters");
             m_rifContext->ExecuteCommandQueue();
         }
 
         for (auto& outRb : m_outputRenderBuffers) {
-            if (outRb.mappedData && (m_isFirstSample || outRb.isMultiSampled)) {
-                outRb.rprAov->GetData(outRb.mappedData, outRb.mappedDataSize);
+            if (!isFirstSample && !outRb.isMultiSampled) {
+                continue;
             }
+
+            outRb.isHostDataValid = outRb.rprAov->ReadData(&outRb.hostData, GetOutputDataSize(outRb));
         }
+    }
+
+    // Converts the snapshot into the format of the bound render buffers and flips them.
+    // Works on host memory only, so it can run concurrently with rendering
+    void ReadbackFramebuffers(bool isFirstSample) {
+        RprUsdTimelineZone zone("ReadbackFramebuffers");
+
+        for (auto& outRb : m_outputRenderBuffers) {
+            if ((!isFirstSample && !outRb.isMultiSampled) || !outRb.isHostDataValid) {
+                continue;
+            }
+
+            auto rprRenderBuffer = static_cast<HdRprRenderBuffer*>(outRb.aovBinding->renderBuffer);
+            if (auto data = rprRenderBuffer->GetPointerForWriting()) {
+                outRb.rprAov->ConvertData(outRb.hostData, data, GetOutputDataSize(outRb));
+                rprRenderBuffer->SwapBuffers();
+            }
+        }
+    }
+
+    void ResolveFramebuffers() {
+        if (m_isAsyncResolveActive) {
+            ResolveFramebuffersAsync();
+            return;
+        }
+
+        RprUsdTimelineZone zone("ResolveFramebuffers");
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        SnapshotFramebuffers(m_isFirstSample);
+        ReadbackFramebuffers(m_isFirstSample);
 
         m_isFirstSample = false;
 
         auto resolveTime = std::chrono::high_resolution_clock::now().time_since_epoch() - startTime.time_since_epoch();
-        m_frameResolveTotalTime += resolveTime;
+        m_frameResolveTotalTime += resolveTime.count();
 
         if (m_resolveMode == kResolveInRenderUpdateCallback) {
             // When RUC is enabled, we do resolves in between of rendering on the same thread
-            // TODO (optimization): move resolves in a background thread (makes sense for non-interactive, GPU-only rendering)
-            //
             m_frameRenderTotalTime -= resolveTime;
         }
     }
 
+    // In async mode, the render thread only snapshots framebuffers into host memory,
+    // conversion into render buffers happens on the resolve thread.
+    // While the resolve thread is busy with the previous snapshot, new resolves are skipped
+    // so that rendering never waits for the readback
+    void ResolveFramebuffersAsync() {
+        {
+            std::unique_lock<std::mutex> lock(m_asyncResolve.mutex);
+            if (m_asyncResolve.isBusy) {
+                m_asyncResolve.isSkipped = true;
+                return;
+            }
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        SnapshotFramebuffers(m_isFirstSample);
+
+        auto snapshotTime = std::chrono::high_resolution_clock::now().time_since_epoch() - startTime.time_since_epoch();
+        if (m_resolveMode == kResolveInRenderUpdateCallback) {
+            m_frameRenderTotalTime -= snapshotTime;
+        }
+
+        if (!m_asyncResolve.thread.joinable()) {
+            m_asyncResolve.thread = std::thread([this]() { AsyncResolveThreadFunc(); });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_asyncResolve.mutex);
+            m_frameResolveTotalTime += snapshotTime.count();
+            m_asyncResolve.isFirstSample = m_isFirstSample;
+            m_asyncResolve.isSkipped = false;
+            m_asyncResolve.isBusy = true;
+        }
+        m_asyncResolve.cv.notify_all();
+
+        m_isFirstSample = false;
+    }
+
+    void AsyncResolveThreadFunc() {
+        std::unique_lock<std::mutex> lock(m_asyncResolve.mutex);
+        while (true) {
+            m_asyncResolve.cv.wait(lock, [this]() { return m_asyncResolve.isBusy || m_asyncResolve.isStopRequested; });
+            if (m_asyncResolve.isStopRequested) {
+                break;
+            }
+
+            bool isFirstSample = m_asyncResolve.isFirstSample;
+            lock.unlock();
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+            try {
+                ReadbackFramebuffers(isFirstSample);
+            } catch (std::runtime_error const& e) {
+                TF_RUNTIME_ERROR("Failed to resolve framebuffers: %s", e.what());
+            }
+            auto readbackTime = std::chrono::high_resolution_clock::now().time_since_epoch() - startTime.time_since_epoch();
+
+            lock.lock();
+            m_frameResolveTotalTime += readbackTime.count();
+            m_asyncResolve.isBusy = false;
+            m_asyncResolve.cv.notify_all();
+        }
+    }
+
+    // Waits for the in-flight readback, returns whether any resolve was skipped meanwhile
+    bool WaitForAsyncResolve() {
+        if (!m_isAsyncResolveActive) {
+            return false;
+        }
+
+        bool isSkipped;
+        {
+            std::unique_lock<std::mutex> lock(m_asyncResolve.mutex);
+            m_asyncResolve.cv.wait(lock, [this]() { return !m_asyncResolve.isBusy; });
+            isSkipped = m_asyncResolve.isSkipped;
+            m_asyncResolve.isSkipped = false;
+        }
+
+        m_isAsyncResolveActive = false;
+        return isSkipped;
+    }
+
+    // Waits for the in-flight readback and makes sure render buffers hold the latest rendered state
+    void FinishAsyncResolve() {
+        if (WaitForAsyncResolve()) {
+            ResolveFramebuffers();
+        }
+    }
+
     void Update() {
         auto rprRenderParam = static_cast<HdRprRenderParam*>(m_delegate->GetRenderParam());
 
+        bool isEdited = (m_dirtyFlags & (ChangeTracker::DirtyScene | ChangeTracker::DirtyViewport)) != 0 || IsCameraChanged();
+
         // In case there is no Lights in scene - create default
         if (m_numLights == 0) {
             AddDefaultLight();
@@ -1897,8 +2253,10 @@ public:
                 clearAovs = activeRenderQuality != m_currentRenderQuality;
             }
 
+            UpdateAutoInteractiveMode(*config, isEdited);
             UpdateSettings(*config);
             config->ResetDirty();
+            m_isAutoInteractiveDirty = false;
         }
         UpdateCamera(cameraMode, aspectRatioPolicy, instantaneousShutter);
         UpdateAovs(rprRenderParam, tonemap, gamma, clearAovs);
@@ -1909,6 +2267,70 @@ public:
         }
     }
 
+    // Switches to interactive parameters while edits arrive in quick succession and back to full quality once they stop.
+    // To avoid flip-flopping, entering requires several consecutive rapid edits
+    // while leaving requires no edits for the idle time that is never shorter than the edit interval
+    void UpdateAutoInteractiveMode(HdRprConfig const& preferences, bool isEdited) {
+        static const int kNumRapidEditsToEnter = 2;
+
+        bool isEnabled = preferences.GetQualityInteractiveAutoEnable() &&
+            !preferences.GetInteractiveMode() &&
+            preferences.GetRenderMode() != HdRprRenderModeTokens->batch;
+
+        auto editInterval = std::chrono::milliseconds(preferences.GetQualityInteractiveAutoEditInterval());
+        m_autoInteractiveIdleTime = std::max(editInterval, std::chrono::milliseconds(preferences.GetQualityInteractiveAutoIdleTime()));
+
+        auto now = std::chrono::steady_clock::now();
+        bool isAutoInteractive = m_isAutoInteractive;
+        if (!isEnabled) {
+            isAutoInteractive = false;
+            m_numRapidEdits = 0;
+        } else if (isEdited) {
+            if (now - m_lastEditTime <= editInterval) {
+                ++m_numRapidEdits;
+            } else {
+                m_numRapidEdits = 0;
+            }
+            m_lastEditTime = now;
+
+            if (m_numRapidEdits >= kNumRapidEditsToEnter) {
+                isAutoInteractive = true;
+            }
+        } else if (isAutoInteractive && now - m_lastEditTime >= m_autoInteractiveIdleTime) {
+            isAutoInteractive = false;
+            m_numRapidEdits = 0;
+        }
+
+        if (m_isAutoInteractive != isAutoInteractive) {
+            m_isAutoInteractive = isAutoInteractive;
+            m_isAutoInteractiveDirty = true;
+        }
+    }
+
+    bool IsInteractiveModeDirty(HdRprConfig const& preferences) const {
+        return preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) || m_isAutoInteractiveDirty;
+    }
+
+    bool IsAutoInteractiveIdle() const {
+        return m_isAutoInteractive && std::chrono::steady_clock::now() - m_lastEditTime >= m_autoInteractiveIdleTime;
+    }
+
+    // Returns true when edits went idle while in automatic interactive mode and the frame should be rendered again in full quality.
+    // Returns false if the render was stopped by new edits in the meantime
+    bool WaitForAutoInteractiveIdle(HdRprRenderThread* renderThread) {
+        if (!m_isAutoInteractive) {
+            return false;
+        }
+
+        while (!renderThread->IsStopRequested()) {
+            if (IsAutoInteractiveIdle()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
     rpr_uint GetRprRenderMode(TfToken const& mode) {
         static std::map<TfToken, rpr_render_mode> s_mapping = {
             {HdRprCoreRenderModeTokens->GlobalIllumination, RPR_RENDER_MODE_GLOBAL_ILLUMINATION},
@@ -2047,9 +2469,9 @@ public:
             m_dirtyFlags |= ChangeTracker::DirtyScene;
         }
 
-        if ((preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) ||
+        if ((IsInteractiveModeDirty(preferences) ||
             preferences.IsDirty(HdRprConfig::DirtyInteractiveQuality)) || force) {
-            m_isInteractive = preferences.GetInteractiveMode();
+            m_isInteractive = preferences.GetInteractiveMode() || m_isAutoInteractive;
             auto maxRayDepth = m_isInteractive ? preferences.GetQualityInteractiveRayDepth() : preferences.GetQualityRayDepth();
             RPR_ERROR_CHECK(m_rprContext->SetParameter(RPR_CONTEXT_MAX_RECURSION, maxRayDepth), "Failed to set max recursion");
 
@@ -2064,7 +2486,7 @@ public:
                 RPR_ERROR_CHECK(m_rprContext->SetParameter(RPR_CONTEXT_PREVIEW, uint32_t(enableDownscale)), "Failed to set preview mode");
             }
 
-            if (preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) || m_isInteractive) {
+            if (IsInteractiveModeDirty(preferences) || m_isInteractive) {
                 m_dirtyFlags |= ChangeTracker::DirtyScene;
             }
         }
@@ -2160,13 +2582,13 @@ public:
                 m_dirtyFlags |= ChangeTracker::DirtyScene;
             }
 
-            if ((preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) ||
+            if ((IsInteractiveModeDirty(preferences) ||
                 preferences.IsDirty(HdRprConfig::DirtyInteractiveQuality)) || force) {
-                m_isInteractive = preferences.GetInteractiveMode();
+                m_isInteractive = preferences.GetInteractiveMode() || m_isAutoInteractive;
                 auto maxRayDepth = m_isInteractive ? preferences.GetQualityInteractiveRayDepth() : preferences.GetQualityRayDepth();
                 RPR_ERROR_CHECK(m_rprContext->SetParameter(RPR_CONTEXT_MAX_RECURSION, maxRayDepth), "Failed to set max recursion");
 
-                if (preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) || m_isInteractive) {
+                if (IsInteractiveModeDirty(preferences) || m_isInteractive) {
                     m_dirtyFlags |= ChangeTracker::DirtyScene;
                 }
 
@@ -2259,9 +2681,9 @@ public:
             m_dirtyFlags |= ChangeTracker::DirtyScene;
         }
 
-        if ((preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) ||
+        if ((IsInteractiveModeDirty(preferences) ||
             preferences.IsDirty(HdRprConfig::DirtyInteractiveQuality)) || force) {
-            m_isInteractive = preferences.GetInteractiveMode();
+            m_isInteractive = preferences.GetInteractiveMode() || m_isAutoInteractive;
             auto maxRayDepth = m_isInteractive ? preferences.GetQualityInteractiveRayDepth() : preferences.GetQualityRayDepth();
             RPR_ERROR_CHECK(m_rprContext->SetParameter(RPR_CONTEXT_MAX_RECURSION, maxRayDepth), "Failed to set max recursion");
 
@@ -2276,7 +2698,7 @@ public:
                 RPR_ERROR_CHECK(m_rprContext->SetParameter(RPR_CONTEXT_PREVIEW, uint32_t(enableDownscale)), "Failed to set preview mode");
             }
 
-            if (preferences.IsDirty(HdRprConfig::DirtyInteractiveMode) || m_isInteractive) {
+            if (IsInteractiveModeDirty(preferences) || m_isInteractive) {
                 m_dirtyFlags |= ChangeTracker::DirtyScene;
             }
         }
@@ -2306,6 +2728,7 @@ public:
 
         if (preferences.IsDirty(HdRprConfig::DirtySession) || force) {
             m_isProgressive = preferences.GetProgressive();
+            m_isAsyncResolveEnabled = preferences.GetAsyncResolve();
             bool isBatch = preferences.GetRenderMode() == HdRprRenderModeTokens->batch;
             if (m_isBatch != isBatch) {
                 m_isBatch = isBatch;
@@ -2623,8 +3046,7 @@ public:
             if ((m_dirtyFlags & ChangeTracker::DirtyAOVBindings) == 0) {
                 for (auto& outputRb : m_outputRenderBuffers) {
                     auto rprRenderBuffer = static_cast<HdRprRenderBuffer*>(outputRb.aovBinding->renderBuffer);
-                    outputRb.mappedData = rprRenderBuffer->GetPointerForWriting();
-                    outputRb.mappedDataSize = HdDataSizeOfFormat(rprRenderBuffer->GetFormat()) * rprRenderBuffer->GetWidth() * rprRenderBuffer->GetHeight();
+                    outputRb.isMultiSampled = rprRenderBuffer->IsMultiSampled();
                 }
             }
         }
@@ -2650,7 +3072,7 @@ public:
             m_activePixels = -1;
             m_isFirstSample = true;
             m_frameRenderTotalTime = {};
-            m_frameResolveTotalTime = {};
+            m_frameResolveTotalTime = 0;
 
             // Always start from RPR_CONTEXT_ITERATIONS=1 to be able to resolve singlesampled AOVs correctly
             m_numSamplesPerIter = 1;
@@ -3097,6 +3519,18 @@ public:
             cd.SetForTile(m_camera, m_hdCamera, windowNDC);
         }
 
+        // Readback of intermediate results can be overlapped with rendering only in interactive mode,
+        // in batch mode the host app expects render buffers to be up to date once resolve request is handled
+        m_isAsyncResolveActive = m_isAsyncResolveEnabled && m_isInteractive &&
+            m_rprContextMetadata.pluginType == kPluginNorthstar;
+
+        // The resolve thread must be idle once we leave, even on errors,
+        // because render buffers and AOVs may be released right after that
+        struct AsyncResolveGuard {
+            HdRprApiImpl* rprApi;
+            ~AsyncResolveGuard() { rprApi->WaitForAsyncResolve(); }
+        } asyncResolveGuard{this};
+
         while (!IsConverged()) {
             // In interactive mode, always render at least one frame, otherwise
             // disturbing full-screen-flickering will be visible or
@@ -3108,6 +3542,13 @@ public:
                 break;
             }
 
+            if (IsAutoInteractiveIdle()) {
+                // Edits have stopped, the frame is restarted in full quality
+                break;
+            }
+
+            RprUsdTimelineZone iterationZone("RenderIteration");
+
             IncrementFrameCount(IsAdaptiveSamplingEnabled());
 
             if (progressivelyIncreaseSamplesPerIter) {
@@ -3163,6 +3604,9 @@ public:
 
             m_numSamples += m_numSamplesPerIter;
         }
+
+        FinishAsyncResolve();
+
         if (tilingOn) {
             cd.Restore(m_camera);
         }
@@ -3247,6 +3691,10 @@ public:
 #endif // HDRPR_ENABLE_VULKAN_INTEROP_SUPPORT
                     } else {
                         RenderImpl(renderThread);
+
+                        if (WaitForAutoInteractiveIdle(renderThread)) {
+                            return RenderFrame(renderThread);
+                        }
                     }
                 }
                 SaveCryptomatte();
@@ -3502,12 +3950,29 @@ Don't show this message again?
 #endif // RPR_LOADSTORE_AVAILABLE
     }
 
+    void SetTextureLoadOptions(RprUsdTextureLoadOptions const& options) {
+        m_textureLoadOptions = options;
+        if (m_imageCache) {
+            m_imageCache->SetTextureLoadOptions(options);
+        }
+    }
+
+    void SetImageCacheRetentionBudget(size_t numBytes) {
+        m_imageCacheRetentionBudget = numBytes;
+        if (m_imageCache && m_imageCache->GetRetentionBudget() != numBytes) {
+            m_imageCache->SetRetentionBudget(numBytes);
+        }
+    }
+
     void CommitResources() {
         if (!m_rprContext) {
             return;
         }
 
         RprUsdMaterialRegistry::GetInstance().CommitResources(m_imageCache.get());
+
+        // Images of the materials released during the sync are destroyed here, where RPR context is not locked
+        m_imageCache->DestroyReleasedImages();
     }
 
     void Resolve(SdfPath const& aovId) {
@@ -3540,6 +4005,49 @@ Don't show this message again?
                 rb->SetConverged(true);
             }
         }
+
+        WriteRenderStats();
+    }
+
+    // Allows tracking sync and render throughput of headless renders (e.g. husk with RPRUSD_CPU_ONLY=1)
+    void WriteRenderStats() {
+        static const std::string renderStatsFilepath = TfGetEnvSetting(HDRPR_RENDER_STATS_FILE);
+        if (renderStatsFilepath.empty()) {
+            return;
+        }
+
+        auto stats = GetRenderStats();
+
+        json statsJson;
+        statsJson["plugin"] = TfEnum::GetName(m_rprContextMetadata.pluginType);
+        statsJson["gpus"] = GetGpuUsedNames();
+        statsJson["cpuThreads"] = GetCpuThreadCountUsed();
+        statsJson["isInteractive"] = m_isInteractive;
+        statsJson["isConverged"] = IsConverged();
+        statsJson["numSamples"] = m_numSamples;
+        statsJson["syncTime"] = stats.syncTime;
+        statsJson["cacheCreationTime"] = stats.cacheCreationTime;
+        statsJson["firstIterationRenderTime"] = m_firstIterationRenderTime;
+        statsJson["totalRenderTime"] = stats.totalRenderTime;
+        statsJson["frameRenderTotalTime"] = stats.frameRenderTotalTime;
+        statsJson["frameResolveTotalTime"] = stats.frameResolveTotalTime;
+        statsJson["samplesPerSecond"] = stats.frameRenderTotalTime > 0.0 ? m_numSamples / stats.frameRenderTotalTime : 0.0;
+        statsJson["numDeduplicatedMaterials"] = stats.numDeduplicatedMaterials;
+        statsJson["numDeduplicatedMeshes"] = stats.numDeduplicatedMeshes;
+        statsJson["imageCache"] = {
+            {"numHits", stats.imageCacheNumHits},
+            {"numMisses", stats.imageCacheNumMisses},
+            {"numEvictions", stats.imageCacheNumEvictions},
+            {"numRetainedImages", stats.imageCacheNumRetainedImages},
+            {"retainedDataSize", stats.imageCacheRetainedDataSize},
+        };
+
+        std::ofstream statsFile(renderStatsFilepath, std::ios_base::app);
+        if (!statsFile.is_open()) {
+            TF_RUNTIME_ERROR("Failed to open render stats file: %s", renderStatsFilepath.c_str());
+            return;
+        }
+        statsFile << statsJson.dump() << std::endl;
     }
 
     void AbortRender() {
@@ -3576,9 +4084,12 @@ Don't show this message again?
         }
         stats.percentDone = 100.0 * progress;
 
+        // Accumulated by the render and the resolve threads
+        Duration frameResolveTotalTime(m_frameResolveTotalTime.load());
+
         if (m_numSamples > 0) {
             double numRenderedSamples = progress * m_maxSamples;
-            auto resolveTime = m_frameResolveTotalTime / numRenderedSamples;
+            auto resolveTime = frameResolveTotalTime / numRenderedSamples;
             auto renderTime = m_frameRenderTotalTime / numRenderedSamples;
 
             using FloatingPointSecond = std::chrono::duration<double>;
@@ -3587,12 +4098,23 @@ Don't show this message again?
         }
 
         stats.frameRenderTotalTime = (double)m_frameRenderTotalTime.count() / 1000000000.0;
-        stats.frameResolveTotalTime = (double)m_frameResolveTotalTime.count() / 1000000000.0;
+        stats.frameResolveTotalTime = (double)frameResolveTotalTime.count() / 1000000000.0;
         stats.totalRenderTime = (double)(std::chrono::high_resolution_clock::now().time_since_epoch() - m_startTime.time_since_epoch()).count() / 1000000000.0;
 
         stats.syncTime = (double)m_syncTime.count() / 1000000000.0;
         stats.cacheCreationTime = (double)m_cacheCreationTime.count() / 1000000000.0;
 
+        stats.numDeduplicatedMaterials = RprUsdMaterialRegistry::GetInstance().GetNumDeduplicatedMaterials(m_rprContext.get());
+        stats.numDeduplicatedMeshes = m_numDeduplicatedMeshes;
+        if (m_imageCache) {
+            auto imageCacheStats = m_imageCache->GetStats();
+            stats.imageCacheNumHits = imageCacheStats.numHits;
+            stats.imageCacheNumMisses = imageCacheStats.numMisses;
+            stats.imageCacheNumEvictions = imageCacheStats.numEvictions;
+            stats.imageCacheNumRetainedImages = imageCacheStats.numRetainedImages;
+            stats.imageCacheRetainedDataSize = imageCacheStats.retainedDataSize;
+        }
+
         return stats;
     }
 
@@ -3644,6 +4166,11 @@ Don't show this message again?
         return m_rprContextMetadata.pluginType == kPluginNorthstar || m_rprContextMetadata.pluginType == kPluginHybridPro;
     }
 
+    bool IsPerFaceMaterialSupported() const {
+        // XXX (RPR): rprShapeSetMaterialFaces is implemented only in Northstar
+        return m_rprContext && m_rprContextMetadata.pluginType == kPluginNorthstar;
+    }
+
     TfToken const& GetCurrentRenderQuality() const {
         return m_currentRenderQuality;
     }
@@ -3889,6 +4416,8 @@ private:
         }
 
         m_imageCache.reset(new RprUsdImageCache(m_rprContext.get()));
+        m_imageCache->SetTextureLoadOptions(m_textureLoadOptions);
+        m_imageCache->SetRetentionBudget(m_imageCacheRetentionBudget);
 
         m_isAbortingEnabled.store(false);
     }
@@ -4476,6 +5005,7 @@ private:
                 size_t size = HdDataSizeOfFormat(colorRb->GetFormat()) * colorRb->GetWidth() * colorRb->GetHeight();
                 if (auto colorRbData = colorRb->GetPointerForWriting()) {
                     std::memcpy(colorRbData, mappedData, size);
+                    colorRb->SwapBuffers();
                 }
 
                 RIF_ERROR_CHECK(rifImageUnmap(blitFilter->GetOutput(), mappedData), "Failed to unmap rif image");
@@ -4536,6 +5066,29 @@ private:
     RprUsdContextMetadata m_rprContextMetadata;
     bool m_isOutputFlipped;
 
+    // Geometry shared between meshes by shape instancing, guarded by the RPR context mutex
+    struct SharedGeometry {
+        rpr::Shape* base = nullptr;
+
+        // Number of meshes that use the base shape either directly or through an instance
+        size_t numUsers = 0;
+
+        // Used to tell apart different geometries with the same hash
+        VtArray<VtVec3fArray> pointSamples;
+        VtArray<VtVec3fArray> normalSamples;
+        VtArray<VtVec2fArray> uvSamples;
+        HdRprApiMeshTopology topology;
+    };
+    std::unordered_map<uint64_t, SharedGeometry> m_sharedGeometries;
+
+    struct SharedGeometryUser {
+        uint64_t hash;
+        bool isDeduplicated;
+    };
+    std::unordered_map<rpr::Shape*, SharedGeometryUser> m_sharedGeometryUsers;
+    std::atomic<size_t> m_numDeduplicatedMeshes{0};
+    bool m_isGeometryDeduplicationEnabled = TfGetEnvSetting(HDRPR_GEOMETRY_DEDUPLICATION);
+
     float m_firstIterationRenderTime = 0.0f;
 
     std::unique_ptr<rif::Context> m_rifContext;
@@ -4543,6 +5096,8 @@ private:
     std::unique_ptr<rpr::Scene> m_scene;
     std::unique_ptr<rpr::Camera> m_camera;
     std::unique_ptr<RprUsdImageCache> m_imageCache;
+    RprUsdTextureLoadOptions m_textureLoadOptions;
+    size_t m_imageCacheRetentionBudget = 0;
 
     std::shared_ptr<HdRprApiColorAov> m_colorAov;
     std::map<TfToken, std::weak_ptr<HdRprApiAov>> m_aovRegistry;
@@ -4566,8 +5121,10 @@ private:
         std::shared_ptr<HdRprApiAov> rprAov;
 
         bool isMultiSampled;
-        void* mappedData;
-        size_t mappedDataSize;
+
+        // Snapshot of rprAov data, see SnapshotFramebuffers
+        std::vector<char> hostData;
+        bool isHostDataValid = false;
     };
     std::vector<OutputRenderBuffer> m_outputRenderBuffers;
 
@@ -4647,6 +5204,18 @@ private:
     } m_resolveMode = kResolveAfterRender;
     bool m_isFirstSample = true;
 
+    bool m_isAsyncResolveEnabled = true;
+    bool m_isAsyncResolveActive = false;
+    struct AsyncResolveState {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool isBusy = false;
+        bool isSkipped = false;
+        bool isFirstSample = false;
+        bool isStopRequested = false;
+    } m_asyncResolve;
+
     GfVec2i m_viewportSize = GfVec2i(0);
     GfMatrix4d m_cameraProjectionMatrix = GfMatrix4d(1.f);
     HdRprCamera const* m_hdCamera = nullptr;
@@ -4659,6 +5228,13 @@ private:
     uint32_t m_frameCount = 0;
 
     bool m_isInteractive = false;
+
+    // Automatic interactive mode state, see UpdateAutoInteractiveMode
+    bool m_isAutoInteractive = false;
+    bool m_isAutoInteractiveDirty = false;
+    int m_numRapidEdits = 0;
+    std::chrono::steady_clock::time_point m_lastEditTime;
+    std::chrono::steady_clock::duration m_autoInteractiveIdleTime{};
     int m_numSamples = 0;
     int m_numSamplesPerIter = 0;
     int m_activePixels = -1;
@@ -4670,7 +5246,7 @@ private:
 
     using Duration = std::chrono::high_resolution_clock::duration;
     Duration m_frameRenderTotalTime;
-    Duration m_frameResolveTotalTime;
+    std::atomic<Duration::rep> m_frameResolveTotalTime{0};
     std::chrono::high_resolution_clock::time_point m_startTime = {};
     std::chrono::high_resolution_clock::time_point m_syncStartTime = {};
     Duration m_syncTime;
@@ -4718,114 +5294,429 @@ private:
     GfMatrix4d m_unitSizeTransform = GfMatrix4d(1.0);
 };
 
-HdRprApi::HdRprApi(HdRprDelegate* delegate) : m_impl(new HdRprApiImpl(delegate)) {
+// Stands in for RPR in null render mode, see HDRPR_NULL_RENDER.
+// Create calls return placeholder handles that HdRprApi never passes to RPR, so prims go through
+// the same per-object updates as with a real context, and the number of live objects is tracked per type
+class HdRprApiNullBackend {
+public:
+    ~HdRprApiNullBackend() {
+        if (!m_objects.empty()) {
+            TF_WARN("HDRPR_NULL_RENDER: %zu objects were not released", m_objects.size());
+        }
+    }
+
+    // RPR objects can not exist without a context: the handle points to a placeholder allocation and is never dereferenced
+    template <typename T>
+    T* CreateHandle(const char* type) {
+        auto storage = std::make_shared<char>();
+        return reinterpret_cast<T*>(Add(type, storage.get(), std::move(storage)));
+    }
+
+    // Types that are owned by hdRpr are allocated for real because prims access them
+    HdRprApiEnvironmentLight* CreateEnvironmentLight() {
+        auto light = std::make_shared<HdRprApiEnvironmentLight>();
+        return static_cast<HdRprApiEnvironmentLight*>(Add("EnvironmentLight", light.get(), light));
+    }
+
+    HdRprApiVolume* CreateVolume() {
+        auto volume = std::make_shared<HdRprApiVolume>();
+        return static_cast<HdRprApiVolume*>(Add("Volume", volume.get(), volume));
+    }
 
+    RprUsdMaterial* CreateMaterial() {
+        auto material = std::make_shared<RprUsdMaterial>();
+        return static_cast<RprUsdMaterial*>(Add("Material", material.get(), material));
+    }
+
+    void Release(void const* handle) {
+        if (!handle) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_objects.find(handle);
+        if (it == m_objects.end()) {
+            TF_CODING_ERROR("HDRPR_NULL_RENDER: releasing unknown object");
+            return;
+        }
+        m_typeStats[it->second.type].numAlive--;
+        m_objects.erase(it);
+    }
+
+    json GetStats() {
+        json statsJson;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_typeStats) {
+            auto& entryJson = statsJson[entry.first];
+            entryJson["numCreated"] = entry.second.numCreated;
+            entryJson["numAlive"] = entry.second.numAlive;
+            entryJson["maxNumAlive"] = entry.second.maxNumAlive;
+        }
+        return statsJson;
+    }
+
+private:
+    void* Add(const char* type, void* handle, std::shared_ptr<void> storage) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_objects.emplace(handle, Object{type, std::move(storage)});
+
+        auto& typeStats = m_typeStats[type];
+        typeStats.numCreated++;
+        typeStats.numAlive++;
+        typeStats.maxNumAlive = std::max(typeStats.maxNumAlive, typeStats.numAlive);
+        return handle;
+    }
+
+    struct Object {
+        const char* type;
+        std::shared_ptr<void> storage;
+    };
+
+    struct TypeStats {
+        size_t numCreated = 0;
+        size_t numAlive = 0;
+        size_t maxNumAlive = 0;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<void const*, Object> m_objects;
+    std::map<std::string, TypeStats> m_typeStats;
+};
+
+// Accumulates statistics of HdRprApi entry points, see HDRPR_API_RECORD_FILE.
+// Together with HDRPR_NULL_RENDER it allows to profile the delegate overhead without RPR
+class HdRprApiRecorder {
+public:
+    class Scope {
+    public:
+        Scope(HdRprApiRecorder* recorder, const char* entryPoint, size_t numBytes)
+            : m_recorder(recorder)
+            , m_entryPoint(entryPoint)
+            , m_numBytes(numBytes) {
+            if (m_recorder) {
+                m_startTime = std::chrono::high_resolution_clock::now();
+            }
+        }
+
+        ~Scope() {
+            if (m_recorder) {
+                m_recorder->Record(m_entryPoint, m_numBytes, std::chrono::high_resolution_clock::now() - m_startTime);
+            }
+        }
+
+    private:
+        HdRprApiRecorder* m_recorder;
+        const char* m_entryPoint;
+        size_t m_numBytes;
+        std::chrono::high_resolution_clock::time_point m_startTime;
+    };
+
+    void Record(const char* entryPoint, size_t numBytes, std::chrono::high_resolution_clock::duration time) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entry = m_entries[entryPoint];
+        entry.numCalls++;
+        entry.numBytes += numBytes;
+        entry.time += std::chrono::duration<double>(time).count();
+    }
+
+    void Write(std::string const& filepath, HdRprApiNullBackend* nullBackend) {
+        json recordJson;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& entry : m_entries) {
+                auto& entryJson = recordJson["entryPoints"][entry.first];
+                entryJson["numCalls"] = entry.second.numCalls;
+                entryJson["numBytes"] = entry.second.numBytes;
+                entryJson["time"] = entry.second.time;
+            }
+        }
+
+        if (nullBackend) {
+            recordJson["objects"] = nullBackend->GetStats();
+        }
+
+        std::ofstream recordFile(filepath);
+        if (!recordFile.is_open()) {
+            TF_RUNTIME_ERROR("Failed to open HdRprApi record file: %s", filepath.c_str());
+            return;
+        }
+        recordFile << recordJson.dump(4) << std::endl;
+    }
+
+private:
+    struct Entry {
+        size_t numCalls = 0;
+        size_t numBytes = 0;
+        double time = 0.0;
+    };
+
+    std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+};
+
+namespace {
+
+template <typename T>
+size_t GetByteSize(VtArray<T> const& array) {
+    return array.size() * sizeof(T);
+}
+
+template <typename T>
+size_t GetByteSize(VtArray<VtArray<T>> const& samples) {
+    size_t numBytes = 0;
+    for (auto& sample : samples) {
+        numBytes += GetByteSize(sample);
+    }
+    return numBytes;
+}
+
+template <typename T, typename... Args>
+size_t GetByteSize(T const& first, Args const&... rest) {
+    return GetByteSize(first) + GetByteSize(rest...);
+}
+
+} // namespace anonymous
+
+HdRprApi::HdRprApi(HdRprDelegate* delegate) : m_impl(new HdRprApiImpl(delegate)) {
+    if (!TfGetEnvSetting(HDRPR_API_RECORD_FILE).empty()) {
+        m_recorder = new HdRprApiRecorder;
+    }
+    if (TfGetEnvSetting(HDRPR_NULL_RENDER)) {
+        m_nullBackend = new HdRprApiNullBackend;
+    }
 }
 
 HdRprApi::~HdRprApi() {
     delete m_impl;
+
+    if (m_recorder) {
+        m_recorder->Write(TfGetEnvSetting(HDRPR_API_RECORD_FILE), m_nullBackend);
+        delete m_recorder;
+    }
+    delete m_nullBackend;
+
+    // Sync, resolve and render zones of this delegate have finished by now
+    RprUsdTimeline::Flush();
 }
 
 rpr::Shape* HdRprApi::CreateMesh(VtArray<VtVec3fArray> const& pointSamples, VtIntArray const& pointIndexes, VtArray<VtVec3fArray> const& normalSamples, VtIntArray const& normalIndexes, VtArray<VtVec2fArray> const& uvSamples, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMesh", GetByteSize(pointSamples, pointIndexes, normalSamples, normalIndexes, uvSamples, uvIndexes, vpf));
+    if (m_nullBackend) {
+        m_impl->PrepareMeshTopology(pointIndexes, normalIndexes, uvIndexes, vpf, polygonWinding);
+        return m_nullBackend->CreateHandle<rpr::Shape>("Mesh");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateMesh(pointSamples, pointIndexes, normalSamples, normalIndexes, uvSamples, uvIndexes, vpf, polygonWinding);
 }
 
 rpr::Shape* HdRprApi::CreateMesh(VtVec3fArray const& points, VtIntArray const& pointIndexes, VtVec3fArray const& normals, VtIntArray const& normalIndexes, VtVec2fArray const& uvs, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMesh", GetByteSize(points, pointIndexes, normals, normalIndexes, uvs, uvIndexes, vpf));
+    if (m_nullBackend) {
+        m_impl->PrepareMeshTopology(pointIndexes, normalIndexes, uvIndexes, vpf, polygonWinding);
+        return m_nullBackend->CreateHandle<rpr::Shape>("Mesh");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateMesh(points, pointIndexes, normals, normalIndexes, uvs, uvIndexes, vpf, polygonWinding);
 }
 
+rpr::Shape* HdRprApi::CreateMesh(VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples, VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMesh", GetByteSize(pointSamples, normalSamples, uvSamples, topology.pointIndices, topology.normalIndices, topology.uvIndices, topology.vpf));
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::Shape>("Mesh");
+    }
+    m_impl->InitIfNeeded();
+    return m_impl->CreateMesh(pointSamples, normalSamples, uvSamples, topology);
+}
+
+HdRprApiMeshTopology HdRprApi::PrepareMeshTopology(VtIntArray const& pointIndexes, VtIntArray const& normalIndexes, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "PrepareMeshTopology", GetByteSize(pointIndexes, normalIndexes, uvIndexes, vpf));
+    return m_impl->PrepareMeshTopology(pointIndexes, normalIndexes, uvIndexes, vpf, polygonWinding);
+}
+
 rpr::Curve* HdRprApi::CreateCurve(VtVec3fArray const& points, VtIntArray const& indices, VtFloatArray const& radiuses, VtVec2fArray const& uvs, VtIntArray const& segmentPerCurve) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateCurve", GetByteSize(points, indices, radiuses, uvs, segmentPerCurve));
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::Curve>("Curve");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateCurve(points, indices, radiuses, uvs, segmentPerCurve);
 }
 
+rpr::Shape* HdRprApi::CreateSharedMesh(VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples, VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMesh", GetByteSize(pointSamples, normalSamples, uvSamples, topology.pointIndices, topology.normalIndices, topology.uvIndices, topology.vpf));
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::Shape>("Mesh");
+    }
+    m_impl->InitIfNeeded();
+    return m_impl->CreateSharedMesh(pointSamples, normalSamples, uvSamples, topology);
+}
+
 rpr::Shape* HdRprApi::CreateMeshInstance(rpr::Shape* prototypeMesh) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMeshInstance", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::Shape>("MeshInstance");
+    }
     return m_impl->CreateMeshInstance(prototypeMesh);
 }
 
 HdRprApiEnvironmentLight* HdRprApi::CreateEnvironmentLight(GfVec3f color, float intensity, BackgroundOverride const& backgroundOverride) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateEnvironmentLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateEnvironmentLight();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateEnvironmentLight(color, intensity, backgroundOverride);
 }
 
 HdRprApiEnvironmentLight* HdRprApi::CreateEnvironmentLight(const std::string& prthTotexture, float intensity, BackgroundOverride const& backgroundOverride) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateEnvironmentLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateEnvironmentLight();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateEnvironmentLight(prthTotexture, intensity, backgroundOverride);
 }
 
 void HdRprApi::SetTransform(HdRprApiEnvironmentLight* envLight, GfMatrix4f const& transform) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetTransform", sizeof(transform));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetTransform(envLight->light.get(), transform);
 }
 
 void HdRprApi::SetTransform(rpr::SceneObject* object, GfMatrix4f const& transform) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetTransform", sizeof(transform));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetTransform(object, transform);
 }
 
 void HdRprApi::SetTransform(rpr::Shape* shape, size_t numSamples, float* timeSamples, GfMatrix4d* transformSamples) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetTransform", numSamples * (sizeof(float) + sizeof(GfMatrix4d)));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetTransform(shape, numSamples, timeSamples, transformSamples);
 }
 
 void HdRprApi::SetTransform(HdRprApiVolume* volume, GfMatrix4f const& transform) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetTransform", sizeof(transform));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetTransform(volume, transform);
 }
 
 rpr::DirectionalLight* HdRprApi::CreateDirectionalLight() {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::DirectionalLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateDirectionalLight();
 }
 
 rpr::SpotLight* HdRprApi::CreateSpotLight(float angle, float softness) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::SpotLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateSpotLight(angle, softness);
 }
 
 rpr::PointLight* HdRprApi::CreatePointLight() {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::PointLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreatePointLight();
 }
 
 rpr::DiskLight* HdRprApi::CreateDiskLight() {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::DiskLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateDiskLight();
 }
 
 rpr::SphereLight* HdRprApi::CreateSphereLight() {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::SphereLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateSphereLight();
 }
 
 rpr::IESLight* HdRprApi::CreateIESLight(std::string const& iesFilepath) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateLight", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateHandle<rpr::IESLight>("Light");
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateIESLight(iesFilepath);
 }
 
 void HdRprApi::SetDirectionalLightAttributes(rpr::DirectionalLight* directionalLight, GfVec3f const& color, float shadowSoftnessAngle) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetDirectionalLightAttributes", sizeof(color));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetDirectionalLightAttributes(directionalLight, color, shadowSoftnessAngle);
 }
 
 void HdRprApi::SetLightRadius(rpr::SphereLight* light, float radius) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetLightRadius", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetLightRadius(light, radius);
 }
 
 void HdRprApi::SetLightRadius(rpr::DiskLight* light, float radius) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetLightRadius", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetLightRadius(light, radius);
 }
 
 void HdRprApi::SetLightAngle(rpr::DiskLight* light, float angle) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetLightAngle", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetLightAngle(light, angle);
 }
 
 void HdRprApi::SetLightColor(rpr::RadiantLight* light, GfVec3f const& color) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetLightColor", sizeof(color));
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetLightColor(light, color);
 }
 
 RprUsdMaterial* HdRprApi::CreateGeometryLightMaterial(GfVec3f const& emissionColor) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMaterial", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateMaterial();
+    }
     return m_impl->CreateGeometryLightMaterial(emissionColor);
 }
 
 void HdRprApi::ReleaseGeometryLightMaterial(RprUsdMaterial* material) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(material);
+        return;
+    }
     return m_impl->ReleaseGeometryLightMaterial(material);
 }
 
@@ -4834,6 +5725,10 @@ HdRprApiVolume* HdRprApi::CreateVolume(
     VtUIntArray const& albedoCoords, VtFloatArray const& albedoValues, VtVec3fArray const& albedoLUT, float albedoScale,
     VtUIntArray const& emissionCoords, VtFloatArray const& emissionValues, VtVec3fArray const& emissionLUT, float emissionScale,
     const GfVec3i& gridSize, const GfVec3f& voxelSize, const GfVec3f& gridBBLow) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateVolume", GetByteSize(densityCoords, densityValues, densityLUT, albedoCoords, albedoValues, albedoLUT, emissionCoords, emissionValues, emissionLUT));
+    if (m_nullBackend) {
+        return m_nullBackend->CreateVolume();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateVolume(
         densityCoords, densityValues, densityLUT, densityScale,
@@ -4843,21 +5738,37 @@ HdRprApiVolume* HdRprApi::CreateVolume(
 }
 
 void HdRprApi::SetVolumeVisibility(HdRprApiVolume *volume, uint32_t visibilityMask) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetVolumeVisibility", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->InitIfNeeded();
     m_impl->SetVolumeVisibility(volume, visibilityMask);
 }
 
 RprUsdMaterial* HdRprApi::CreateMaterial(SdfPath const& materialId, HdSceneDelegate* sceneDelegate, HdMaterialNetworkMap const& materialNetwork) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMaterial", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateMaterial();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreateMaterial(materialId, sceneDelegate, materialNetwork);
 }
 
 RprUsdMaterial* HdRprApi::CreatePointsMaterial(VtVec3fArray const& colors) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMaterial", GetByteSize(colors));
+    if (m_nullBackend) {
+        return m_nullBackend->CreateMaterial();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreatePointsMaterial(colors);
 }
 
 RprUsdMaterial* HdRprApi::CreateDiffuseMaterial(GfVec3f const& color) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMaterial", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateMaterial();
+    }
     m_impl->InitIfNeeded();
 
     return m_impl->CreateRawMaterial(RPR_MATERIAL_NODE_UBERV2, {
@@ -4866,83 +5777,174 @@ RprUsdMaterial* HdRprApi::CreateDiffuseMaterial(GfVec3f const& color) {
 }
 
 RprUsdMaterial* HdRprApi::CreatePrimvarLookupMaterial(bool isColorSet, bool isOpacitySet){
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CreateMaterial", 0);
+    if (m_nullBackend) {
+        return m_nullBackend->CreateMaterial();
+    }
     m_impl->InitIfNeeded();
     return m_impl->CreatePrimvarColorLookupMaterial(isColorSet, isOpacitySet);
 }
 
 void HdRprApi::SetMeshRefineLevel(rpr::Shape* mesh, int level, const float creaseWeight) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshRefineLevel", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshRefineLevel(mesh, level, creaseWeight);
 }
 
 void HdRprApi::SetMeshVertexInterpolationRule(rpr::Shape* mesh, TfToken boundaryInterpolation) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshVertexInterpolationRule", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshVertexInterpolationRule(mesh, boundaryInterpolation);
 }
 
 void HdRprApi::SetMeshMaterial(rpr::Shape* mesh, RprUsdMaterial const* material, bool displacementEnabled) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshMaterial", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshMaterial(mesh, material, displacementEnabled);
 }
 
+void HdRprApi::SetMeshMaterialFaces(rpr::Shape* mesh, RprUsdMaterial const* material, VtIntArray const& faceIndices, VtIntArray const& vpf) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshMaterialFaces", GetByteSize(faceIndices));
+    if (m_nullBackend) {
+        return;
+    }
+    m_impl->SetMeshMaterialFaces(mesh, material, faceIndices, vpf);
+}
+
 void HdRprApi::SetMeshVisibility(rpr::Shape* mesh, uint32_t visibilityMask) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshVisibility", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshVisibility(mesh, visibilityMask);
 }
 
 void HdRprApi::SetMeshId(rpr::Shape* mesh, uint32_t id) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshId", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshId(mesh, id);
 }
 
 void HdRprApi::SetMeshIgnoreContour(rpr::Shape* mesh, bool ignoreContour) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshIgnoreContour", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetMeshIgnoreContour(mesh, ignoreContour);
 }
 
 bool HdRprApi::SetMeshVertexColor(rpr::Shape* mesh, VtArray<VtVec3fArray> const& primvarSamples, HdInterpolation interpolation) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshVertexColor", GetByteSize(primvarSamples));
+    if (m_nullBackend) {
+        return true;
+    }
     return m_impl->SetMeshVertexColor(mesh, primvarSamples, interpolation);
 }
 
 bool HdRprApi::SetMeshVertexOpacity(rpr::Shape* mesh, VtArray<VtFloatArray> const& primvarSamples, HdInterpolation interpolation) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetMeshVertexOpacity", GetByteSize(primvarSamples));
+    if (m_nullBackend) {
+        return true;
+    }
     return m_impl->SetMeshVertexOpacity(mesh, primvarSamples, interpolation);
 }
 
 void HdRprApi::SetCurveMaterial(rpr::Curve* curve, RprUsdMaterial const* material) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetCurveMaterial", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetCurveMaterial(curve, material);
 }
 
 void HdRprApi::SetCurveVisibility(rpr::Curve* curve, uint32_t visibilityMask) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "SetCurveVisibility", 0);
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetCurveVisibility(curve, visibilityMask);
 }
 
 void HdRprApi::Release(HdRprApiEnvironmentLight* envLight) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(envLight);
+        return;
+    }
     m_impl->Release(envLight);
 }
 
 void HdRprApi::Release(RprUsdMaterial* material) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(material);
+        return;
+    }
     m_impl->Release(material);
 }
 
 void HdRprApi::Release(HdRprApiVolume* volume) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(volume);
+        return;
+    }
     m_impl->Release(volume);
 }
 
 void HdRprApi::Release(rpr::Light* light) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(light);
+        return;
+    }
     m_impl->Release(light);
 }
 
 void HdRprApi::Release(rpr::Shape* shape) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(shape);
+        return;
+    }
     m_impl->Release(shape);
 }
 
 void HdRprApi::Release(rpr::Curve* curve) {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "Release", 0);
+    if (m_nullBackend) {
+        m_nullBackend->Release(curve);
+        return;
+    }
     m_impl->Release(curve);
 }
 
 void HdRprApi::SetName(rpr::ContextObject* object, const char* name) {
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetName(object, name);
 }
 
 void HdRprApi::SetName(RprUsdMaterial* object, const char* name) {
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetName(object, name);
 }
 
 void HdRprApi::SetName(HdRprApiEnvironmentLight* object, const char* name) {
+    if (m_nullBackend) {
+        return;
+    }
     m_impl->SetName(object, name);
 }
 
@@ -4979,7 +5981,16 @@ HdRenderPassAovBindingVector HdRprApi::GetAovBindings() const {
     return m_impl->GetAovBindings();
 }
 
+void HdRprApi::SetTextureLoadOptions(RprUsdTextureLoadOptions const& options) {
+    m_impl->SetTextureLoadOptions(options);
+}
+
+void HdRprApi::SetImageCacheRetentionBudget(size_t numBytes) {
+    m_impl->SetImageCacheRetentionBudget(numBytes);
+}
+
 void HdRprApi::CommitResources() {
+    HdRprApiRecorder::Scope recordScope(m_recorder, "CommitResources", 0);
     m_impl->CommitResources();
 }
 
@@ -5016,6 +6027,11 @@ bool HdRprApi::IsArbitraryShapedLightSupported() const {
     return m_impl->IsArbitraryShapedLightSupported();
 }
 
+bool HdRprApi::IsPerFaceMaterialSupported() const {
+    m_impl->InitIfNeeded();
+    return m_impl->IsPerFaceMaterialSupported();
+}
+
 bool HdRprApi::IsSphereAndDiskLightSupported() const {
     m_impl->InitIfNeeded();
     return m_impl->IsSphereAndDiskLightSupported();
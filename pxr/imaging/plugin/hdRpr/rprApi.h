@@ -47,11 +47,25 @@ class HdRprRenderThread;
 class MaterialAdapter;
 
 class HdRprApiImpl;
+class HdRprApiRecorder;
+class HdRprApiNullBackend;
 class RprUsdMaterial;
+struct RprUsdTextureLoadOptions;
 
 struct HdRprApiVolume;
 struct HdRprApiEnvironmentLight;
 
+// Mesh topology converted into the layout RPR consumes: polygons with more than four vertices are split
+// into triangles and indices are reordered into right-handed winding order.
+// It stays valid while the source topology does not change, so a deforming mesh can be recreated
+// with new vertex data without processing its indices again.
+struct HdRprApiMeshTopology {
+    VtIntArray pointIndices;
+    VtIntArray normalIndices;
+    VtIntArray uvIndices;
+    VtIntArray vpf;
+};
+
 template <typename T, typename... Args>
 std::unique_ptr<T> make_unique(Args&&... args) {
     return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
@@ -123,10 +137,15 @@ public:
 
     rpr::Shape* CreateMesh(VtVec3fArray const& points, VtIntArray const& pointIndexes, VtVec3fArray const& normals, VtIntArray const& normalIndexes, VtVec2fArray const& uvs, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding);
     rpr::Shape* CreateMesh(VtArray<VtVec3fArray> const& pointSamples, VtIntArray const& pointIndexes, VtArray<VtVec3fArray> const& normalSamples, VtIntArray const& normalIndexes, VtArray<VtVec2fArray> const& uvSamples, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding);
+    rpr::Shape* CreateMesh(VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples, VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology);
+    HdRprApiMeshTopology PrepareMeshTopology(VtIntArray const& pointIndexes, VtIntArray const& normalIndexes, VtIntArray const& uvIndexes, VtIntArray const& vpf, TfToken const& polygonWinding);
+    rpr::Shape* CreateSharedMesh(VtArray<VtVec3fArray> const& pointSamples, VtArray<VtVec3fArray> const& normalSamples, VtArray<VtVec2fArray> const& uvSamples, HdRprApiMeshTopology const& topology);
     rpr::Shape* CreateMeshInstance(rpr::Shape* prototypeMesh);
     void SetMeshRefineLevel(rpr::Shape* mesh, int level, const float creaseWeight);
     void SetMeshVertexInterpolationRule(rpr::Shape* mesh, TfToken boundaryInterpolation);
     void SetMeshMaterial(rpr::Shape* mesh, RprUsdMaterial const* material, bool displacementEnabled);
+    // faceIndices index faces of the source topology that the mesh was prepared from, see PrepareMeshTopology
+    void SetMeshMaterialFaces(rpr::Shape* mesh, RprUsdMaterial const* material, VtIntArray const& faceIndices, VtIntArray const& vpf);
     void SetMeshVisibility(rpr::Shape* mesh, uint32_t visibilityMask);
     void SetMeshId(rpr::Shape* mesh, uint32_t id);
     void SetMeshIgnoreContour(rpr::Shape* mesh, bool ignoreContour);
@@ -175,6 +194,13 @@ public:
         double frameResolveTotalTime;
         double cacheCreationTime;
         double syncTime;
+        size_t numDeduplicatedMaterials;
+        size_t numDeduplicatedMeshes;
+        size_t imageCacheNumHits;
+        size_t imageCacheNumMisses;
+        size_t imageCacheNumEvictions;
+        size_t imageCacheNumRetainedImages;
+        size_t imageCacheRetainedDataSize;
     };
     RenderStats GetRenderStats() const;
 
@@ -182,6 +208,10 @@ public:
     int GetCpuThreadCountUsed() const;
     float GetFirstIterationRenerTime() const;
 
+    // Options of the textures that are loaded by CommitResources
+    void SetTextureLoadOptions(RprUsdTextureLoadOptions const& options);
+    // Memory budget of the textures that are not used anymore but kept for reuse
+    void SetImageCacheRetentionBudget(size_t numBytes);
     void CommitResources();
     void Resolve(SdfPath const& aovId);
     void Render(HdRprRenderThread* renderThread);
@@ -191,6 +221,7 @@ public:
     bool IsGlInteropEnabled() const;
     bool IsVulkanInteropEnabled() const;
     bool IsArbitraryShapedLightSupported() const;
+    bool IsPerFaceMaterialSupported() const;
     bool IsSphereAndDiskLightSupported() const;
     TfToken const& GetCurrentRenderQuality() const;
     rpr::FrameBuffer* GetRawColorFramebuffer();
@@ -198,6 +229,8 @@ public:
 
 private:
     HdRprApiImpl* m_impl = nullptr;
+    HdRprApiRecorder* m_recorder = nullptr;
+    HdRprApiNullBackend* m_nullBackend = nullptr;
 };
 
 rpr::EnvironmentLight* GetLightObject(HdRprApiEnvironmentLight* envLight);
@@ -14,10 +14,12 @@ limitations under the License.
 #include "rprApiAov.h"
 #include "rprApi.h"
 #include "rprApiFramebuffer.h"
+#include "aovDataConversion.h"
 #include "rifcpp/rifError.h"
 
 #include "pxr/imaging/rprUsd/contextMetadata.h"
 #include "pxr/imaging/rprUsd/error.h"
+#include "pxr/imaging/rprUsd/timeline.h"
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -51,6 +53,15 @@ namespace {
         return true;
     }
 
+    // Formats that differ from the framebuffer format only by component type and count
+    // can be converted on CPU without RIF
+    bool IsCpuConvertibleFormat(HdFormat format) {
+        auto componentFormat = HdGetComponentFormat(format);
+        return componentFormat == HdFormatFloat32 ||
+            componentFormat == HdFormatFloat16 ||
+            componentFormat == HdFormatUNorm8;
+    }
+
 } // namespace anonymous
 
 HdRprApiAov::HdRprApiAov(rpr_aov rprAovType, int width, int height, HdFormat format,
@@ -78,15 +89,16 @@ HdRprApiAov::HdRprApiAov(rpr_aov rprAovType, int width, int height, HdFormat for
         // RPR framebuffers by default with such format
         return nullptr;
     }
+    if (IsCpuConvertibleFormat(format)) {
+        // Converted in GetData straight from the resolved framebuffer
+        return nullptr;
+    }
     if (!rifContext)
     {
-        if (format == HdFormatFloat32) {
-            return nullptr;
-        }
         if (format == HdFormatInt32) {
             return nullptr;
         }
-        RPR_THROW_ERROR_MSG("Only Float32Vec4, Float32, and Int32 data types are supported without rifContext.");
+        RPR_THROW_ERROR_MSG("Only Float32, Float16, UNorm8, and Int32 data types are supported without rifContext.");
     }
 
     auto filter = rif::Filter::CreateCustom(RIF_IMAGE_FILTER_RESAMPLE, rifContext);
@@ -101,6 +113,8 @@ HdRprApiAov::HdRprApiAov(rpr_aov rprAovType, int width, int height, HdFormat for
 }
 
 void HdRprApiAov::Resolve() {
+    RprUsdTimelineZone zone("HdRprApiAov::Resolve");
+
     if (m_aov) {
         m_aov->Resolve(m_resolved.get());
     }
@@ -131,84 +145,62 @@ bool HdRprApiAov::GetDataImpl(void* dstBuffer, size_t dstBufferSize) {
 }
 
 bool HdRprApiAov::GetData(void* dstBuffer, size_t dstBufferSize) {
-    auto getBuffer = dstBuffer;
-    if (!m_filter)
-    {
-        bool needTmpBuffer = true;
-        // Rpr always renders to HdFormatFloat32Vec4
-        // If RIF is enabled then m_filter will cast to the desired type.
-        // But if RIF isn't enabled we must do the cast ourselves here.
-        //
-        // When this function is called dstBufferSize is set to the desired format buffer size.
-        // We must allocate m_tmpBuffer to size of a HdFormatFloat32Vec4 buffer.
-        // For both Float32 and Int32 we do this by multiplying the desired format buffer size by 4.
-        if (m_format == HdFormatFloat32) {
-            dstBufferSize = dstBufferSize * 4;
-        }
-        else if (m_format == HdFormatInt32) {
-            dstBufferSize = dstBufferSize * 4;
-        }
-        else {
-            needTmpBuffer = false;
-        }
-        if (needTmpBuffer)
-        {
-            if (m_tmpBuffer.size() < dstBufferSize)
-            {
-                m_tmpBuffer.resize(dstBufferSize);
-            }
-            getBuffer = m_tmpBuffer.data();
-        }
+    return ReadData(&m_tmpBuffer, dstBufferSize) &&
+        ConvertData(m_tmpBuffer, dstBuffer, dstBufferSize);
+}
+
+bool HdRprApiAov::ReadData(std::vector<char>* hostBuffer, size_t dstBufferSize) {
+    // RIF filter output already has the AOV format, otherwise rpr always renders to HdFormatFloat32Vec4
+    size_t readSize = dstBufferSize;
+    if (!m_filter) {
+        readSize = dstBufferSize / HdDataSizeOfFormat(m_format) * sizeof(GfVec4f);
     }
-    if (GetDataImpl(getBuffer, dstBufferSize)) {
-        if (!m_filter)
-        {
-            if (m_format == HdFormatFloat32) {
-                auto srcData = reinterpret_cast<const GfVec4f*>(getBuffer);
-                auto dstData = reinterpret_cast<float*>(dstBuffer);
-                for (size_t i = 0; i < dstBufferSize / sizeof(GfVec4f); ++i) {
-                    dstData[i] = srcData[i][0];
-                }
-            }
-            if (m_format == HdFormatInt32) {
-                auto srcData = reinterpret_cast<const float*>(getBuffer);
-                auto dstData = reinterpret_cast<char*>(dstBuffer);
-                for (size_t i = 0; i < dstBufferSize / sizeof(float); ++i)
-                {
-                    if (i % 4 == 3)
-                    {
-                        dstData[i] = 0;
-                    }
-                    else
-                    {
-                        dstData[i] = (char)(srcData[i] * 255 + 0.5f);
-                    }
-                }
+    if (hostBuffer->size() < readSize) {
+        hostBuffer->resize(readSize);
+    }
+    return GetDataImpl(hostBuffer->data(), readSize);
+}
 
-                auto primIdData = reinterpret_cast<int*>(dstBuffer);
-                for (size_t i = 0; i < dstBufferSize / sizeof(GfVec4f); ++i)
-                {
-                    primIdData[i] -= 1;
-                }
-            }
+bool HdRprApiAov::ConvertData(std::vector<char> const& hostBuffer, void* dstBuffer, size_t dstBufferSize) {
+    if (m_filter) {
+        if (hostBuffer.size() < dstBufferSize) {
+            return false;
         }
-        else if (m_format == HdFormatInt32) {
+
+        std::memcpy(dstBuffer, hostBuffer.data(), dstBufferSize);
+
+        if (m_format == HdFormatInt32) {
             // RPR store integer ID values to RGB images using such formula:
             // c[i].x = i;
             // c[i].y = i/256;
             // c[i].z = i/(256*256);
             // i.e. saving little endian int24 to uchar3
             // That's why we interpret the value as int and filling the alpha channel with zeros
-            auto primIdData = reinterpret_cast<int*>(dstBuffer);
-            for (size_t i = 0; i < dstBufferSize / sizeof(int); ++i) {
-                primIdData[i] = (primIdData[i] & 0xFFFFFF) - 1;
-            }
+            HdRprDecodePrimIdData(reinterpret_cast<int*>(dstBuffer), dstBufferSize / sizeof(int));
         }
 
         return true;
     }
 
-    return false;
+    // When there is no RIF filter, we must do the cast ourselves here.
+    // dstBufferSize is set to the desired format buffer size, hostBuffer holds HdFormatFloat32Vec4 data
+    size_t numPixels = dstBufferSize / HdDataSizeOfFormat(m_format);
+    size_t rawBufferSize = numPixels * sizeof(GfVec4f);
+    if (hostBuffer.size() < rawBufferSize) {
+        return false;
+    }
+
+    if (m_format == HdFormatFloat32Vec4) {
+        std::memcpy(dstBuffer, hostBuffer.data(), dstBufferSize);
+        return true;
+    }
+
+    if (m_format == HdFormatInt32) {
+        HdRprConvertPrimIdData(reinterpret_cast<const GfVec4f*>(hostBuffer.data()), numPixels, static_cast<int*>(dstBuffer));
+        return true;
+    }
+
+    return HdRprConvertFramebufferData(reinterpret_cast<const GfVec4f*>(hostBuffer.data()), numPixels, m_format, dstBuffer);
 }
 
 void HdRprApiAov::Resize(int width, int height, HdFormat format) {
@@ -246,7 +238,7 @@ HdRprApiFramebuffer* HdRprApiAov::GetResolvedFb() {
 
 void HdRprApiAov::OnFormatChange(rif::Context* rifContext) {
     m_filter = nullptr;
-    if (rifContext && m_format != HdFormatFloat32Vec4) {
+    if (rifContext && !IsCpuConvertibleFormat(m_format)) {
         m_filter = rif::Filter::CreateCustom(RIF_IMAGE_FILTER_RESAMPLE, rifContext);
         m_filter->SetParam("interpOperator", (int)RIF_IMAGE_INTERPOLATION_NEAREST);
 
@@ -460,17 +452,22 @@ void HdRprApiColorAov::Update(HdRprApi const* rprApi, rif::Context* rifContext)
     }
 }
 
-bool HdRprApiColorAov::GetData(void* dstBuffer, size_t dstBufferSize) {
+bool HdRprApiColorAov::ReadData(std::vector<char>* hostBuffer, size_t dstBufferSize) {
     if (!m_filter) {
-        if (auto resolvedRawColorFb = m_retainedRawColor->GetResolvedFb()) {
-            return resolvedRawColorFb->GetData(dstBuffer, dstBufferSize);
-        }
-        else {
+        // Read the resolved raw color, ConvertData converts it instead of running RIF resample filter
+        auto resolvedRawColorFb = m_retainedRawColor->GetResolvedFb();
+        if (!resolvedRawColorFb) {
             return false;
         }
+
+        size_t rawBufferSize = dstBufferSize / HdDataSizeOfFormat(m_format) * sizeof(GfVec4f);
+        if (hostBuffer->size() < rawBufferSize) {
+            hostBuffer->resize(rawBufferSize);
+        }
+        return resolvedRawColorFb->GetData(hostBuffer->data(), rawBufferSize);
     }
     else {
-        return HdRprApiAov::GetData(dstBuffer, dstBufferSize);
+        return HdRprApiAov::ReadData(hostBuffer, dstBufferSize);
     }
 }
 
@@ -483,7 +480,7 @@ void HdRprApiColorAov::Resolve() {
 }
 
 void HdRprApiColorAov::OnFormatChange(rif::Context* rifContext) {
-    SetFilter(kFilterResample, m_format != HdFormatFloat32Vec4);
+    SetFilter(kFilterResample, !IsCpuConvertibleFormat(m_format));
     SetFilter(kFilterComposeOpacity, CanComposeAlpha());
     m_dirtyBits |= ChangeTracker::DirtySize;
 }
@@ -37,7 +37,12 @@ public:
     virtual void Update(HdRprApi const* rprApi, rif::Context* rifContext);
     virtual void Resolve();
 
-    virtual bool GetData(void* dstBuffer, size_t dstBufferSize);
+    // Reads the resolved data into host memory. Touches RPR and RIF objects,
+    // so it must be called from the thread that renders
+    virtual bool ReadData(std::vector<char>* hostBuffer, size_t dstBufferSize);
+    // Converts the data read by ReadData into the AOV format, does not touch RPR or RIF
+    bool ConvertData(std::vector<char> const& hostBuffer, void* dstBuffer, size_t dstBufferSize);
+    bool GetData(void* dstBuffer, size_t dstBufferSize);
     void Clear();
 
     HdFormat GetFormat() const { return m_format; }
@@ -78,7 +83,7 @@ public:
 
     void Resize(int width, int height, HdFormat format) override;
     void Update(HdRprApi const* rprApi, rif::Context* rifContext) override;
-    bool GetData(void* dstBuffer, size_t dstBufferSize) override;
+    bool ReadData(std::vector<char>* hostBuffer, size_t dstBufferSize) override;
     void Resolve() override;
 
     void SetOpacityAov(std::shared_ptr<HdRprApiAov> opacity);
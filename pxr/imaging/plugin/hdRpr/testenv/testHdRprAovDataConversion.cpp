@@ -0,0 +1,253 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks CPU conversion of float4 framebuffer data into Hydra render buffer formats against
+// a scalar reference implementation.
+// Usage: testHdRprAovDataConversion [--benchmark [width] [height]]
+
+#include "aovDataConversion.h"
+#include "testUtils.h"
+
+#include "pxr/base/gf/half.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+// Straightforward per-component conversion
+namespace reference {
+
+GfHalf ToHalf(float value) {
+    return GfHalf(value);
+}
+
+uint8_t ToUNorm8(float value) {
+    if (std::isnan(value) || value <= 0.0f) {
+        return 0;
+    } else if (value >= 1.0f) {
+        return 255;
+    }
+    return uint8_t(value * 255.0f + 0.5f);
+}
+
+// Serial implementation that HdRprApiAov used before
+void ConvertPrimIdData(GfVec4f const* srcData, size_t numPixels, int* dstBuffer) {
+    auto src = reinterpret_cast<const float*>(srcData);
+    auto dstData = reinterpret_cast<char*>(dstBuffer);
+    for (size_t i = 0; i < numPixels * 4; ++i) {
+        if (i % 4 == 3) {
+            dstData[i] = 0;
+        } else {
+            dstData[i] = (char)(src[i] * 255 + 0.5f);
+        }
+    }
+
+    for (size_t i = 0; i < numPixels; ++i) {
+        dstBuffer[i] -= 1;
+    }
+}
+
+void DecodePrimIdData(int* data, size_t numPixels) {
+    for (size_t i = 0; i < numPixels; ++i) {
+        data[i] = (data[i] & 0xFFFFFF) - 1;
+    }
+}
+
+} // namespace reference
+
+std::vector<GfVec4f> GenerateFramebuffer(size_t numPixels) {
+    // Values that are handled specially by the conversions: out of range, NaN, infinities,
+    // half overflow and denormals, and values exactly between two UNorm8 steps
+    const float kSpecialValues[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 1e-3f,
+        0.5f / 255.0f, 1.5f / 255.0f, 254.5f / 255.0f,
+        std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+        65504.0f, 65520.0f, -65520.0f, 1e6f,
+        6.0e-8f, 6.1e-5f, 1e-10f,
+    };
+    const size_t kNumSpecialValues = sizeof(kSpecialValues) / sizeof(kSpecialValues[0]);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-0.25f, 1.25f);
+    std::uniform_real_distribution<float> hdrDistribution(0.0f, 1000.0f);
+
+    std::vector<GfVec4f> framebuffer(numPixels);
+    for (size_t i = 0; i < numPixels; ++i) {
+        for (size_t c = 0; c < 4; ++c) {
+            size_t index = i * 4 + c;
+            if (index < kNumSpecialValues) {
+                framebuffer[i][c] = kSpecialValues[index];
+            } else {
+                framebuffer[i][c] = (i % 8 == 0) ? hdrDistribution(generator) : distribution(generator);
+            }
+        }
+    }
+    return framebuffer;
+}
+
+void TestFloat32(std::vector<GfVec4f> const& framebuffer, size_t numComponents) {
+    HdFormat format = HdFormat(HdFormatFloat32 + numComponents - 1);
+    std::vector<float> result(framebuffer.size() * numComponents);
+    TF_AXIOM(HdRprConvertFramebufferData(framebuffer.data(), framebuffer.size(), format, result.data()));
+
+    for (size_t i = 0; i < framebuffer.size(); ++i) {
+        for (size_t c = 0; c < numComponents; ++c) {
+            float expected = framebuffer[i][c];
+            TF_AXIOM(RprUsdTestIsBitwiseEqual(&expected, &result[i * numComponents + c], sizeof(float)));
+        }
+    }
+}
+
+void TestFloat16(std::vector<GfVec4f> const& framebuffer, size_t numComponents) {
+    HdFormat format = HdFormat(HdFormatFloat16 + numComponents - 1);
+    std::vector<GfHalf> result(framebuffer.size() * numComponents);
+    TF_AXIOM(HdRprConvertFramebufferData(framebuffer.data(), framebuffer.size(), format, result.data()));
+
+    for (size_t i = 0; i < framebuffer.size(); ++i) {
+        for (size_t c = 0; c < numComponents; ++c) {
+            float value = framebuffer[i][c];
+            GfHalf half = result[i * numComponents + c];
+            TF_AXIOM(half.bits() == reference::ToHalf(value).bits());
+
+            // Half has 11 significant bits, rounding to nearest keeps the relative error within 2^-11
+            if (std::isfinite(value) && std::abs(value) >= 6.2e-5f && std::abs(value) <= 65504.0f) {
+                TF_AXIOM(std::abs(float(half) - value) <= std::abs(value) * std::ldexp(1.0f, -11));
+            }
+        }
+    }
+}
+
+void TestUNorm8(std::vector<GfVec4f> const& framebuffer, size_t numComponents) {
+    HdFormat format = HdFormat(HdFormatUNorm8 + numComponents - 1);
+    std::vector<uint8_t> result(framebuffer.size() * numComponents);
+    TF_AXIOM(HdRprConvertFramebufferData(framebuffer.data(), framebuffer.size(), format, result.data()));
+
+    for (size_t i = 0; i < framebuffer.size(); ++i) {
+        for (size_t c = 0; c < numComponents; ++c) {
+            float value = framebuffer[i][c];
+            uint8_t unorm = result[i * numComponents + c];
+            TF_AXIOM(unorm == reference::ToUNorm8(value));
+
+            // Rounding to nearest step
+            if (std::isfinite(value)) {
+                double clamped = std::min(std::max(double(value), 0.0), 1.0);
+                TF_AXIOM(std::abs(unorm / 255.0 - clamped) <= 0.5 / 255.0 + 1e-6);
+            }
+        }
+    }
+}
+
+void TestPrimId(size_t numPixels) {
+    // IDs are encoded into RGB channels as normalized bytes, the alpha channel is arbitrary
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<uint32_t> distribution(0, 0xFFFFFF);
+
+    std::vector<GfVec4f> framebuffer(numPixels);
+    std::vector<int> filterOutput(numPixels);
+    for (size_t i = 0; i < numPixels; ++i) {
+        uint32_t id = distribution(generator);
+        uint8_t bytes[4] = {uint8_t(id & 0xFF), uint8_t((id >> 8) & 0xFF), uint8_t((id >> 16) & 0xFF), uint8_t(i & 0xFF)};
+        framebuffer[i] = GfVec4f(bytes[0] / 255.0f, bytes[1] / 255.0f, bytes[2] / 255.0f, bytes[3] / 255.0f);
+        std::memcpy(&filterOutput[i], bytes, sizeof(int));
+    }
+
+    std::vector<int> expected(numPixels);
+    reference::ConvertPrimIdData(framebuffer.data(), numPixels, expected.data());
+
+    std::vector<int> result(numPixels);
+    HdRprConvertPrimIdData(framebuffer.data(), numPixels, result.data());
+    TF_AXIOM(result == expected);
+
+    std::vector<int> expectedDecoded = filterOutput;
+    reference::DecodePrimIdData(expectedDecoded.data(), numPixels);
+
+    HdRprDecodePrimIdData(filterOutput.data(), numPixels);
+    TF_AXIOM(filterOutput == expectedDecoded);
+    TF_AXIOM(filterOutput == expected);
+}
+
+template <typename T, typename ConvertComponent>
+void BenchmarkFormat(const char* name, std::vector<GfVec4f> const& framebuffer, HdFormat format, size_t numComponents, ConvertComponent&& convertComponent) {
+    std::vector<T> result(framebuffer.size() * numComponents);
+    std::vector<T> expected(framebuffer.size() * numComponents);
+    char label[64];
+    snprintf(label, sizeof(label), "%s x %zu", name, numComponents);
+    RprUsdTestCompareSpeed(label,
+        [&]() { HdRprConvertFramebufferData(framebuffer.data(), framebuffer.size(), format, result.data()); },
+        [&]() {
+            for (size_t i = 0; i < framebuffer.size(); ++i) {
+                for (size_t c = 0; c < numComponents; ++c) {
+                    expected[i * numComponents + c] = convertComponent(framebuffer[i][c]);
+                }
+            }
+        });
+}
+
+void Benchmark(size_t width, size_t height) {
+    size_t numPixels = width * height;
+    auto framebuffer = GenerateFramebuffer(numPixels);
+
+    printf("Conversion of %zux%zu framebuffer:\n", width, height);
+    for (size_t numComponents = 1; numComponents <= 4; ++numComponents) {
+        BenchmarkFormat<float>("Float32", framebuffer, HdFormat(HdFormatFloat32 + numComponents - 1), numComponents, [](float value) { return value; });
+        BenchmarkFormat<GfHalf>("Float16", framebuffer, HdFormat(HdFormatFloat16 + numComponents - 1), numComponents, reference::ToHalf);
+        BenchmarkFormat<uint8_t>("UNorm8", framebuffer, HdFormat(HdFormatUNorm8 + numComponents - 1), numComponents, reference::ToUNorm8);
+    }
+
+    std::vector<int> result(numPixels);
+    RprUsdTestCompareSpeed("Int32",
+        [&]() { HdRprConvertPrimIdData(framebuffer.data(), numPixels, result.data()); },
+        [&]() { reference::ConvertPrimIdData(framebuffer.data(), numPixels, result.data()); });
+    RprUsdTestCompareSpeed("Int32 from filter output",
+        [&]() { HdRprDecodePrimIdData(result.data(), numPixels); },
+        [&]() { reference::DecodePrimIdData(result.data(), numPixels); });
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    RprUsdTestArgs args(argc, argv);
+
+    // Odd sizes exercise the tails that are not a multiple of the vectorized or parallel block size
+    for (size_t numPixels : {size_t(1), size_t(7), size_t(64 * 64), size_t(333 * 17)}) {
+        auto framebuffer = GenerateFramebuffer(numPixels);
+        for (size_t numComponents = 1; numComponents <= 4; ++numComponents) {
+            TestFloat32(framebuffer, numComponents);
+            TestFloat16(framebuffer, numComponents);
+            TestUNorm8(framebuffer, numComponents);
+        }
+        TestPrimId(numPixels);
+
+        // IDs are not a framebuffer conversion, they are decoded with HdRprConvertPrimIdData
+        TF_AXIOM(!HdRprConvertFramebufferData(framebuffer.data(), numPixels, HdFormatInt32, nullptr));
+    }
+
+    if (args.IsBenchmark()) {
+        Benchmark(args.GetSize(0, 1920), args.GetSize(1, 1080));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,591 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Headless sync and render benchmark of hdRpr.
+// Builds a procedural in-memory stage, renders it through HdEngine until convergence
+// and prints sync and render statistics as JSON. By default rendering is done on CPU (RPRUSD_CPU_ONLY).
+//
+// Usage: testHdRprBenchmark [--option value]...
+//   --meshes N             number of meshes (default 100)
+//   --meshResolution N     number of quads along each side of a mesh (default 64)
+//   --instancers N         number of point instancers (default 10)
+//   --instances N          number of instances per instancer (default 1000)
+//   --textures N           number of textured materials (default 8)
+//   --textureSize N        resolution of textures (default 1024)
+//   --volumes N            number of VDB volumes (default 1), requires OpenVDB
+//   --volumeResolution N   number of voxels along the diameter of volume spheres (default 64)
+//   --curves N             number of curves (default 10000)
+//   --width N, --height N  render resolution (default 512x512)
+//   --samples N            maximum number of samples (default 64)
+//   --renderQuality Q      render quality setting (default Northstar)
+//   --timeout S            render time limit in seconds (default 600)
+//   --output PATH          write JSON report to file instead of stdout
+//   --gpu                  do not force CPU-only rendering
+
+#include "pxr/imaging/hd/engine.h"
+#include "pxr/imaging/hd/renderDelegate.h"
+#include "pxr/imaging/hd/renderIndex.h"
+#include "pxr/imaging/hd/rendererPlugin.h"
+#include "pxr/imaging/hd/rendererPluginRegistry.h"
+#include "pxr/imaging/hdx/taskController.h"
+#include "pxr/usdImaging/usdImaging/delegate.h"
+
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/basisCurves.h"
+#include "pxr/usd/usdGeom/camera.h"
+#include "pxr/usd/usdGeom/mesh.h"
+#include "pxr/usd/usdGeom/metrics.h"
+#include "pxr/usd/usdGeom/pointInstancer.h"
+#include "pxr/usd/usdGeom/primvarsAPI.h"
+#include "pxr/usd/usdGeom/xform.h"
+#include "pxr/usd/usdLux/domeLight.h"
+#include "pxr/usd/usdShade/material.h"
+#include "pxr/usd/usdShade/materialBindingAPI.h"
+#include "pxr/usd/usdShade/shader.h"
+#include "pxr/usd/usdVol/openVDBAsset.h"
+#include "pxr/usd/usdVol/volume.h"
+
+#include "pxr/base/arch/env.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/quatf.h"
+#include "pxr/base/gf/quath.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/vt/dictionary.h"
+
+#ifdef USE_VOLUME
+#include <openvdb/openvdb.h>
+#include <openvdb/tools/LevelSetSphere.h>
+#include <openvdb/tools/LevelSetUtil.h>
+#endif // USE_VOLUME
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+struct BenchmarkOptions {
+    int numMeshes = 100;
+    int meshResolution = 64;
+    int numInstancers = 10;
+    int numInstances = 1000;
+    int numTextures = 8;
+    int textureSize = 1024;
+    int numVolumes = 1;
+    int volumeResolution = 64;
+    int numCurves = 10000;
+    int width = 512;
+    int height = 512;
+    int maxSamples = 64;
+    std::string renderQuality = "Northstar";
+    double timeout = 600.0;
+    std::string outputPath;
+    bool cpuOnly = true;
+};
+
+bool ParseOptions(int argc, char* argv[], BenchmarkOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--gpu") {
+            options->cpuOnly = false;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value of %s\n", option.c_str());
+            return false;
+        }
+        std::string value = argv[++i];
+
+        auto intOption = [&value](int* dst) { *dst = std::atoi(value.c_str()); };
+        if (option == "--meshes") intOption(&options->numMeshes);
+        else if (option == "--meshResolution") intOption(&options->meshResolution);
+        else if (option == "--instancers") intOption(&options->numInstancers);
+        else if (option == "--instances") intOption(&options->numInstances);
+        else if (option == "--textures") intOption(&options->numTextures);
+        else if (option == "--textureSize") intOption(&options->textureSize);
+        else if (option == "--volumes") intOption(&options->numVolumes);
+        else if (option == "--volumeResolution") intOption(&options->volumeResolution);
+        else if (option == "--curves") intOption(&options->numCurves);
+        else if (option == "--width") intOption(&options->width);
+        else if (option == "--height") intOption(&options->height);
+        else if (option == "--samples") intOption(&options->maxSamples);
+        else if (option == "--renderQuality") options->renderQuality = value;
+        else if (option == "--timeout") options->timeout = std::atof(value.c_str());
+        else if (option == "--output") options->outputPath = value;
+        else {
+            fprintf(stderr, "Unknown option: %s\n", option.c_str());
+            return false;
+        }
+    }
+
+    if (options->meshResolution < 1 || options->textureSize < 1 || options->volumeResolution < 1 ||
+        options->width < 1 || options->height < 1 || options->maxSamples < 1) {
+        fprintf(stderr, "Resolutions and the sample count must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+using Clock = std::chrono::high_resolution_clock;
+
+double GetSecondsSince(Clock::time_point startTime) {
+    return std::chrono::duration<double>(Clock::now() - startTime).count();
+}
+
+// All procedural objects are placed on the XY plane inside of [-kSceneExtent, kSceneExtent]
+const float kSceneExtent = 10.0f;
+
+GfVec3d GetGridPosition(int index, int count) {
+    int gridSize = std::max(int(std::ceil(std::sqrt(double(count)))), 1);
+    double step = 2.0 * kSceneExtent / gridSize;
+    return GfVec3d(
+        -kSceneExtent + step * (0.5 + index % gridSize),
+        -kSceneExtent + step * (0.5 + index / gridSize),
+        0.0);
+}
+
+// Writes an uncompressed 24-bit TGA. TGA is supported by every image plugin RPR can load textures with
+bool WriteCheckerTexture(std::string const& path, int size, int seed) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint8_t header[18] = {};
+    header[2] = 2; // uncompressed true-color
+    header[12] = uint8_t(size & 0xFF);
+    header[13] = uint8_t((size >> 8) & 0xFF);
+    header[14] = uint8_t(size & 0xFF);
+    header[15] = uint8_t((size >> 8) & 0xFF);
+    header[16] = 24;
+    file.write(reinterpret_cast<char const*>(header), sizeof(header));
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    uint8_t colors[2][3];
+    for (auto& color : colors) {
+        for (auto& component : color) {
+            component = uint8_t(distribution(generator));
+        }
+    }
+
+    int cellSize = std::max(size / 16, 1);
+    std::vector<uint8_t> row(size * 3);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            auto& color = colors[((x / cellSize) + (y / cellSize)) % 2];
+            // BGR order
+            row[x * 3 + 0] = color[2];
+            row[x * 3 + 1] = color[1];
+            row[x * 3 + 2] = color[0];
+        }
+        file.write(reinterpret_cast<char const*>(row.data()), row.size());
+    }
+    return bool(file);
+}
+
+UsdShadeMaterial DefineMaterial(UsdStageRefPtr const& stage, SdfPath const& path, std::string const& texturePath) {
+    auto material = UsdShadeMaterial::Define(stage, path);
+
+    auto surface = UsdShadeShader::Define(stage, path.AppendChild(TfToken("PreviewSurface")));
+    surface.CreateIdAttr(VtValue(TfToken("UsdPreviewSurface")));
+    surface.CreateInput(TfToken("roughness"), SdfValueTypeNames->Float).Set(0.5f);
+    auto diffuseColor = surface.CreateInput(TfToken("diffuseColor"), SdfValueTypeNames->Color3f);
+    material.CreateSurfaceOutput().ConnectToSource(surface.ConnectableAPI(), TfToken("surface"));
+
+    if (texturePath.empty()) {
+        diffuseColor.Set(GfVec3f(0.8f));
+        return material;
+    }
+
+    auto stReader = UsdShadeShader::Define(stage, path.AppendChild(TfToken("StReader")));
+    stReader.CreateIdAttr(VtValue(TfToken("UsdPrimvarReader_float2")));
+    stReader.CreateInput(TfToken("varname"), SdfValueTypeNames->String).Set(std::string("st"));
+    stReader.CreateOutput(TfToken("result"), SdfValueTypeNames->Float2);
+
+    auto texture = UsdShadeShader::Define(stage, path.AppendChild(TfToken("Texture")));
+    texture.CreateIdAttr(VtValue(TfToken("UsdUVTexture")));
+    texture.CreateInput(TfToken("file"), SdfValueTypeNames->Asset).Set(SdfAssetPath(texturePath));
+    texture.CreateInput(TfToken("st"), SdfValueTypeNames->Float2).ConnectToSource(stReader.ConnectableAPI(), TfToken("result"));
+    texture.CreateOutput(TfToken("rgb"), SdfValueTypeNames->Float3);
+    diffuseColor.ConnectToSource(texture.ConnectableAPI(), TfToken("rgb"));
+
+    return material;
+}
+
+void DefineGridMesh(UsdStageRefPtr const& stage, SdfPath const& path, int resolution, float size, GfVec3d const& position, UsdShadeMaterial const& material) {
+    int numVertices = resolution + 1;
+
+    VtVec3fArray points(numVertices * numVertices);
+    VtVec2fArray st(points.size());
+    for (int y = 0; y < numVertices; ++y) {
+        for (int x = 0; x < numVertices; ++x) {
+            float u = float(x) / resolution;
+            float v = float(y) / resolution;
+            float height = 0.1f * size * std::sin(u * 6.2831853f) * std::cos(v * 6.2831853f);
+            points[y * numVertices + x] = GfVec3f((u - 0.5f) * size, (v - 0.5f) * size, height);
+            st[y * numVertices + x] = GfVec2f(u, v);
+        }
+    }
+
+    VtIntArray faceVertexCounts(resolution * resolution, 4);
+    VtIntArray faceVertexIndices;
+    faceVertexIndices.reserve(faceVertexCounts.size() * 4);
+    for (int y = 0; y < resolution; ++y) {
+        for (int x = 0; x < resolution; ++x) {
+            int i = y * numVertices + x;
+            faceVertexIndices.push_back(i);
+            faceVertexIndices.push_back(i + 1);
+            faceVertexIndices.push_back(i + numVertices + 1);
+            faceVertexIndices.push_back(i + numVertices);
+        }
+    }
+
+    auto mesh = UsdGeomMesh::Define(stage, path);
+    mesh.CreatePointsAttr(VtValue(points));
+    mesh.CreateFaceVertexCountsAttr(VtValue(faceVertexCounts));
+    mesh.CreateFaceVertexIndicesAttr(VtValue(faceVertexIndices));
+    mesh.CreateSubdivisionSchemeAttr(VtValue(UsdGeomTokens->none));
+    mesh.AddTranslateOp().Set(position);
+    UsdGeomPrimvarsAPI(mesh.GetPrim()).CreatePrimvar(TfToken("st"), SdfValueTypeNames->TexCoord2fArray, UsdGeomTokens->vertex).Set(st);
+
+    UsdShadeMaterialBindingAPI::Apply(mesh.GetPrim()).Bind(material);
+}
+
+void DefineInstancer(UsdStageRefPtr const& stage, SdfPath const& path, int numInstances, GfVec3d const& position, float extent, UsdShadeMaterial const& material, std::mt19937& generator) {
+    auto instancer = UsdGeomPointInstancer::Define(stage, path);
+    instancer.AddTranslateOp().Set(position);
+
+    auto prototypePath = path.AppendChild(TfToken("Prototypes")).AppendChild(TfToken("Tile"));
+    DefineGridMesh(stage, prototypePath, 4, 1.0f, GfVec3d(0.0), material);
+    instancer.CreatePrototypesRel().AddTarget(prototypePath);
+
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    VtIntArray protoIndices(numInstances, 0);
+    VtVec3fArray positions(numInstances);
+    VtQuathArray orientations(numInstances);
+    VtVec3fArray scales(numInstances);
+    for (int i = 0; i < numInstances; ++i) {
+        positions[i] = GfVec3f(distribution(generator), distribution(generator), distribution(generator)) * extent;
+        orientations[i] = GfQuath(GfQuatf(distribution(generator), distribution(generator), distribution(generator), distribution(generator)).GetNormalized());
+        scales[i] = GfVec3f(0.05f + 0.05f * std::abs(distribution(generator))) * extent;
+    }
+    instancer.CreateProtoIndicesAttr(VtValue(protoIndices));
+    instancer.CreatePositionsAttr(VtValue(positions));
+    instancer.CreateOrientationsAttr(VtValue(orientations));
+    instancer.CreateScalesAttr(VtValue(scales));
+}
+
+void DefineCurves(UsdStageRefPtr const& stage, SdfPath const& path, int numCurves, std::mt19937& generator) {
+    const int kNumVerticesPerCurve = 4;
+
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    VtIntArray curveVertexCounts(numCurves, kNumVerticesPerCurve);
+    VtVec3fArray points;
+    points.reserve(numCurves * kNumVerticesPerCurve);
+    for (int i = 0; i < numCurves; ++i) {
+        GfVec3f root(distribution(generator) * kSceneExtent, distribution(generator) * kSceneExtent, 0.0f);
+        for (int j = 0; j < kNumVerticesPerCurve; ++j) {
+            GfVec3f offset(distribution(generator), distribution(generator), 1.0f);
+            points.push_back(root + offset * (0.2f * j));
+        }
+    }
+
+    auto curves = UsdGeomBasisCurves::Define(stage, path);
+    curves.CreateTypeAttr(VtValue(UsdGeomTokens->cubic));
+    curves.CreateBasisAttr(VtValue(UsdGeomTokens->bspline));
+    curves.CreateCurveVertexCountsAttr(VtValue(curveVertexCounts));
+    curves.CreatePointsAttr(VtValue(points));
+    curves.CreateWidthsAttr(VtValue(VtFloatArray(1, 0.01f)));
+    curves.SetWidthsInterpolation(UsdGeomTokens->constant);
+}
+
+#ifdef USE_VOLUME
+bool WriteFogSphere(std::string const& path, int resolution) {
+    float radius = 1.0f;
+    float voxelSize = 2.0f * radius / resolution;
+    auto grid = openvdb::tools::createLevelSetSphere<openvdb::FloatGrid>(radius, openvdb::Vec3f(0.0f), voxelSize);
+    openvdb::tools::sdfToFogVolume(*grid);
+    grid->setName("density");
+
+    try {
+        openvdb::io::File file(path);
+        openvdb::GridCPtrVec grids{grid};
+        file.write(grids);
+        file.close();
+    } catch (openvdb::Exception& e) {
+        TF_RUNTIME_ERROR("Failed to write %s: %s", path.c_str(), e.what());
+        return false;
+    }
+    return true;
+}
+
+void DefineVolume(UsdStageRefPtr const& stage, SdfPath const& path, std::string const& vdbPath, GfVec3d const& position, float scale) {
+    auto volume = UsdVolVolume::Define(stage, path);
+    volume.AddTranslateOp().Set(position);
+    volume.AddScaleOp().Set(GfVec3f(scale));
+
+    auto fieldPath = path.AppendChild(TfToken("density"));
+    auto field = UsdVolOpenVDBAsset::Define(stage, fieldPath);
+    field.CreateFilePathAttr(VtValue(SdfAssetPath(vdbPath)));
+    field.CreateFieldNameAttr(VtValue(TfToken("density")));
+    volume.CreateFieldRelationship(TfToken("density"), fieldPath);
+}
+#endif // USE_VOLUME
+
+UsdStageRefPtr BuildStage(BenchmarkOptions const& options, std::string const& assetDir, SdfPath const& cameraPath) {
+    auto stage = UsdStage::CreateInMemory();
+    UsdGeomSetStageUpAxis(stage, UsdGeomTokens->y);
+    UsdGeomXform::Define(stage, SdfPath("/World"));
+
+    std::mt19937 generator(42);
+
+    auto camera = UsdGeomCamera::Define(stage, cameraPath);
+    camera.AddTranslateOp().Set(GfVec3d(0.0, 0.0, 4.0 * kSceneExtent));
+    camera.CreateClippingRangeAttr(VtValue(GfVec2f(0.1f, 1000.0f)));
+
+    UsdLuxDomeLight::Define(stage, SdfPath("/World/DomeLight"));
+
+    std::vector<UsdShadeMaterial> materials;
+    for (int i = 0; i < options.numTextures; ++i) {
+        auto texturePath = TfStringCatPaths(assetDir, TfStringPrintf("texture%d.tga", i));
+        if (!WriteCheckerTexture(texturePath, options.textureSize, i)) {
+            TF_RUNTIME_ERROR("Failed to write %s", texturePath.c_str());
+            continue;
+        }
+        materials.push_back(DefineMaterial(stage, SdfPath(TfStringPrintf("/World/Materials/Textured%d", i)), texturePath));
+    }
+    if (materials.empty()) {
+        materials.push_back(DefineMaterial(stage, SdfPath("/World/Materials/Plain"), std::string()));
+    }
+
+    float meshSize = kSceneExtent / std::max(std::sqrt(float(options.numMeshes)), 1.0f);
+    for (int i = 0; i < options.numMeshes; ++i) {
+        DefineGridMesh(stage, SdfPath(TfStringPrintf("/World/Meshes/Mesh%d", i)), options.meshResolution, meshSize,
+            GetGridPosition(i, options.numMeshes) + GfVec3d(0.0, 0.0, -1.0), materials[i % materials.size()]);
+    }
+
+    float instancerExtent = kSceneExtent / std::max(std::sqrt(float(options.numInstancers)), 1.0f);
+    for (int i = 0; i < options.numInstancers; ++i) {
+        DefineInstancer(stage, SdfPath(TfStringPrintf("/World/Instancers/Instancer%d", i)), options.numInstances,
+            GetGridPosition(i, options.numInstancers) + GfVec3d(0.0, 0.0, 1.0), instancerExtent, materials[i % materials.size()], generator);
+    }
+
+    if (options.numCurves > 0) {
+        DefineCurves(stage, SdfPath("/World/Curves"), options.numCurves, generator);
+    }
+
+    if (options.numVolumes > 0) {
+#ifdef USE_VOLUME
+        openvdb::initialize();
+
+        auto vdbPath = TfStringCatPaths(assetDir, "fogSphere.vdb");
+        if (WriteFogSphere(vdbPath, options.volumeResolution)) {
+            float volumeScale = kSceneExtent / std::max(std::sqrt(float(options.numVolumes)), 1.0f) * 0.5f;
+            for (int i = 0; i < options.numVolumes; ++i) {
+                DefineVolume(stage, SdfPath(TfStringPrintf("/World/Volumes/Volume%d", i)), vdbPath,
+                    GetGridPosition(i, options.numVolumes) + GfVec3d(0.0, 0.0, 2.0), volumeScale);
+            }
+        }
+#else
+        TF_WARN("hdRpr is built without OpenVDB, volumes are skipped");
+#endif // USE_VOLUME
+    }
+
+    return stage;
+}
+
+template <typename T>
+T GetStat(VtDictionary const& stats, std::string const& key) {
+    return VtDictionaryGet<T>(stats, key, VtDefault = T());
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        return EXIT_FAILURE;
+    }
+
+    if (options.cpuOnly) {
+        // Must be set before hdRpr reads the setting, do not override an explicit value
+        ArchSetEnv("RPRUSD_CPU_ONLY", "1", false);
+    }
+
+    auto assetDir = TfStringCatPaths(ArchGetTmpDir(), "testHdRprBenchmark");
+    if (!TfIsDir(assetDir) && !TfMakeDirs(assetDir)) {
+        TF_RUNTIME_ERROR("Failed to create %s", assetDir.c_str());
+        return EXIT_FAILURE;
+    }
+
+    SdfPath cameraPath("/World/Camera");
+
+    auto stageStartTime = Clock::now();
+    auto stage = BuildStage(options, assetDir, cameraPath);
+    double stageBuildTime = GetSecondsSince(stageStartTime);
+
+    static const TfToken kRendererPluginId("HdRprPlugin");
+    auto& rendererPluginRegistry = HdRendererPluginRegistry::GetInstance();
+    HdRendererPlugin* rendererPlugin = rendererPluginRegistry.GetRendererPlugin(kRendererPluginId);
+    if (!rendererPlugin) {
+        TF_RUNTIME_ERROR("Failed to load %s, make sure PXR_PLUGINPATH_NAME contains the hdRpr plugin", kRendererPluginId.GetText());
+        return EXIT_FAILURE;
+    }
+
+    HdRenderSettingsMap renderSettings;
+    renderSettings[TfToken("rpr:core:renderQuality")] = VtValue(TfToken(options.renderQuality));
+    renderSettings[TfToken("rpr:maxSamples")] = VtValue(options.maxSamples);
+
+    json report;
+    {
+        HdRenderDelegate* renderDelegate = rendererPlugin->CreateRenderDelegate(renderSettings);
+        if (!renderDelegate) {
+            TF_RUNTIME_ERROR("Failed to create render delegate");
+            rendererPluginRegistry.ReleasePlugin(rendererPlugin);
+            return EXIT_FAILURE;
+        }
+
+#if PXR_VERSION >= 2002
+        std::unique_ptr<HdRenderIndex> renderIndex(HdRenderIndex::New(renderDelegate, HdDriverVector()));
+#else
+        std::unique_ptr<HdRenderIndex> renderIndex(HdRenderIndex::New(renderDelegate));
+#endif
+
+        auto populateStartTime = Clock::now();
+        auto sceneDelegate = std::make_unique<UsdImagingDelegate>(renderIndex.get(), SdfPath("/UsdImagingDelegate"));
+        sceneDelegate->SetTime(UsdTimeCode::EarliestTime());
+        sceneDelegate->Populate(stage->GetPseudoRoot());
+        double populateTime = GetSecondsSince(populateStartTime);
+
+        auto taskController = std::make_unique<HdxTaskController>(renderIndex.get(), SdfPath("/TaskController"));
+        taskController->SetRenderOutputs({HdAovTokens->color});
+        taskController->SetRenderViewport(GfVec4d(0.0, 0.0, options.width, options.height));
+        taskController->SetCameraPath(sceneDelegate->ConvertCachePathToIndexPath(cameraPath));
+#if PXR_VERSION >= 2008
+        // Nothing to present to, the benchmark has no window
+        taskController->SetEnablePresentation(false);
+#endif
+
+        HdEngine engine;
+        auto tasks = taskController->GetRenderingTasks();
+
+        // The first execution syncs the whole scene, the render delegate renders asynchronously afterwards
+        auto renderStartTime = Clock::now();
+        engine.Execute(renderIndex.get(), &tasks);
+        double firstExecuteTime = GetSecondsSince(renderStartTime);
+
+        double timeToFirstSample = -1.0;
+        bool isTimedOut = false;
+        while (!taskController->IsConverged()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            tasks = taskController->GetRenderingTasks();
+            engine.Execute(renderIndex.get(), &tasks);
+
+            if (timeToFirstSample < 0.0 && GetStat<double>(renderDelegate->GetRenderStats(), "percentDone") > 0.0) {
+                timeToFirstSample = GetSecondsSince(renderStartTime);
+            }
+            if (GetSecondsSince(renderStartTime) > options.timeout) {
+                isTimedOut = true;
+                break;
+            }
+        }
+        double renderTime = GetSecondsSince(renderStartTime);
+
+        auto stats = renderDelegate->GetRenderStats();
+        double percentDone = GetStat<double>(stats, "percentDone");
+        double frameRenderTotalTime = GetStat<double>(stats, "frameRenderTotalTime");
+        double numSamples = percentDone / 100.0 * options.maxSamples;
+
+        report["scene"] = {
+            {"meshes", options.numMeshes},
+            {"meshResolution", options.meshResolution},
+            {"instancers", options.numInstancers},
+            {"instances", options.numInstances},
+            {"textures", options.numTextures},
+            {"textureSize", options.textureSize},
+            {"volumes", options.numVolumes},
+            {"volumeResolution", options.volumeResolution},
+            {"curves", options.numCurves},
+        };
+        report["settings"] = {
+            {"width", options.width},
+            {"height", options.height},
+            {"maxSamples", options.maxSamples},
+            {"renderQuality", options.renderQuality},
+            {"cpuOnly", options.cpuOnly},
+        };
+        report["gpus"] = GetStat<std::string>(stats, "gpuUsedNames");
+        report["cpuThreads"] = GetStat<int>(stats, "threadCountUsed");
+        report["isConverged"] = !isTimedOut;
+        report["percentDone"] = percentDone;
+
+        // Seconds
+        report["stageBuildTime"] = stageBuildTime;
+        report["populateTime"] = populateTime;
+        report["firstExecuteTime"] = firstExecuteTime;
+        report["syncTime"] = GetStat<double>(stats, "syncTime");
+        report["cacheCreationTime"] = GetStat<double>(stats, "cacheCreationTime");
+        report["timeToFirstSample"] = timeToFirstSample;
+        report["renderTime"] = renderTime;
+        report["frameRenderTotalTime"] = frameRenderTotalTime;
+        report["frameResolveTotalTime"] = GetStat<double>(stats, "frameResolveTotalTime");
+        report["samplesPerSecond"] = frameRenderTotalTime > 0.0 ? numSamples / frameRenderTotalTime : 0.0;
+        report["numDeduplicatedMaterials"] = GetStat<size_t>(stats, "numDeduplicatedMaterials");
+        report["numDeduplicatedMeshes"] = GetStat<size_t>(stats, "numDeduplicatedMeshes");
+        report["imageCache"] = {
+            {"numHits", GetStat<size_t>(stats, "imageCacheNumHits")},
+            {"numMisses", GetStat<size_t>(stats, "imageCacheNumMisses")},
+            {"numEvictions", GetStat<size_t>(stats, "imageCacheNumEvictions")},
+        };
+
+        // Hydra objects have to be released before the render delegate
+        taskController.reset();
+        sceneDelegate.reset();
+        renderIndex.reset();
+        rendererPlugin->DeleteRenderDelegate(renderDelegate);
+    }
+    rendererPluginRegistry.ReleasePlugin(rendererPlugin);
+
+    auto reportString = report.dump(4);
+    if (options.outputPath.empty()) {
+        std::cout << reportString << std::endl;
+    } else {
+        std::ofstream outputFile(options.outputPath);
+        if (!outputFile.is_open()) {
+            TF_RUNTIME_ERROR("Failed to open %s", options.outputPath.c_str());
+            return EXIT_FAILURE;
+        }
+        outputFile << reportString << std::endl;
+    }
+
+    return report["isConverged"].get<bool>() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,354 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks the parallel conversion of Hydra basis curves into RPR curve segments
+// on hand-written curves and against a serial implementation on random grooms.
+// Usage: testHdRprCurveSegments [--benchmark [number of curves]]
+
+#include "curveSegments.h"
+#include "testUtils.h"
+
+#include "pxr/imaging/hd/tokens.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+// Serial conversion that follows the curve layout of USD directly
+namespace reference {
+
+HdRprCurveSegments BuildCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtIntArray const& indices,
+    VtFloatArray const& widths,
+    HdInterpolation widthsInterpolation) {
+    const bool isBezier = topology.GetCurveType() == HdTokens->cubic;
+    const bool periodic = topology.GetCurveWrap() == HdTokens->periodic;
+    const bool segmented = topology.GetCurveWrap() == HdTokens->segmented;
+    const bool isTapered = widthsInterpolation == HdInterpolationVertex || widthsInterpolation == HdInterpolationVarying;
+
+    const int numPointsPerSegment = isBezier ? 4 : 2;
+    const int vstep = isBezier ? 3 : (segmented ? 2 : 1);
+
+    std::vector<int> rprIndices;
+    std::vector<float> rprRadiuses;
+    std::vector<int> rprSegmentPerCurve;
+
+    int vertexOffset = 0;
+    int varyingOffset = 0;
+    auto& curveCounts = topology.GetCurveVertexCounts();
+    for (size_t iCurve = 0; iCurve < curveCounts.size(); ++iCurve) {
+        const int numVertices = curveCounts[iCurve];
+        if (numVertices < numPointsPerSegment) {
+            vertexOffset += std::max(numVertices, 0);
+            continue;
+        }
+
+        const int numSegments = (numVertices - (numPointsPerSegment - vstep)) / vstep + (periodic ? 1 : 0);
+        const int numVarying = isBezier ? (periodic ? numSegments : numSegments + 1) : numVertices;
+
+        auto getIndex = [&](int vertex) {
+            vertex = vertexOffset + vertex % numVertices;
+            return indices.empty() ? vertex : indices[vertex];
+        };
+        auto getRadius = [&](int segment, bool front) {
+            if (widthsInterpolation == HdInterpolationVarying && isBezier) {
+                return 0.5f * widths[varyingOffset + (segment + (front ? 0 : 1)) % numVarying];
+            }
+            return 0.5f * widths[vertexOffset + (segment * vstep + (front ? 0 : numPointsPerSegment - 1)) % numVertices];
+        };
+
+        size_t numCurveIndices = rprIndices.size();
+        for (int segment = 0; segment < numSegments; ++segment) {
+            if (isBezier) {
+                for (int i = 0; i < 4; ++i) {
+                    rprIndices.push_back(getIndex(segment * vstep + i));
+                }
+            } else if (isTapered) {
+                // Linear segment as a cubic one
+                int i0 = getIndex(segment * vstep);
+                int i1 = getIndex(segment * vstep + 1);
+                rprIndices.insert(rprIndices.end(), {i0, i0, i1, i1});
+            } else {
+                rprIndices.push_back(getIndex(segment * vstep));
+                rprIndices.push_back(getIndex(segment * vstep + 1));
+            }
+
+            if (isTapered) {
+                rprRadiuses.push_back(getRadius(segment, true));
+                rprRadiuses.push_back(getRadius(segment, false));
+            }
+        }
+
+        if (!isTapered) {
+            // Cylindrical linear curves are padded with the last index to whole cubic segments
+            while ((rprIndices.size() - numCurveIndices) % 4 != 0) {
+                rprIndices.push_back(rprIndices.back());
+            }
+            rprRadiuses.push_back(0.5f * (widthsInterpolation == HdInterpolationUniform ? widths[iCurve] : widths[0]));
+        }
+
+        rprSegmentPerCurve.push_back(int(rprIndices.size() - numCurveIndices) / 4);
+
+        vertexOffset += numVertices;
+        varyingOffset += numVarying;
+    }
+
+    HdRprCurveSegments segments;
+    segments.indices.assign(rprIndices.begin(), rprIndices.end());
+    segments.radiuses.assign(rprRadiuses.begin(), rprRadiuses.end());
+    segments.segmentPerCurve.assign(rprSegmentPerCurve.begin(), rprSegmentPerCurve.end());
+    return segments;
+}
+
+} // namespace reference
+
+HdBasisCurvesTopology MakeTopology(TfToken const& type, TfToken const& wrap, VtIntArray const& curveCounts, VtIntArray const& indices = VtIntArray()) {
+    return HdBasisCurvesTopology(type, HdTokens->bezier, wrap, curveCounts, indices);
+}
+
+HdRprCurveSegments BuildCurveSegments(
+    HdBasisCurvesTopology const& topology,
+    VtFloatArray const& widths,
+    HdInterpolation widthsInterpolation) {
+    HdRprCurveSegments segments;
+    std::string error;
+    auto build = topology.GetCurveType() == HdTokens->cubic ? HdRprBuildBezierCurveSegments : HdRprBuildLinearCurveSegments;
+    TF_AXIOM(build(topology, topology.GetCurveIndices(), widths, widthsInterpolation, &segments, &error));
+    TF_AXIOM(error.empty());
+    return segments;
+}
+
+void CheckSegments(
+    HdRprCurveSegments const& segments,
+    VtIntArray const& indices,
+    VtFloatArray const& radiuses,
+    VtIntArray const& segmentPerCurve) {
+    TF_AXIOM(segments.indices == indices);
+    TF_AXIOM(segments.radiuses == radiuses);
+    TF_AXIOM(segments.segmentPerCurve == segmentPerCurve);
+
+    // Each curve consists of cubic segments
+    int numSegments = 0;
+    for (int numCurveSegments : segments.segmentPerCurve) {
+        numSegments += numCurveSegments;
+    }
+    TF_AXIOM(size_t(numSegments) * 4 == segments.indices.size());
+}
+
+void CheckError(HdBasisCurvesTopology const& topology, VtFloatArray const& widths, HdInterpolation widthsInterpolation, const char* expectedError) {
+    HdRprCurveSegments segments;
+    std::string error;
+    auto build = topology.GetCurveType() == HdTokens->cubic ? HdRprBuildBezierCurveSegments : HdRprBuildLinearCurveSegments;
+    TF_AXIOM(!build(topology, topology.GetCurveIndices(), widths, widthsInterpolation, &segments, &error));
+    TF_AXIOM(error == expectedError);
+}
+
+void TestLinearCylindrical() {
+    // Curves with less than 2 vertices are skipped but their vertices are still consumed
+    auto topology = MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {3, 1, 0, 2});
+    CheckSegments(BuildCurveSegments(topology, {2.0f}, HdInterpolationConstant),
+        {0, 1, 1, 2, 4, 5, 5, 5}, {1.0f, 1.0f}, {1, 1});
+
+    topology = MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {3, 1, 0, 2}, {10, 11, 12, 13, 14, 15});
+    CheckSegments(BuildCurveSegments(topology, {2.0f}, HdInterpolationConstant),
+        {10, 11, 11, 12, 14, 15, 15, 15}, {1.0f, 1.0f}, {1, 1});
+
+    // Every pair of vertices is a separate segment, uniform widths are specified per curve
+    topology = MakeTopology(HdTokens->linear, HdTokens->segmented, {4, 2});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f}, HdInterpolationUniform),
+        {0, 1, 2, 3, 4, 5, 5, 5}, {1.0f, 2.0f}, {1, 1});
+
+    // The closing segment connects the last vertex with the first one
+    topology = MakeTopology(HdTokens->linear, HdTokens->periodic, {3});
+    CheckSegments(BuildCurveSegments(topology, {2.0f}, HdInterpolationConstant),
+        {0, 1, 1, 2, 2, 0, 0, 0}, {1.0f}, {2});
+}
+
+void TestLinearTapered() {
+    // Each linear segment becomes a cubic segment with a radius at both ends
+    auto topology = MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {3, 1, 2});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f, 6.0f, 8.0f, 10.0f, 12.0f}, HdInterpolationVertex),
+        {0, 0, 1, 1, 1, 1, 2, 2, 4, 4, 5, 5}, {1.0f, 2.0f, 2.0f, 3.0f, 5.0f, 6.0f}, {2, 1});
+
+    // Varying widths of linear curves are specified per vertex
+    topology = MakeTopology(HdTokens->linear, HdTokens->periodic, {3, 2});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f, 6.0f, 8.0f, 10.0f}, HdInterpolationVarying),
+        {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 3, 3, 4, 4, 4, 4, 3, 3},
+        {1.0f, 2.0f, 2.0f, 3.0f, 3.0f, 1.0f, 4.0f, 5.0f, 5.0f, 4.0f}, {3, 2});
+
+    // The number of segments depends on the wrap, not only on the number of vertices
+    topology = MakeTopology(HdTokens->linear, HdTokens->segmented, {4});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f, 6.0f, 8.0f}, HdInterpolationVertex),
+        {0, 0, 1, 1, 2, 2, 3, 3}, {1.0f, 2.0f, 3.0f, 4.0f}, {2});
+}
+
+void TestBezier() {
+    // Curves with less than 4 vertices are skipped, widths of the following curves start at their first vertex
+    auto topology = MakeTopology(HdTokens->cubic, HdTokens->nonperiodic, {4, 2, 7});
+    VtFloatArray vertexWidths(13);
+    for (size_t i = 0; i < vertexWidths.size(); ++i) {
+        vertexWidths[i] = 2.0f * (i + 1);
+    }
+    CheckSegments(BuildCurveSegments(topology, vertexWidths, HdInterpolationVertex),
+        {0, 1, 2, 3, 6, 7, 8, 9, 9, 10, 11, 12}, {1.0f, 4.0f, 7.0f, 10.0f, 10.0f, 13.0f}, {1, 2});
+
+    // Varying widths are specified at the segment ends
+    topology = MakeTopology(HdTokens->cubic, HdTokens->nonperiodic, {4, 7});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f, 6.0f, 8.0f, 10.0f}, HdInterpolationVarying),
+        {0, 1, 2, 3, 4, 5, 6, 7, 7, 8, 9, 10}, {1.0f, 2.0f, 3.0f, 4.0f, 4.0f, 5.0f}, {1, 2});
+
+    topology = MakeTopology(HdTokens->cubic, HdTokens->periodic, {6});
+    CheckSegments(BuildCurveSegments(topology, {2.0f, 4.0f}, HdInterpolationVarying),
+        {0, 1, 2, 3, 3, 4, 5, 0}, {1.0f, 2.0f, 2.0f, 1.0f}, {2});
+
+    topology = MakeTopology(HdTokens->cubic, HdTokens->nonperiodic, {4, 4}, {7, 6, 5, 4, 3, 2, 1, 0});
+    CheckSegments(BuildCurveSegments(topology, {3.0f, 5.0f}, HdInterpolationUniform),
+        {7, 6, 5, 4, 3, 2, 1, 0}, {1.5f, 2.5f}, {1, 1});
+}
+
+void TestCorruptedData() {
+    CheckError(MakeTopology(HdTokens->linear, HdTokens->segmented, {3}), {1.0f}, HdInterpolationConstant,
+        "segmented linear curve should contain even number of vertices");
+    CheckError(MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {3, 2}), {1.0f, 1.0f, 1.0f, 1.0f}, HdInterpolationVertex,
+        "insufficient amount of widths");
+    CheckError(MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {3, 2}), {1.0f}, HdInterpolationUniform,
+        "insufficient amount of widths");
+    CheckError(MakeTopology(HdTokens->linear, HdTokens->nonperiodic, {2}), {}, HdInterpolationConstant,
+        "insufficient amount of widths");
+
+    CheckError(MakeTopology(HdTokens->cubic, HdTokens->segmented, {4}), {1.0f}, HdInterpolationConstant,
+        "bezier curve can not be of segmented wrap type");
+    CheckError(MakeTopology(HdTokens->cubic, HdTokens->nonperiodic, {5}), {1.0f}, HdInterpolationConstant,
+        "invalid topology");
+    CheckError(MakeTopology(HdTokens->cubic, HdTokens->periodic, {4}), {1.0f}, HdInterpolationConstant,
+        "invalid topology");
+    CheckError(MakeTopology(HdTokens->cubic, HdTokens->nonperiodic, {7}), {1.0f, 1.0f}, HdInterpolationVarying,
+        "insufficient amount of widths");
+}
+
+struct Groom {
+    HdBasisCurvesTopology topology;
+    VtFloatArray widths;
+    HdInterpolation widthsInterpolation;
+};
+
+Groom GenerateGroom(TfToken const& type, TfToken const& wrap, HdInterpolation widthsInterpolation, bool hasIndices, size_t numCurves) {
+    const bool isBezier = type == HdTokens->cubic;
+    const bool periodic = wrap == HdTokens->periodic;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> numStepsDistribution(0, 6);
+
+    VtIntArray curveCounts(numCurves);
+    int numVertices = 0;
+    int numVarying = 0;
+    for (auto& count : curveCounts) {
+        int numSteps = numStepsDistribution(generator);
+        if (numSteps == 0) {
+            // A curve that is too short to be converted
+            count = int(generator() % (isBezier ? 4 : 2));
+        } else if (isBezier) {
+            count = periodic ? (numSteps + 1) * 3 : numSteps * 3 + 1;
+            numVarying += periodic ? count / 3 : count / 3 + 1;
+        } else {
+            count = wrap == HdTokens->segmented ? numSteps * 2 : numSteps + 1;
+        }
+        numVertices += count;
+    }
+
+    VtIntArray indices;
+    if (hasIndices) {
+        indices.resize(numVertices);
+        for (auto& index : indices) {
+            index = int(generator() % 100000);
+        }
+    }
+
+    size_t numWidths = 1;
+    if (widthsInterpolation == HdInterpolationVertex || (widthsInterpolation == HdInterpolationVarying && !isBezier)) {
+        numWidths = numVertices;
+    } else if (widthsInterpolation == HdInterpolationVarying) {
+        numWidths = numVarying;
+    } else if (widthsInterpolation == HdInterpolationUniform) {
+        numWidths = numCurves;
+    }
+    VtFloatArray widths(numWidths);
+    std::uniform_real_distribution<float> widthDistribution(0.01f, 1.0f);
+    for (auto& width : widths) {
+        width = widthDistribution(generator);
+    }
+
+    return {MakeTopology(type, wrap, curveCounts, indices), widths, widthsInterpolation};
+}
+
+void TestMatchesReference(size_t numCurves) {
+    for (auto& type : {HdTokens->linear, HdTokens->cubic}) {
+        for (auto& wrap : {HdTokens->nonperiodic, HdTokens->periodic, HdTokens->segmented}) {
+            if (type == HdTokens->cubic && wrap == HdTokens->segmented) {
+                continue;
+            }
+
+            for (auto interpolation : {HdInterpolationConstant, HdInterpolationUniform, HdInterpolationVarying, HdInterpolationVertex}) {
+                for (bool hasIndices : {false, true}) {
+                    auto groom = GenerateGroom(type, wrap, interpolation, hasIndices, numCurves);
+                    auto expected = reference::BuildCurveSegments(groom.topology, groom.topology.GetCurveIndices(), groom.widths, interpolation);
+                    CheckSegments(BuildCurveSegments(groom.topology, groom.widths, interpolation),
+                        expected.indices, expected.radiuses, expected.segmentPerCurve);
+                }
+            }
+        }
+    }
+}
+
+void Benchmark(size_t numCurves) {
+    printf("Conversion of %zu curves:\n", numCurves);
+    for (auto interpolation : {HdInterpolationConstant, HdInterpolationVertex}) {
+        auto groom = GenerateGroom(HdTokens->linear, HdTokens->nonperiodic, interpolation, true, numCurves);
+        RprUsdTestCompareSpeed(interpolation == HdInterpolationConstant ? "Linear cylindrical" : "Linear tapered",
+            [&]() { BuildCurveSegments(groom.topology, groom.widths, interpolation); },
+            [&]() { reference::BuildCurveSegments(groom.topology, groom.topology.GetCurveIndices(), groom.widths, interpolation); });
+
+        groom = GenerateGroom(HdTokens->cubic, HdTokens->nonperiodic, interpolation, true, numCurves);
+        RprUsdTestCompareSpeed(interpolation == HdInterpolationConstant ? "Bezier cylindrical" : "Bezier tapered",
+            [&]() { BuildCurveSegments(groom.topology, groom.widths, interpolation); },
+            [&]() { reference::BuildCurveSegments(groom.topology, groom.topology.GetCurveIndices(), groom.widths, interpolation); });
+    }
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    RprUsdTestArgs args(argc, argv);
+
+    TestLinearCylindrical();
+    TestLinearTapered();
+    TestBezier();
+    TestCorruptedData();
+    // Enough curves to be split between several parallel tasks
+    TestMatchesReference(10000);
+
+    if (args.IsBenchmark()) {
+        Benchmark(args.GetSize(0, 1000000));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,378 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks HdRprComputeInstanceTransforms and HdRprFlattenInstanceTransforms against the previous serial implementation
+// and their interpolation between time samples.
+// Usage: testHdRprInstanceTransforms [--benchmark [number of instances]]
+
+#include "instancerTransforms.h"
+#include "testUtils.h"
+
+#include "pxr/base/gf/matrix4f.h"
+#include "pxr/base/gf/quatf.h"
+#include "pxr/base/gf/quath.h"
+#include "pxr/base/gf/rotation.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+// Serial implementation that HdRprInstancer used before: full 4x4 multiplication per primvar and instance
+namespace reference {
+
+template <typename T, typename Op>
+void ApplyTransform(VtValue const& allTransformsValue, VtIntArray const& instanceIndices, GfMatrix4d* transforms, Op op) {
+    auto& allTransforms = allTransformsValue.Get<VtArray<T>>();
+    for (size_t i = 0; i < instanceIndices.size(); ++i) {
+        transforms[i] = op(allTransforms[instanceIndices[i]]) * transforms[i];
+    }
+}
+
+HdTimeSampleArray<VtMatrix4dArray, 2> ComputeInstanceTransforms(
+    VtIntArray const& instanceIndices,
+    HdTimeSampleArray<GfMatrix4d, 2> const& instancerXform,
+    HdTimeSampleArray<VtValue, 2> const& instanceXforms,
+    HdTimeSampleArray<VtValue, 2> const& translates,
+    HdTimeSampleArray<VtValue, 2> const& rotates,
+    HdTimeSampleArray<VtValue, 2> const& scales) {
+    HdTimeSampleArray<VtMatrix4dArray, 2> sa;
+    sa.Resize(translates.count);
+    sa.times = translates.times;
+
+    for (size_t i = 0; i < sa.count; ++i) {
+        auto& transforms = sa.values[i];
+        transforms = VtMatrix4dArray(instanceIndices.size(), instancerXform.values[i]);
+
+        ApplyTransform<GfVec3f>(translates.values[i], instanceIndices, transforms.data(),
+            [](GfVec3f const& translate) { return GfMatrix4d(1).SetTranslate(GfVec3d(translate)); });
+        ApplyTransform<GfQuath>(rotates.values[i], instanceIndices, transforms.data(),
+            [](GfQuath const& rotate) { return GfMatrix4d(1).SetRotate(GfRotation(GfQuatd(rotate))); });
+        ApplyTransform<GfVec3f>(scales.values[i], instanceIndices, transforms.data(),
+            [](GfVec3f const& scale) { return GfMatrix4d(1).SetScale(GfVec3d(scale)); });
+        ApplyTransform<GfMatrix4f>(instanceXforms.values[i], instanceIndices, transforms.data(),
+            [](GfMatrix4f const& transform) { return GfMatrix4d(transform); });
+    }
+
+    return sa;
+}
+
+HdTimeSampleArray<VtMatrix4dArray, 2> FlattenInstanceTransforms(
+    HdTimeSampleArray<VtMatrix4dArray, 2> const& sa,
+    HdTimeSampleArray<VtMatrix4dArray, 2> const& parentXf) {
+    HdTimeSampleArray<VtMatrix4dArray, 2> result(sa);
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf(sa);
+    for (size_t i = 0; i < result.count; ++i) {
+        const float t = result.times[i];
+        VtMatrix4dArray curParentXf = parentXf.Resample(t);
+        VtMatrix4dArray curChildXf = childXf.Resample(t);
+        VtMatrix4dArray& flattened = result.values[i];
+        flattened.resize(curParentXf.size() * curChildXf.size());
+        for (size_t j = 0; j < curParentXf.size(); ++j) {
+            for (size_t k = 0; k < curChildXf.size(); ++k) {
+                flattened[j * curChildXf.size() + k] = curChildXf[k] * curParentXf[j];
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace reference
+
+template <typename T, typename F>
+HdTimeSampleArray<VtValue, 2> GeneratePrimvar(size_t numValues, F&& generate) {
+    HdTimeSampleArray<VtValue, 2> samples;
+    samples.Resize(2);
+    for (size_t i = 0; i < samples.count; ++i) {
+        samples.times[i] = float(i);
+
+        VtArray<T> values(numValues);
+        for (auto& value : values) {
+            value = generate();
+        }
+        samples.values[i] = VtValue(std::move(values));
+    }
+    return samples;
+}
+
+bool IsClose(HdTimeSampleArray<VtMatrix4dArray, 2> const& lhs, HdTimeSampleArray<VtMatrix4dArray, 2> const& rhs) {
+    if (lhs.count != rhs.count) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.count; ++i) {
+        if (lhs.times[i] != rhs.times[i] || lhs.values[i].size() != rhs.values[i].size()) {
+            return false;
+        }
+        for (size_t j = 0; j < lhs.values[i].size(); ++j) {
+            if (!GfIsClose(lhs.values[i][j], rhs.values[i][j], 1e-9)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// All primvars are sampled at the same times, so no interpolation is involved
+struct Inputs {
+    VtIntArray instanceIndices;
+    HdTimeSampleArray<GfMatrix4d, 2> instancerXform;
+    HdTimeSampleArray<VtValue, 2> translates;
+    HdTimeSampleArray<VtValue, 2> rotates;
+    HdTimeSampleArray<VtValue, 2> scales;
+    HdTimeSampleArray<VtValue, 2> instanceXforms;
+};
+
+Inputs GenerateInputs(size_t numInstances) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    auto random = [&]() { return distribution(generator); };
+
+    Inputs inputs;
+    inputs.instanceIndices = VtIntArray(numInstances);
+    for (size_t i = 0; i < numInstances; ++i) {
+        inputs.instanceIndices[i] = int(numInstances - i - 1);
+    }
+
+    inputs.instancerXform.Resize(2);
+    for (size_t i = 0; i < inputs.instancerXform.count; ++i) {
+        inputs.instancerXform.times[i] = float(i);
+        inputs.instancerXform.values[i] = GfMatrix4d(1).SetTranslate(GfVec3d(random(), random(), random()));
+    }
+
+    inputs.translates = GeneratePrimvar<GfVec3f>(numInstances, [&]() { return GfVec3f(random(), random(), random()) * 100.0f; });
+    inputs.rotates = GeneratePrimvar<GfQuath>(numInstances, [&]() { return GfQuath(GfQuatf(random(), random(), random(), random()).GetNormalized()); });
+    inputs.scales = GeneratePrimvar<GfVec3f>(numInstances, [&]() { return GfVec3f(random(), random(), random()) + GfVec3f(2.0f); });
+    inputs.instanceXforms = GeneratePrimvar<GfMatrix4f>(numInstances, [&]() { return GfMatrix4f(1).SetTranslate(GfVec3f(random(), random(), random())); });
+    return inputs;
+}
+
+HdTimeSampleArray<VtMatrix4dArray, 2> ComputeInstanceTransforms(Inputs const& inputs) {
+    return HdRprComputeInstanceTransforms(inputs.instanceIndices, inputs.instancerXform, inputs.instanceXforms, inputs.translates, inputs.rotates, inputs.scales);
+}
+
+HdTimeSampleArray<VtMatrix4dArray, 2> ComputeReferenceInstanceTransforms(Inputs const& inputs) {
+    return reference::ComputeInstanceTransforms(inputs.instanceIndices, inputs.instancerXform, inputs.instanceXforms, inputs.translates, inputs.rotates, inputs.scales);
+}
+
+// Nested instancer: every child instance is instantiated by each of the parent instances
+void SplitIntoNestedInstancers(
+    HdTimeSampleArray<VtMatrix4dArray, 2> const& transforms, size_t numParentInstances,
+    HdTimeSampleArray<VtMatrix4dArray, 2>* childXf, HdTimeSampleArray<VtMatrix4dArray, 2>* parentXf) {
+    size_t numChildInstances = transforms.values[0].size() / numParentInstances;
+    childXf->Resize(transforms.count);
+    childXf->times = transforms.times;
+    parentXf->Resize(transforms.count);
+    parentXf->times = transforms.times;
+    for (size_t i = 0; i < transforms.count; ++i) {
+        childXf->values[i] = VtMatrix4dArray(transforms.values[i].begin(), transforms.values[i].begin() + numChildInstances);
+        parentXf->values[i] = VtMatrix4dArray(transforms.values[i].end() - numParentInstances, transforms.values[i].end());
+    }
+}
+
+void TestMatchesReference(size_t numInstances) {
+    auto inputs = GenerateInputs(numInstances);
+    auto transforms = ComputeInstanceTransforms(inputs);
+    TF_AXIOM(IsClose(transforms, ComputeReferenceInstanceTransforms(inputs)));
+
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf;
+    HdTimeSampleArray<VtMatrix4dArray, 2> parentXf;
+    SplitIntoNestedInstancers(transforms, 10, &childXf, &parentXf);
+    TF_AXIOM(IsClose(HdRprFlattenInstanceTransforms(childXf, parentXf), reference::FlattenInstanceTransforms(childXf, parentXf)));
+}
+
+template <typename T>
+HdTimeSampleArray<VtValue, 2> MakePrimvar(std::vector<float> const& times, std::vector<VtArray<T>> const& values) {
+    HdTimeSampleArray<VtValue, 2> samples;
+    samples.Resize(times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+        samples.times[i] = times[i];
+        samples.values[i] = VtValue(values[i]);
+    }
+    return samples;
+}
+
+HdTimeSampleArray<GfMatrix4d, 2> MakeXform(std::vector<float> const& times, GfMatrix4d const& value) {
+    HdTimeSampleArray<GfMatrix4d, 2> samples;
+    samples.Resize(times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+        samples.times[i] = times[i];
+        samples.values[i] = value;
+    }
+    return samples;
+}
+
+GfMatrix4d ComposeInstanceTransform(GfMatrix4d const& instancerXform, GfVec3f const& translate, GfQuath const& rotate, GfVec3f const& scale) {
+    GfMatrix4d transform = GfMatrix4d(1).SetTranslate(GfVec3d(translate)) * instancerXform;
+    transform = GfMatrix4d(1).SetRotate(GfRotation(GfQuatd(rotate))) * transform;
+    return GfMatrix4d(1).SetScale(GfVec3d(scale)) * transform;
+}
+
+// Primvars are sampled sparser than the instancer transform, so they are interpolated at the times in between
+// of their samples and clamped to the first and the last sample outside of the sampled range
+void TestInterpolation() {
+    const float kPrimvarTimes[2] = {2.0f, 6.0f};
+    std::vector<float> xformTimes = {0.0f, 2.0f, 3.0f, 5.0f, 6.0f, 8.0f};
+
+    GfMatrix4d instancerMatrix = GfMatrix4d(1).SetTranslate(GfVec3d(1.0, 2.0, 3.0));
+    VtIntArray instanceIndices = {1, 0};
+
+    std::vector<VtVec3fArray> translates = {
+        {GfVec3f(0.0f), GfVec3f(1.0f, 0.0f, 0.0f)},
+        {GfVec3f(0.0f, 8.0f, 0.0f), GfVec3f(1.0f, 0.0f, 4.0f)},
+    };
+    std::vector<VtQuathArray> rotates = {
+        {GfQuath(1.0f), GfQuath(GfQuatf(0.0f, 1.0f, 0.0f, 0.0f))},
+        {GfQuath(1.0f), GfQuath(GfQuatf(1.0f, 1.0f, 0.0f, 0.0f).GetNormalized())},
+    };
+    std::vector<VtVec3fArray> scales = {
+        {GfVec3f(1.0f), GfVec3f(2.0f)},
+        {GfVec3f(3.0f), GfVec3f(0.5f, 1.0f, 2.0f)},
+    };
+
+    auto transforms = HdRprComputeInstanceTransforms(
+        instanceIndices,
+        MakeXform(xformTimes, instancerMatrix),
+        HdTimeSampleArray<VtValue, 2>(),
+        MakePrimvar<GfVec3f>({kPrimvarTimes[0], kPrimvarTimes[1]}, translates),
+        MakePrimvar<GfQuath>({kPrimvarTimes[0], kPrimvarTimes[1]}, rotates),
+        MakePrimvar<GfVec3f>({kPrimvarTimes[0], kPrimvarTimes[1]}, scales));
+
+    TF_AXIOM(transforms.count == xformTimes.size());
+    for (size_t i = 0; i < transforms.count; ++i) {
+        float time = transforms.times[i];
+        TF_AXIOM(time == xformTimes[i]);
+
+        float alpha = (time - kPrimvarTimes[0]) / (kPrimvarTimes[1] - kPrimvarTimes[0]);
+        alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+
+        TF_AXIOM(transforms.values[i].size() == instanceIndices.size());
+        for (size_t j = 0; j < instanceIndices.size(); ++j) {
+            int index = instanceIndices[j];
+            auto expected = ComposeInstanceTransform(instancerMatrix,
+                HdResampleNeighbors(alpha, translates[0][index], translates[1][index]),
+                HdResampleNeighbors(alpha, rotates[0][index], rotates[1][index]),
+                HdResampleNeighbors(alpha, scales[0][index], scales[1][index]));
+            TF_AXIOM(GfIsClose(transforms.values[i][j], expected, 1e-5));
+        }
+    }
+
+    // At t=3 the primvars of the second instance (index 0) are a quarter of the way between the samples
+    GfMatrix4d expectedAt3 = ComposeInstanceTransform(instancerMatrix, GfVec3f(0.0f, 2.0f, 0.0f), GfQuath(1.0f), GfVec3f(1.5f));
+    TF_AXIOM(GfIsClose(transforms.values[2][1], expectedAt3, 1e-5));
+}
+
+// A single sample is used for any time
+void TestSingleSample() {
+    VtIntArray instanceIndices = {0};
+    std::vector<VtVec3fArray> translates = {{GfVec3f(1.0f, 2.0f, 3.0f)}};
+    std::vector<VtQuathArray> rotates = {{GfQuath(GfQuatf(0.0f, 0.0f, 1.0f, 0.0f))}};
+    std::vector<VtVec3fArray> scales = {{GfVec3f(2.0f)}};
+    auto expected = ComposeInstanceTransform(GfMatrix4d(1), translates[0][0], rotates[0][0], scales[0][0]);
+
+    auto singleSample = HdRprComputeInstanceTransforms(
+        instanceIndices,
+        MakeXform({0.5f}, GfMatrix4d(1)),
+        HdTimeSampleArray<VtValue, 2>(),
+        MakePrimvar<GfVec3f>({0.5f}, translates),
+        MakePrimvar<GfQuath>({0.5f}, rotates),
+        MakePrimvar<GfVec3f>({0.5f}, scales));
+    TF_AXIOM(singleSample.count == 1);
+    TF_AXIOM(singleSample.times[0] == 0.5f);
+    TF_AXIOM(GfIsClose(singleSample.values[0][0], expected, 1e-5));
+
+    // The instancer is moving while instance primvars are static
+    auto staticPrimvars = HdRprComputeInstanceTransforms(
+        instanceIndices,
+        MakeXform({0.0f, 1.0f}, GfMatrix4d(1)),
+        HdTimeSampleArray<VtValue, 2>(),
+        MakePrimvar<GfVec3f>({0.5f}, translates),
+        MakePrimvar<GfQuath>({0.5f}, rotates),
+        MakePrimvar<GfVec3f>({0.5f}, scales));
+    TF_AXIOM(staticPrimvars.count == 2);
+    for (size_t i = 0; i < staticPrimvars.count; ++i) {
+        TF_AXIOM(GfIsClose(staticPrimvars.values[i][0], expected, 1e-5));
+    }
+}
+
+// Parent transforms are resampled at the times of the child samples
+void TestFlattenInterpolation() {
+    HdTimeSampleArray<VtMatrix4dArray, 2> parentXf;
+    parentXf.Resize(2);
+    parentXf.times[0] = 0.0f;
+    parentXf.times[1] = 4.0f;
+    parentXf.values[0] = {GfMatrix4d(1).SetTranslate(GfVec3d(0.0)), GfMatrix4d(1).SetScale(2.0)};
+    parentXf.values[1] = {GfMatrix4d(1).SetTranslate(GfVec3d(8.0, 0.0, 0.0)), GfMatrix4d(1).SetScale(4.0)};
+
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf;
+    childXf.Resize(3);
+    VtMatrix4dArray child = {GfMatrix4d(1).SetTranslate(GfVec3d(0.0, 1.0, 0.0))};
+    for (size_t i = 0; i < childXf.count; ++i) {
+        childXf.times[i] = float(i) * 2.0f - 1.0f;
+        childXf.values[i] = child;
+    }
+
+    auto flattened = HdRprFlattenInstanceTransforms(childXf, parentXf);
+    TF_AXIOM(flattened.count == childXf.count);
+    for (size_t i = 0; i < flattened.count; ++i) {
+        float alpha = std::min(std::max(flattened.times[i] / 4.0f, 0.0f), 1.0f);
+        TF_AXIOM(flattened.values[i].size() == parentXf.values[0].size());
+        for (size_t j = 0; j < parentXf.values[0].size(); ++j) {
+            auto parent = parentXf.values[0][j] * (1.0 - alpha) + parentXf.values[1][j] * alpha;
+            TF_AXIOM(GfIsClose(flattened.values[i][j], child[0] * parent, 1e-9));
+        }
+    }
+}
+
+void Benchmark(size_t numInstances) {
+    const size_t kNumParentInstances = 100;
+
+    auto inputs = GenerateInputs(numInstances);
+
+    printf("Sampling of %zu instances, 2 time samples:\n", numInstances);
+    RprUsdTestCompareSpeed("HdRprComputeInstanceTransforms",
+        [&]() { ComputeInstanceTransforms(inputs); },
+        [&]() { ComputeReferenceInstanceTransforms(inputs); });
+
+    HdTimeSampleArray<VtMatrix4dArray, 2> childXf;
+    HdTimeSampleArray<VtMatrix4dArray, 2> parentXf;
+    SplitIntoNestedInstancers(ComputeInstanceTransforms(inputs), kNumParentInstances, &childXf, &parentXf);
+
+    printf("Flattening of %zu x %zu instances, 2 time samples:\n", kNumParentInstances, childXf.values[0].size());
+    RprUsdTestCompareSpeed("HdRprFlattenInstanceTransforms",
+        [&]() { HdRprFlattenInstanceTransforms(childXf, parentXf); },
+        [&]() { reference::FlattenInstanceTransforms(childXf, parentXf); });
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    RprUsdTestArgs args(argc, argv);
+
+    TestMatchesReference(1000);
+    TestInterpolation();
+    TestSingleSample();
+    TestFlattenInterpolation();
+
+    if (args.IsBenchmark()) {
+        Benchmark(args.GetSize(0, 1000000));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks that HdRprConvertVdbGrid produces the same voxels as the serial ProcessVDBGrid on synthetic fog volumes.
+// Usage: testHdRprVdbGridConversion [--benchmark [sphere radius in voxels]]
+
+#include "vdbGridConversion.h"
+#include "RPRLibs/pluginUtils.hpp"
+#include "testUtils.h"
+
+#include "pxr/base/tf/diagnostic.h"
+
+#include <openvdb/tools/LevelSetSphere.h>
+#include <openvdb/tools/LevelSetUtil.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+using Voxel = std::pair<std::array<uint32_t, 3>, float>;
+
+std::vector<Voxel> GetSortedVoxels(VDBGrid<float> const& grid) {
+    std::vector<Voxel> voxels(grid.values.size());
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        voxels[i].first = {grid.coords[i * 3 + 0], grid.coords[i * 3 + 1], grid.coords[i * 3 + 2]};
+        voxels[i].second = grid.values[i];
+    }
+    std::sort(voxels.begin(), voxels.end());
+    return voxels;
+}
+
+openvdb::FloatGrid::Ptr CreateSyntheticGrid(float radius) {
+    auto grid = openvdb::tools::createLevelSetSphere<openvdb::FloatGrid>(radius, openvdb::Vec3f(0.0f), 1.0f);
+    openvdb::tools::sdfToFogVolume(*grid);
+
+    // Production caches store mostly leaf voxels
+    grid->tree().voxelizeActiveTiles();
+
+    // Keep one active tile to cover the path of internal nodes
+    auto tileOrigin = openvdb::Coord(int(radius) + 1024);
+    grid->tree().addTile(1, tileOrigin, 0.5f, true);
+
+    return grid;
+}
+
+void TestConversion(float radius) {
+    auto grid = CreateSyntheticGrid(radius);
+    openvdb::CoordBBox bbox = grid->evalActiveVoxelBoundingBox();
+
+    VDBGrid<float> reference;
+    TF_AXIOM(ProcessVDBGrid(reference, grid.get(), bbox));
+
+    VDBGrid<float> converted;
+    TF_AXIOM(HdRprConvertVdbGrid(grid.get(), bbox, &converted));
+
+    TF_AXIOM(converted.minValue == reference.minValue);
+    TF_AXIOM(converted.maxValue == reference.maxValue);
+    TF_AXIOM(converted.coords.size() == reference.coords.size());
+    TF_AXIOM(GetSortedVoxels(converted) == GetSortedVoxels(reference));
+}
+
+void Benchmark(float radius) {
+    auto grid = CreateSyntheticGrid(radius);
+    openvdb::CoordBBox bbox = grid->evalActiveVoxelBoundingBox();
+
+    printf("Synthetic grid: %zu active voxels, %zu leaves\n",
+        size_t(grid->activeVoxelCount()), size_t(grid->tree().leafCount()));
+    RprUsdTestCompareSpeed("HdRprConvertVdbGrid",
+        [&]() { VDBGrid<float> converted; HdRprConvertVdbGrid(grid.get(), bbox, &converted); },
+        [&]() { VDBGrid<float> reference; ProcessVDBGrid(reference, grid.get(), bbox); });
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    openvdb::initialize();
+
+    RprUsdTestArgs args(argc, argv);
+
+    for (float radius : {4.0f, 8.0f, 24.0f}) {
+        TestConversion(radius);
+    }
+
+    if (args.IsBenchmark()) {
+        Benchmark(float(args.GetReal(0, 128.0)));
+    }
+
+    return EXIT_SUCCESS;
+}
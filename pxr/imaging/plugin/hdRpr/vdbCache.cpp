@@ -0,0 +1,276 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "vdbCache.h"
+#include "debugCodes.h"
+
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/debug.h"
+#include "pxr/base/tf/envSetting.h"
+
+#include <openvdb/tools/GridTransformer.h>
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(HDRPR_VDB_CACHE_SIZE, 2048,
+    "Maximum size in megabytes of .vdb grids kept in memory after the volumes that use them are synced");
+
+namespace {
+
+std::string GetGridKey(std::string const& filepath, std::string const& gridName) {
+    // Null character can be neither in the file path nor in the grid name
+    std::string key;
+    key.reserve(filepath.size() + gridName.size() + 1);
+    key.append(filepath);
+    key.push_back('\0');
+    key.append(gridName);
+    return key;
+}
+
+std::string GetGridFilepath(std::string const& gridKey) {
+    return gridKey.substr(0, gridKey.find('\0'));
+}
+
+} // namespace anonymous
+
+HdRprVdbGrid::HdRprVdbGrid(openvdb::FloatGrid::ConstPtr grid, openvdb::MetaMap::ConstPtr fileMetadata)
+    : m_fileMetadata(std::move(fileMetadata))
+    , m_memoryUsage(0) {
+    m_levels[1].grid = std::move(grid);
+    UpdateMemoryUsageLocked();
+}
+
+HdRprVdbGrid::Level& HdRprVdbGrid::GetLevelLocked(int downsampleFactor) {
+    downsampleFactor = std::max(downsampleFactor, 1);
+
+    auto& level = m_levels[downsampleFactor];
+    if (!level.grid) {
+        auto& sourceGrid = *m_levels[1].grid;
+
+        auto transform = sourceGrid.transform().copy();
+        transform->preScale(double(downsampleFactor));
+
+        auto grid = openvdb::FloatGrid::create(sourceGrid.background());
+        grid->setTransform(transform);
+        grid->setGridClass(sourceGrid.getGridClass());
+        grid->setName(sourceGrid.getName());
+
+        // Multithreaded, filters the source grid when the target voxels are larger
+        openvdb::tools::resampleToMatch<openvdb::tools::BoxSampler>(sourceGrid, *grid);
+
+        TF_DEBUG(HD_RPR_DEBUG_VDB_CACHE).Msg("HdRprVdbCache: %s downsampled %d times: %zu -> %zu active voxels\n",
+            sourceGrid.getName().c_str(), downsampleFactor, size_t(sourceGrid.activeVoxelCount()), size_t(grid->activeVoxelCount()));
+
+        level.grid = std::move(grid);
+        UpdateMemoryUsageLocked();
+    }
+
+    return level;
+}
+
+openvdb::FloatGrid const* HdRprVdbGrid::GetVdbGrid(int downsampleFactor) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return GetLevelLocked(downsampleFactor).grid.get();
+}
+
+VDBGrid<float> HdRprVdbGrid::GetProcessedData(int downsampleFactor, openvdb::CoordBBox const& bbox, std::function<void(VDBGrid<float>*)> const& process) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& level = GetLevelLocked(downsampleFactor);
+    if (!level.hasProcessedData || level.processedBBox != bbox) {
+        level.processedData = VDBGrid<float>();
+        process(&level.processedData);
+        level.processedBBox = bbox;
+        level.hasProcessedData = true;
+        UpdateMemoryUsageLocked();
+    }
+
+    // VtArray is copy-on-write, callers that modify the data get their own copy
+    return level.processedData;
+}
+
+// The cache reads the size while holding its own lock, so it must not wait for m_mutex,
+// which is held during the conversion of the grid
+void HdRprVdbGrid::UpdateMemoryUsageLocked() {
+    size_t size = 0;
+    for (auto& entry : m_levels) {
+        auto& level = entry.second;
+        size += level.grid->memUsage();
+        size += level.processedData.coords.size() * sizeof(uint32_t);
+        size += level.processedData.values.size() * sizeof(float);
+        size += level.processedData.LUT.size() * sizeof(float);
+    }
+    m_memoryUsage = size;
+}
+
+HdRprVdbCache& HdRprVdbCache::Get() {
+    static HdRprVdbCache instance;
+    return instance;
+}
+
+HdRprVdbCache::HdRprVdbCache()
+    : m_maxSize(size_t(std::max(TfGetEnvSetting(HDRPR_VDB_CACHE_SIZE), 0)) * 1024 * 1024) {
+
+}
+
+std::vector<HdRprVdbGridSharedPtr> HdRprVdbCache::GetGrids(
+    std::string const& filepath,
+    std::vector<std::string> const& gridNames,
+    std::string* error) {
+    std::vector<HdRprVdbGridSharedPtr> grids(gridNames.size());
+
+    double fileModificationTime = 0.0;
+    ArchGetModificationTime(filepath.c_str(), &fileModificationTime);
+
+    std::shared_ptr<std::mutex> fileMutex;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& file = m_files[filepath];
+        if (!file.mutex) {
+            file.mutex = std::make_shared<std::mutex>();
+        }
+        fileMutex = file.mutex;
+    }
+    std::lock_guard<std::mutex> fileLock(*fileMutex);
+
+    bool hasMissingGrids = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < gridNames.size(); ++i) {
+            auto entryIt = m_entries.find(GetGridKey(filepath, gridNames[i]));
+            if (entryIt == m_entries.end()) {
+                hasMissingGrids = true;
+                continue;
+            }
+
+            auto& entry = entryIt->second;
+            if (entry.fileModificationTime != fileModificationTime) {
+                // The file was rewritten, the entry is replaced below
+                hasMissingGrids = true;
+                continue;
+            }
+
+            m_lru.splice(m_lru.end(), m_lru, entry.lruIt);
+            grids[i] = entry.grid;
+        }
+    }
+
+    if (!hasMissingGrids) {
+        TF_DEBUG(HD_RPR_DEBUG_VDB_CACHE).Msg("HdRprVdbCache: hit %s\n", filepath.c_str());
+        return grids;
+    }
+
+    TF_DEBUG(HD_RPR_DEBUG_VDB_CACHE).Msg("HdRprVdbCache: reading %s\n", filepath.c_str());
+
+    try {
+        openvdb::io::File file(filepath);
+        file.open();
+
+        openvdb::MetaMap::ConstPtr fileMetadata = file.getMetadata();
+
+        for (size_t i = 0; i < gridNames.size(); ++i) {
+            if (grids[i]) {
+                continue;
+            }
+
+            try {
+                auto baseGrid = file.readGrid(gridNames[i]);
+                if (baseGrid->type() != openvdb::FloatGrid::gridType()) {
+                    *error = "RPR supports scalar fields only";
+                    continue;
+                }
+
+                grids[i] = std::make_shared<HdRprVdbGrid>(openvdb::gridConstPtrCast<openvdb::FloatGrid>(baseGrid), fileMetadata);
+            } catch (openvdb::Exception const& e) {
+                *error = e.what();
+            }
+        }
+    } catch (openvdb::Exception const& e) {
+        *error = e.what();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EraseFileIfUncachedLocked(filepath);
+        return grids;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < gridNames.size(); ++i) {
+        if (!grids[i]) {
+            continue;
+        }
+
+        auto key = GetGridKey(filepath, gridNames[i]);
+        auto entryIt = m_entries.find(key);
+        if (entryIt != m_entries.end()) {
+            if (entryIt->second.grid == grids[i]) {
+                continue;
+            }
+            m_lru.erase(entryIt->second.lruIt);
+            m_entries.erase(entryIt);
+        } else {
+            m_files[filepath].numCachedGrids++;
+        }
+
+        m_lru.push_back(key);
+        m_entries.emplace(std::move(key), Entry{grids[i], fileModificationTime, std::prev(m_lru.end())});
+    }
+
+    EraseFileIfUncachedLocked(filepath);
+    TrimLocked();
+
+    return grids;
+}
+
+void HdRprVdbCache::TrimLocked() {
+    size_t totalSize = 0;
+    for (auto& entry : m_entries) {
+        totalSize += entry.second.grid->GetMemoryUsage();
+    }
+
+    for (auto it = m_lru.begin(); it != m_lru.end() && totalSize > m_maxSize;) {
+        auto entryIt = m_entries.find(*it);
+        auto& grid = entryIt->second.grid;
+
+        // Grids referenced by volume prims would stay in memory anyway
+        if (grid.use_count() > 1) {
+            ++it;
+            continue;
+        }
+
+        TF_DEBUG(HD_RPR_DEBUG_VDB_CACHE).Msg("HdRprVdbCache: evicting %s\n", it->c_str());
+
+        totalSize -= grid->GetMemoryUsage();
+        m_entries.erase(entryIt);
+
+        auto filepath = GetGridFilepath(*it);
+        auto fileIt = m_files.find(filepath);
+        if (fileIt != m_files.end()) {
+            fileIt->second.numCachedGrids--;
+            EraseFileIfUncachedLocked(filepath);
+        }
+
+        it = m_lru.erase(it);
+    }
+}
+
+// Threads that are reading the file keep their copy of its mutex
+void HdRprVdbCache::EraseFileIfUncachedLocked(std::string const& filepath) {
+    auto fileIt = m_files.find(filepath);
+    if (fileIt != m_files.end() && fileIt->second.numCachedGrids == 0) {
+        m_files.erase(fileIt);
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
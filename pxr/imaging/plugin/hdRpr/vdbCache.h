@@ -0,0 +1,127 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_VDB_CACHE_H
+#define HDRPR_VDB_CACHE_H
+
+#include "RPRLibs/pluginUtils.h"
+
+#include "pxr/pxr.h"
+
+#include <openvdb/openvdb.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Float grid read from a .vdb file together with the metadata of the file
+/// and the voxels of the grid converted to the RPR layout.
+///
+/// Downsampled versions of the grid, which are used to fit volumes into the voxel budget
+/// of the interactive mode, are created on demand and kept alongside the source grid.
+class HdRprVdbGrid {
+public:
+    HdRprVdbGrid(openvdb::FloatGrid::ConstPtr grid, openvdb::MetaMap::ConstPtr fileMetadata);
+
+    /// Returns the grid with voxels downsampleFactor times larger than the ones of the source grid.
+    /// The transform of the returned grid is scaled accordingly
+    openvdb::FloatGrid const* GetVdbGrid(int downsampleFactor = 1);
+    openvdb::MetaMap const* GetFileMetadata() const { return m_fileMetadata.get(); }
+
+    /// Returns the voxels of the downsampled grid within bbox in the RPR layout.
+    /// process is called only when the grid was not converted for the same bbox before
+    VDBGrid<float> GetProcessedData(int downsampleFactor, openvdb::CoordBBox const& bbox, std::function<void(VDBGrid<float>*)> const& process);
+
+    /// Returns the memory used by all levels of the grid. Does not wait for a conversion in progress,
+    /// the size is updated once a level or its converted data is created
+    size_t GetMemoryUsage() const { return m_memoryUsage; }
+
+private:
+    struct Level {
+        openvdb::FloatGrid::ConstPtr grid;
+
+        openvdb::CoordBBox processedBBox;
+        VDBGrid<float> processedData;
+        bool hasProcessedData = false;
+    };
+    Level& GetLevelLocked(int downsampleFactor);
+    void UpdateMemoryUsageLocked();
+
+private:
+    openvdb::MetaMap::ConstPtr m_fileMetadata;
+
+    std::mutex m_mutex;
+    std::map<int, Level> m_levels;
+    std::atomic<size_t> m_memoryUsage;
+};
+
+using HdRprVdbGridSharedPtr = std::shared_ptr<HdRprVdbGrid>;
+
+/// Process-wide cache of grids read from .vdb files.
+///
+/// Grids are keyed by the file path, the grid name and the modification time of the file.
+/// A file sequence has a separate path per frame, so frames are cached independently.
+/// Volume re-syncs that do not change the fields are served from memory,
+/// and all grids requested from one file at once are read with a single open of that file.
+/// Once the total size exceeds HDRPR_VDB_CACHE_SIZE, least recently used grids are evicted,
+/// grids that are still referenced by volume prims are kept.
+class HdRprVdbCache {
+public:
+    static HdRprVdbCache& Get();
+
+    /// Returns the grids in the order of gridNames. Grids that could not be read are nullptr,
+    /// the error of the last such grid is written to error.
+    /// Can be called from multiple threads
+    std::vector<HdRprVdbGridSharedPtr> GetGrids(
+        std::string const& filepath,
+        std::vector<std::string> const& gridNames,
+        std::string* error);
+
+private:
+    HdRprVdbCache();
+
+    void TrimLocked();
+    void EraseFileIfUncachedLocked(std::string const& filepath);
+
+private:
+    size_t m_maxSize;
+
+    struct Entry {
+        HdRprVdbGridSharedPtr grid;
+        double fileModificationTime;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    struct File {
+        // Serializes reads of the file so that concurrently synced volumes read it only once
+        std::shared_ptr<std::mutex> mutex;
+        size_t numCachedGrids = 0;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;
+    std::unordered_map<std::string, File> m_files;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_VDB_CACHE_H
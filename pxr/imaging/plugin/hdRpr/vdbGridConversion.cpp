@@ -0,0 +1,134 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "vdbGridConversion.h"
+
+#include "pxr/base/work/loops.h"
+
+#include <openvdb/tree/LeafManager.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+bool HdRprConvertVdbGrid(openvdb::FloatGrid const* grid, openvdb::CoordBBox const& bbox, VDBGrid<float>* outGrid) {
+    using TreeType = openvdb::FloatGrid::TreeType;
+
+    if (!grid || !outGrid) {
+        return false;
+    }
+
+    // Active tiles of internal nodes are rare, gather them separately so that leaf nodes can be processed in parallel
+    std::vector<std::pair<openvdb::Coord, float>> activeTiles;
+    {
+        auto iter = grid->tree().cbeginValueOn();
+        iter.setMaxDepth(TreeType::ValueOnCIter::LEAF_DEPTH - 1);
+        for (; iter; ++iter) {
+            activeTiles.emplace_back(iter.getCoord(), *iter);
+        }
+    }
+
+    openvdb::tree::LeafManager<const TreeType> leafManager(grid->tree());
+    size_t numLeaves = leafManager.leafCount();
+
+    // Count voxels per leaf, a prefix sum gives the offset of each leaf in the output arrays
+    std::vector<size_t> leafOffsets(numLeaves + 1, 0);
+    WorkParallelForN(numLeaves,
+        [&leafManager, &leafOffsets](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                leafOffsets[i + 1] = leafManager.leaf(i).onVoxelCount();
+            }
+        }
+    );
+    for (size_t i = 0; i < numLeaves; ++i) {
+        leafOffsets[i + 1] += leafOffsets[i];
+    }
+
+    size_t numLeafVoxels = leafOffsets[numLeaves];
+    size_t numValues = numLeafVoxels + activeTiles.size();
+
+    outGrid->values.resize(numValues);
+    outGrid->coords.resize(numValues * 3);
+    float* values = outGrid->values.data();
+    uint32_t* coords = outGrid->coords.data();
+
+    // Background value is not added by vdb automatically
+    float background = grid->background();
+    openvdb::Coord const& lowerBound = bbox.min();
+    auto writeVoxel = [=](size_t index, openvdb::Coord const& coord, float value) {
+        coords[index * 3 + 0] = coord.x() - lowerBound.x();
+        coords[index * 3 + 1] = coord.y() - lowerBound.y();
+        coords[index * 3 + 2] = coord.z() - lowerBound.z();
+        values[index] = value + background;
+    };
+
+    std::vector<float> leafMinValues(numLeaves);
+    std::vector<float> leafMaxValues(numLeaves);
+    WorkParallelForN(numLeaves,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto iter = leafManager.leaf(i).cbeginValueOn();
+                if (!iter) {
+                    continue;
+                }
+
+                float minValue = *iter;
+                float maxValue = *iter;
+                for (size_t index = leafOffsets[i]; iter; ++iter, ++index) {
+                    float value = *iter;
+                    writeVoxel(index, iter.getCoord(), value);
+
+                    minValue = std::min(minValue, value);
+                    maxValue = std::max(maxValue, value);
+                }
+
+                leafMinValues[i] = minValue;
+                leafMaxValues[i] = maxValue;
+            }
+        }
+    );
+
+    bool hasMinMax = false;
+    auto reduceMinMax = [outGrid, &hasMinMax](float minValue, float maxValue) {
+        if (hasMinMax) {
+            outGrid->minValue = std::min(outGrid->minValue, minValue);
+            outGrid->maxValue = std::max(outGrid->maxValue, maxValue);
+        } else {
+            outGrid->minValue = minValue;
+            outGrid->maxValue = maxValue;
+            hasMinMax = true;
+        }
+    };
+
+    for (size_t i = 0; i < numLeaves; ++i) {
+        if (leafOffsets[i] != leafOffsets[i + 1]) {
+            reduceMinMax(leafMinValues[i], leafMaxValues[i]);
+        }
+    }
+
+    for (size_t i = 0; i < activeTiles.size(); ++i) {
+        writeVoxel(numLeafVoxels + i, activeTiles[i].first, activeTiles[i].second);
+        reduceMinMax(activeTiles[i].second, activeTiles[i].second);
+    }
+
+    if (!hasMinMax) {
+        // Empty grid, keep the result of the serial path
+        grid->evalMinMax(outGrid->minValue, outGrid->maxValue);
+    }
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
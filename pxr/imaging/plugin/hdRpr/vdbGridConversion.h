@@ -0,0 +1,33 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDRPR_VDB_GRID_CONVERSION_H
+#define HDRPR_VDB_GRID_CONVERSION_H
+
+#include "RPRLibs/pluginUtils.h"
+
+#include "pxr/pxr.h"
+
+#include <openvdb/openvdb.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Converts active voxels of the grid into the RPR layout: coordinates relative to bbox.min()
+/// and values offset by the grid background. Produces the same voxels as ProcessVDBGrid from RPRLibs
+/// but processes leaf nodes in parallel and reduces min/max values in the same pass.
+/// The order of voxels is unspecified
+bool HdRprConvertVdbGrid(openvdb::FloatGrid const* grid, openvdb::CoordBBox const& bbox, VDBGrid<float>* outGrid);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDRPR_VDB_GRID_CONVERSION_H
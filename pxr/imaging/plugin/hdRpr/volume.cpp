@@ -18,6 +18,10 @@ using json = nlohmann::json;
 #include "field.h"
 #include "rprApi.h"
 #include "renderParam.h"
+#include "vdbCache.h"
+#include "vdbGridConversion.h"
+
+#include "pxr/imaging/rprUsd/timeline.h"
 
 #include "RPRLibs/pluginUtils.hpp"
 
@@ -27,9 +31,12 @@ using json = nlohmann::json;
 #include "pxr/usd/sdf/assetPath.h"
 #include "pxr/usd/usdLux/blackbody.h"
 #include "pxr/usd/usdVol/tokens.h"
+#include "pxr/base/work/loops.h"
 
 #include <openvdb/openvdb.h>
 
+#include <cmath>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 TF_DEFINE_PRIVATE_TOKENS(
@@ -187,12 +194,14 @@ T HdRprResampleRawTimeSamples(
 
 struct GridInfo {
     std::string filepath;
+    std::string gridName;
     openvdb::FloatGrid const* vdbGrid = nullptr;
+    HdRprVdbGridSharedPtr cachedGrid;
     HdVolumeFieldDescriptor const* desc;
     GridParameters params;
 };
 
-void ParseOpenvdbMetadata(GridInfo* grid) {
+void ParseOpenvdbMetadata(GridInfo* grid, openvdb::MetaMap const& metadata) {
     auto isAllParametersParsed = [](GridInfo* grid) {
         // We parse only these parameters from .vdb file metadata
         static constexpr auto metadataParameters = GridParameters::kRampAuthored | GridParameters::kScaleAuthored;
@@ -212,92 +221,84 @@ void ParseOpenvdbMetadata(GridInfo* grid) {
     auto cdrampMd = metadataNamePrefix + "cdramp";
     auto scaleMd = metadataNamePrefix + "scale";
 
-    try {
-        openvdb::io::File file(grid->filepath);
-        file.open();
-
-        auto metadata = file.getMetadata();
-        for (auto it = metadata->beginMeta(); it != metadata->endMeta() && !isAllParametersParsed(grid); ++it) {
-            if (it->first == cdrampMd) {
-                if (grid->params.authoredParamsMask & GridParameters::kRampAuthored) {
-                    continue;
-                }
-
-                try {
-                    auto root = json::parse(it->second->str());
-                    if (root["colortype"] == "RGB") {
-                        auto points = root["points"];
-                        auto pointsIt = points.begin();
-
-                        // First element is always number of points
-                        int numPoints = pointsIt->get<int>();
-                        if (numPoints <= 0) {
-                            TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - incorrect number of points %d", grid->filepath.c_str(), cdrampMd.c_str(), numPoints);
-                            continue;
-                        }
-                        ++pointsIt;
+    for (auto it = metadata.beginMeta(); it != metadata.endMeta() && !isAllParametersParsed(grid); ++it) {
+        if (it->first == cdrampMd) {
+            if (grid->params.authoredParamsMask & GridParameters::kRampAuthored) {
+                continue;
+            }
 
-                        std::vector<float> parameters;
-                        std::vector<GfVec3f> colors;
+            try {
+                auto root = json::parse(it->second->str());
+                if (root["colortype"] == "RGB") {
+                    auto points = root["points"];
+                    auto pointsIt = points.begin();
+
+                    // First element is always number of points
+                    int numPoints = pointsIt->get<int>();
+                    if (numPoints <= 0) {
+                        TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - incorrect number of points %d", grid->filepath.c_str(), cdrampMd.c_str(), numPoints);
+                        continue;
+                    }
+                    ++pointsIt;
 
-                        parameters.reserve(std::min(64, numPoints));
-                        colors.reserve(std::min(64, numPoints));
+                    std::vector<float> parameters;
+                    std::vector<GfVec3f> colors;
 
-                        for (; pointsIt != points.end(); ++pointsIt) {
-                            if (numPoints == 0) {
-                                TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - excessive number of points", grid->filepath.c_str(), cdrampMd.c_str());
-                                continue;
-                            }
+                    parameters.reserve(std::min(64, numPoints));
+                    colors.reserve(std::min(64, numPoints));
 
-                            auto& point = (*pointsIt);
-                            parameters.push_back(point["t"].get<float>());
+                    for (; pointsIt != points.end(); ++pointsIt) {
+                        if (numPoints == 0) {
+                            TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - excessive number of points", grid->filepath.c_str(), cdrampMd.c_str());
+                            continue;
+                        }
 
-                            GfVec3f color;
-                            auto rgba = point["rgba"];
-                            for (int i = 0; i < 3; ++i) {
-                                color[i] = rgba[i].get<float>();
-                            }
-                            colors.push_back(color);
+                        auto& point = (*pointsIt);
+                        parameters.push_back(point["t"].get<float>());
 
-                            numPoints--;
+                        GfVec3f color;
+                        auto rgba = point["rgba"];
+                        for (int i = 0; i < 3; ++i) {
+                            color[i] = rgba[i].get<float>();
                         }
+                        colors.push_back(color);
 
-                        if (numPoints != 0) {
-                            TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - insufficient number of points", grid->filepath.c_str(), cdrampMd.c_str());
-                            continue;
-                        }
+                        numPoints--;
+                    }
 
-                        // RPR expects linearly interpolated ramp
-                        // Houdini's ramp is defined as parameter-color pair (the parameter is in [0; 1] range)
-                        // Here we convert arbitrarily distributed color ramp to a linear ramp
-                        auto& ramp = grid->params.ramp;
-                        ramp.reserve(kLookupTableGranularityLevel);
-                        for (int i = 0; i < kLookupTableGranularityLevel; ++i) {
-                            float t = static_cast<float>(i) / (kLookupTableGranularityLevel - 1);
-                            ramp.push_back(HdRprResampleRawTimeSamples(t, parameters.size(), parameters.data(), colors.data()));
-                        }
-                        grid->params.authoredParamsMask |= GridParameters::kRampAuthored;
+                    if (numPoints != 0) {
+                        TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - insufficient number of points", grid->filepath.c_str(), cdrampMd.c_str());
+                        continue;
                     }
-                } catch (json::exception& e) {
-                    TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - %s", grid->filepath.c_str(), cdrampMd.c_str(), e.what());
-                }
-            } else if (it->first == scaleMd) {
-                if (grid->params.authoredParamsMask & GridParameters::kScaleAuthored) {
-                    continue;
-                }
 
-                if (it->second->typeName() == "float") {
-                    try {
-                        grid->params.scale *= std::stof(it->second->str()) * 0.01f;
-                        grid->params.authoredParamsMask |= GridParameters::kScaleAuthored;
-                    } catch (std::exception& e) {
-                        TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - %s", grid->filepath.c_str(), scaleMd.c_str(), e.what());
+                    // RPR expects linearly interpolated ramp
+                    // Houdini's ramp is defined as parameter-color pair (the parameter is in [0; 1] range)
+                    // Here we convert arbitrarily distributed color ramp to a linear ramp
+                    auto& ramp = grid->params.ramp;
+                    ramp.reserve(kLookupTableGranularityLevel);
+                    for (int i = 0; i < kLookupTableGranularityLevel; ++i) {
+                        float t = static_cast<float>(i) / (kLookupTableGranularityLevel - 1);
+                        ramp.push_back(HdRprResampleRawTimeSamples(t, parameters.size(), parameters.data(), colors.data()));
                     }
+                    grid->params.authoredParamsMask |= GridParameters::kRampAuthored;
+                }
+            } catch (json::exception& e) {
+                TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - %s", grid->filepath.c_str(), cdrampMd.c_str(), e.what());
+            }
+        } else if (it->first == scaleMd) {
+            if (grid->params.authoredParamsMask & GridParameters::kScaleAuthored) {
+                continue;
+            }
+
+            if (it->second->typeName() == "float") {
+                try {
+                    grid->params.scale *= std::stof(it->second->str()) * 0.01f;
+                    grid->params.authoredParamsMask |= GridParameters::kScaleAuthored;
+                } catch (std::exception& e) {
+                    TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": invalid %s - %s", grid->filepath.c_str(), scaleMd.c_str(), e.what());
                 }
             }
         }
-    } catch (openvdb::IoError const& e) {
-        TF_RUNTIME_ERROR("Failed to parse openvdb metadata \"%s\": %s", grid->filepath.c_str(), e.what());
     }
 }
 
@@ -325,9 +326,14 @@ void NormalizeGrid(VDBGrid<float>* grid) {
 
     float offset = -grid->minValue;
     float scale = 1.0f / (grid->maxValue - grid->minValue);
-    for (auto& value : grid->values) {
-        value = value * scale + offset;
-    }
+    float* values = grid->values.data();
+    WorkParallelForN(grid->values.size(),
+        [values, scale, offset](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                values[i] = values[i] * scale + offset;
+            }
+        }
+    );
 
     grid->minValue = 0.0f;
     grid->maxValue = 1.0f;
@@ -350,6 +356,7 @@ void HdRprVolume::Sync(
     HdRenderParam* renderParam,
     HdDirtyBits* dirtyBits,
     TfToken const& reprName) {
+    RprUsdTimelineZone zone("HdRprVolume::Sync", GetId().GetText());
 
     auto rprRenderParam = static_cast<HdRprRenderParam*>(renderParam);
     auto rprApi = rprRenderParam->AcquireRprApiForEdit();
@@ -372,105 +379,162 @@ void HdRprVolume::Sync(
         m_rprVolume = nullptr;
 
         openvdb::initialize();
-        std::map<std::string, openvdb::GridBase::Ptr> retainedVDBGrids;
-
-        auto getVdbGrid = [&](SdfPath const& fieldId, std::string const& openvdbPath) -> openvdb::FloatGrid const* {
-            auto fieldName = sceneDelegate->Get(fieldId, UsdVolTokens->fieldName).GetWithDefault(TfToken());
-            if (IsInMemoryVdb(openvdbPath)) {
-                auto houdiniGrid = HoudiniOpenvdbLoader::Instance().GetGrid(openvdbPath.c_str(), fieldName.GetText());
-                if (houdiniGrid->type() != openvdb::FloatGrid::gridType()) {
-                    TF_RUNTIME_ERROR("[%s] Failed to read vdb grid \"%s\": RPR supports scalar fields only", id.GetName().c_str(), openvdbPath.c_str());
-                    return nullptr;
-                }
-                return static_cast<openvdb::FloatGrid const*>(houdiniGrid);
-            } else {
-                auto gridId = openvdbPath + fieldName.GetString();
-                auto gridIter = retainedVDBGrids.find(gridId);
-                if (gridIter != retainedVDBGrids.end()) {
-                    return static_cast<openvdb::FloatGrid const*>(gridIter->second.get());
-                }
-
-                try {
-                    openvdb::io::File file(openvdbPath);
-                    file.open();
-                    auto grid = file.readGrid(fieldName.GetString());
-                    if (grid->type() != openvdb::FloatGrid::gridType()) {
-                        TF_RUNTIME_ERROR("[%s] Failed to read vdb grid from file \"%s\": RPR supports scalar fields only", id.GetName().c_str(), openvdbPath.c_str());
-                        return nullptr;
-                    }
-                    auto ret = static_cast<openvdb::FloatGrid const*>(grid.get());
-                    retainedVDBGrids[gridId] = std::move(grid);
-                    return ret;
-                } catch (openvdb::Exception const& e) {
-                    TF_RUNTIME_ERROR("[%s] Failed to read vdb grid from file \"%s\": %s", id.GetName().c_str(), openvdbPath.c_str(), e.what());
-                }
-            }
-
-            return nullptr;
-        };
 
+        decltype(m_vdbGrids) vdbGrids;
         decltype(m_fieldSubscriptions) activeFieldSubscriptions;
 
-        auto processVdbGridInfo = [&](GridInfo& targetInfo, const HdVolumeFieldDescriptor& desc) {
-            auto param = sceneDelegate->Get(desc.fieldId, UsdVolTokens->filePath);
-            if (param.IsHolding<SdfAssetPath>()) {
-                targetInfo.desc = &desc;
-
-                auto& assetPath = param.UncheckedGet<SdfAssetPath>();
-                if (!assetPath.GetResolvedPath().empty()) {
-                    targetInfo.filepath = assetPath.GetResolvedPath();
-                }
-                else {
-                    targetInfo.filepath = assetPath.GetAssetPath();
-                }
-
-                targetInfo.params = ParseGridParameters(sceneDelegate, desc.fieldId);
-
-                targetInfo.vdbGrid = getVdbGrid(desc.fieldId, targetInfo.filepath);
-                if (targetInfo.vdbGrid) {
-                    ParseOpenvdbMetadata(&targetInfo);
-
-                    // Subscribe for field updates, more info in renderParam.h
-                    auto fieldSubscription = m_fieldSubscriptions.find(desc.fieldId);
-                    if (fieldSubscription == m_fieldSubscriptions.end()) {
-                        activeFieldSubscriptions.emplace(desc.fieldId, rprRenderParam->SubscribeVolumeForFieldUpdates(this, desc.fieldId));
-                    }
-                    else {
-                        // Reuse the old one
-                        activeFieldSubscriptions.emplace(desc.fieldId, std::move(fieldSubscription->second));
-                    }
-                }
-            }
-        };
-
         GridInfo densityGridInfo;
         GridInfo emissionGridInfo;
         GridInfo albedoGridInfo;
 
-        bool densityGridFound = false;
+        HdVolumeFieldDescriptor const* densityDesc = nullptr;
+        HdVolumeFieldDescriptor const* albedoDesc = nullptr;
 
         auto volumeFieldDescriptorVector = sceneDelegate->GetVolumeFieldDescriptors(GetId());
 
         //try to find grids by it's names
         for (auto const& desc : volumeFieldDescriptorVector) {
             if (desc.fieldName == HdRprVolumeTokens->density) {
-                processVdbGridInfo(densityGridInfo, desc);
-                densityGridFound = true;
+                densityDesc = &desc;
             }
             else if (desc.fieldName == HdRprVolumeTokens->color) {
-                processVdbGridInfo(albedoGridInfo, desc);
+                albedoDesc = &desc;
             }
             // now processing of temperature grid is temporary disabled because it can produce incorrect result. It will be re-implemented in the future using volume material 
         }
 
         // if density grid is not found we try to use the first grid as density
-        if (!densityGridFound && volumeFieldDescriptorVector.size() > 0) {
-            processVdbGridInfo(densityGridInfo, volumeFieldDescriptorVector[0]);
+        if (!densityDesc && volumeFieldDescriptorVector.size() > 0) {
+            densityDesc = &volumeFieldDescriptorVector[0];
+        }
+
+        std::pair<GridInfo*, HdVolumeFieldDescriptor const*> requestedGrids[] = {
+            {&densityGridInfo, densityDesc},
+            {&albedoGridInfo, albedoDesc},
+        };
+
+        // Group the grids by file so that the grids stored in one file are read at once
+        std::map<std::string, std::vector<GridInfo*>> fileGridInfos;
+
+        for (auto& requestedGrid : requestedGrids) {
+            auto& targetInfo = *requestedGrid.first;
+            auto desc = requestedGrid.second;
+            if (!desc) {
+                continue;
+            }
+
+            auto param = sceneDelegate->Get(desc->fieldId, UsdVolTokens->filePath);
+            if (!param.IsHolding<SdfAssetPath>()) {
+                continue;
+            }
+
+            targetInfo.desc = desc;
+
+            auto& assetPath = param.UncheckedGet<SdfAssetPath>();
+            if (!assetPath.GetResolvedPath().empty()) {
+                targetInfo.filepath = assetPath.GetResolvedPath();
+            }
+            else {
+                targetInfo.filepath = assetPath.GetAssetPath();
+            }
+
+            targetInfo.gridName = sceneDelegate->Get(desc->fieldId, UsdVolTokens->fieldName).GetWithDefault(TfToken()).GetString();
+            targetInfo.params = ParseGridParameters(sceneDelegate, desc->fieldId);
+
+            if (IsInMemoryVdb(targetInfo.filepath)) {
+                auto houdiniGrid = HoudiniOpenvdbLoader::Instance().GetGrid(targetInfo.filepath.c_str(), targetInfo.gridName.c_str());
+                if (houdiniGrid->type() != openvdb::FloatGrid::gridType()) {
+                    TF_RUNTIME_ERROR("[%s] Failed to read vdb grid \"%s\": RPR supports scalar fields only", id.GetName().c_str(), targetInfo.filepath.c_str());
+                } else {
+                    targetInfo.vdbGrid = static_cast<openvdb::FloatGrid const*>(houdiniGrid);
+                }
+            } else {
+                fileGridInfos[targetInfo.filepath].push_back(&targetInfo);
+            }
+        }
+
+        for (auto& entry : fileGridInfos) {
+            auto& filepath = entry.first;
+            auto& gridInfos = entry.second;
+
+            std::vector<std::string> gridNames;
+            gridNames.reserve(gridInfos.size());
+            for (auto gridInfo : gridInfos) {
+                gridNames.push_back(gridInfo->gridName);
+            }
+
+            std::string error;
+            auto grids = HdRprVdbCache::Get().GetGrids(filepath, gridNames, &error);
+            for (size_t i = 0; i < gridInfos.size(); ++i) {
+                if (!grids[i]) {
+                    TF_RUNTIME_ERROR("[%s] Failed to read vdb grid \"%s\" from file \"%s\": %s", id.GetName().c_str(), gridNames[i].c_str(), filepath.c_str(), error.c_str());
+                    continue;
+                }
+
+                gridInfos[i]->vdbGrid = grids[i]->GetVdbGrid();
+                gridInfos[i]->cachedGrid = grids[i];
+                vdbGrids.push_back(grids[i]);
+            }
+        }
+
+        for (auto& requestedGrid : requestedGrids) {
+            auto& targetInfo = *requestedGrid.first;
+            if (!targetInfo.vdbGrid) {
+                continue;
+            }
+
+            // Grids streamed from Houdini do not have file metadata
+            if (targetInfo.cachedGrid && targetInfo.cachedGrid->GetFileMetadata()) {
+                ParseOpenvdbMetadata(&targetInfo, *targetInfo.cachedGrid->GetFileMetadata());
+            }
+
+            // Subscribe for field updates, more info in renderParam.h
+            auto fieldId = targetInfo.desc->fieldId;
+            if (activeFieldSubscriptions.count(fieldId)) {
+                continue;
+            }
+
+            auto fieldSubscription = m_fieldSubscriptions.find(fieldId);
+            if (fieldSubscription == m_fieldSubscriptions.end()) {
+                activeFieldSubscriptions.emplace(fieldId, rprRenderParam->SubscribeVolumeForFieldUpdates(this, fieldId));
+            }
+            else {
+                // Reuse the old one
+                activeFieldSubscriptions.emplace(fieldId, std::move(fieldSubscription->second));
+            }
         }
 
         m_fieldSubscriptions.clear();
         std::swap(m_fieldSubscriptions, activeFieldSubscriptions);
 
+        // Keep the grids referenced so that the cache does not evict them while the volume exists
+        std::swap(m_vdbGrids, vdbGrids);
+
+        // In the interactive mode, volumes are downsampled to fit the voxel budget.
+        // All grids of the volume are downsampled equally so that they keep sharing the same transform
+        int downsampleFactor = 1;
+        size_t voxelBudget = rprRenderParam->GetVolumeVoxelBudget();
+        if (voxelBudget) {
+            size_t numActiveVoxels = 0;
+            bool isDownsamplingSupported = true;
+            for (auto gridInfo : {&densityGridInfo, &emissionGridInfo, &albedoGridInfo}) {
+                if (gridInfo->vdbGrid) {
+                    numActiveVoxels = std::max(numActiveVoxels, size_t(gridInfo->vdbGrid->activeVoxelCount()));
+                    // Grids streamed from Houdini are not cached, downsampling them on each sync would not pay off
+                    isDownsamplingSupported &= bool(gridInfo->cachedGrid);
+                }
+            }
+
+            if (isDownsamplingSupported && numActiveVoxels > voxelBudget) {
+                downsampleFactor = int(std::ceil(std::cbrt(double(numActiveVoxels) / voxelBudget)));
+                for (auto gridInfo : {&densityGridInfo, &emissionGridInfo, &albedoGridInfo}) {
+                    if (gridInfo->cachedGrid) {
+                        gridInfo->vdbGrid = gridInfo->cachedGrid->GetVdbGrid(downsampleFactor);
+                    }
+                }
+            }
+        }
+
         auto densityGrid = densityGridInfo.vdbGrid;
         auto emissionGrid = emissionGridInfo.vdbGrid;
         auto albedoGrid = albedoGridInfo.vdbGrid;
@@ -497,12 +561,25 @@ void HdRprVolume::Sync(
         if (albedoGrid) activeVoxelsBB.expand(albedoGrid->evalActiveVoxelBoundingBox());
         openvdb::Coord activeVoxelsBBSize = activeVoxelsBB.extents();
 
+        // Conversion of the cached grids is shared between volumes and re-syncs that use the same bounding box
+        auto processGrid = [&activeVoxelsBB, downsampleFactor](VDBGrid<float>* gridData, GridInfo const& gridInfo) {
+            auto process = [&](VDBGrid<float>* data) {
+                HdRprConvertVdbGrid(gridInfo.vdbGrid, activeVoxelsBB, data);
+            };
+
+            if (gridInfo.cachedGrid) {
+                *gridData = gridInfo.cachedGrid->GetProcessedData(downsampleFactor, activeVoxelsBB, process);
+            } else {
+                process(gridData);
+            }
+        };
+
         VDBGrid<float> densityGridData;
         VDBGrid<float> emissionGridData;
         VDBGrid<float> albedoGridData;
 
         if (densityGrid) {
-            ProcessVDBGrid(densityGridData, densityGridInfo.vdbGrid, activeVoxelsBB);
+            processGrid(&densityGridData, densityGridInfo);
 
             if (densityGridInfo.params.ramp.empty()) {
                 if ((densityGridInfo.params.authoredParamsMask & GridParameters::kNormalizeAuthored) == 0) {
@@ -542,7 +619,7 @@ void HdRprVolume::Sync(
                 emissionGridInfo.params.ramp.push_back(GfVec3f(1.0f));
             }
 
-            ProcessVDBGrid(emissionGridData, emissionGridInfo.vdbGrid, activeVoxelsBB);
+            processGrid(&emissionGridData, emissionGridInfo);
 
             if (emissionGridInfo.params.normalize) {
                 NormalizeGrid(&emissionGridData);
@@ -550,7 +627,7 @@ void HdRprVolume::Sync(
         }
 
         if (albedoGrid) {
-            ProcessVDBGrid(albedoGridData, albedoGridInfo.vdbGrid, activeVoxelsBB);
+            processGrid(&albedoGridData, albedoGridInfo);
             if (albedoGridInfo.params.normalize) {
                 NormalizeGrid(&albedoGridData);
             }
@@ -625,6 +702,7 @@ void HdRprVolume::_InitRepr(TfToken const& reprName,
 void HdRprVolume::Finalize(HdRenderParam* renderParam) {
     static_cast<HdRprRenderParam*>(renderParam)->AcquireRprApiForEdit()->Release(m_rprVolume);
     m_rprVolume = nullptr;
+    m_vdbGrids.clear();
 
     HdVolume::Finalize(renderParam);
 }
@@ -20,6 +20,7 @@ limitations under the License.
 PXR_NAMESPACE_OPEN_SCOPE
 
 struct HdRprApiVolume;
+class HdRprVdbGrid;
 
 class HdRprVolume : public HdVolume {
 public:
@@ -49,6 +50,7 @@ private:
     bool m_visibility = true;
 
     std::map<SdfPath, std::shared_ptr<HdRprVolume>> m_fieldSubscriptions;
+    std::vector<std::shared_ptr<HdRprVdbGrid>> m_vdbGrids;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
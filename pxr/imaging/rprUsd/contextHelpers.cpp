@@ -23,8 +23,13 @@ using json = nlohmann::json;
 #include "pxr/imaging/rprUsd/util.h"
 
 #include "pxr/base/arch/env.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/arch/timing.h"
 #include "pxr/base/tf/diagnostic.h"
 #include "pxr/base/tf/envSetting.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
 
 #include <RadeonProRender.hpp>
 
@@ -38,11 +43,21 @@ using json = nlohmann::json;
 #include <mach-o/dyld.h>
 #include <mach-o/getsect.h>
 #include <dlfcn.h>
+#include <sys/sysctl.h>
 #elif defined(__linux__)
 #include <link.h>
 #endif // __APPLE__
 
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif // WIN32
+
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <iterator>
 #include <thread>
 #include <map>
 
@@ -55,6 +70,8 @@ TF_DEFINE_ENV_SETTING(RPRUSD_ENABLE_TRACING, false, "Enable tracing of RPR core"
 TF_DEFINE_ENV_SETTING(RPRUSD_TRACING_DIR, "", "Where to store RPR core tracing files. Must be a path to valid directory");
 TF_DEFINE_ENV_SETTING(RPRUSD_CPU_ONLY, false,
     "Disable RIF API and GPU context creation.  This will allow running on CPU only machines, but some AOV will no longer work");
+TF_DEFINE_ENV_SETTING(RPRUSD_DEVICES_INFO_CACHE, true,
+    "Cache the list of available GPUs next to the devices configuration file. Disable to query GPUs on each run");
 
 namespace {
 
@@ -155,25 +172,239 @@ const std::map<RprUsdPluginType, const char*> kPluginLibNames = {
 #endif
 };
 
-rpr_int GetPluginID(RprUsdPluginType pluginType) {
+std::string GetPluginPath(RprUsdPluginType pluginType) {
     auto pluginLibNameIter = kPluginLibNames.find(pluginType);
     if (pluginLibNameIter == kPluginLibNames.end()) {
         TF_RUNTIME_ERROR("Plugin is not supported: %d", pluginType);
-        return -1;
+        return {};
     }
     auto pluginLibName = pluginLibNameIter->second;
 
     const std::string rprSdkPath = GetRprSdkPath();
-    const std::string pluginPath = rprSdkPath.empty() ? pluginLibName : rprSdkPath + "/" + pluginLibName;
+    return rprSdkPath.empty() ? pluginLibName : rprSdkPath + "/" + pluginLibName;
+}
+
+rpr_int GetPluginID(RprUsdPluginType pluginType) {
+    const std::string pluginPath = GetPluginPath(pluginType);
+    if (pluginPath.empty()) {
+        return -1;
+    }
+
     rpr_int pluginID = rprRegisterPlugin(pluginPath.c_str());
     if (pluginID == -1) {
-        TF_RUNTIME_ERROR("Failed to register %s plugin located at \"%s\"", pluginLibName, pluginPath.c_str());
+        TF_RUNTIME_ERROR("Failed to register %s plugin located at \"%s\"", kPluginLibNames.at(pluginType), pluginPath.c_str());
         return -1;
     }
 
     return pluginID;
 }
 
+std::string GetFileFingerprint(std::string const& path) {
+    double modificationTime = 0.0;
+    if (!ArchGetModificationTime(path.c_str(), &modificationTime)) {
+        return {};
+    }
+    return TfStringPrintf("%s:%lld:%.6f;", path.c_str(), static_cast<long long>(ArchGetFileLength(path.c_str())), modificationTime);
+}
+
+std::string GetFileContentFingerprint(std::string const& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return path + ":" + content + ";";
+}
+
+// Describes installed GPU drivers well enough to detect their updates.
+// Best effort: on CPU-only hosts it is simply empty
+std::string GetDriverFingerprint() {
+    std::string fingerprint;
+#ifdef WIN32
+    std::string systemDir = ArchGetEnv("SystemRoot") + "\\System32\\";
+    for (const char* driverLib : {"nvcuda.dll", "nvoglv64.dll", "amdhip64.dll", "amdhip64_6.dll", "atio6axx.dll", "OpenCL.dll", "vulkan-1.dll"}) {
+        fingerprint += GetFileFingerprint(systemDir + driverLib);
+    }
+#elif defined(__linux__)
+    // procfs and sysfs files do not have meaningful modification time, use their content instead
+    for (const char* versionFile : {"/proc/driver/nvidia/version", "/sys/module/amdgpu/version", "/opt/rocm/.info/version"}) {
+        fingerprint += GetFileContentFingerprint(versionFile);
+    }
+#elif defined(__APPLE__)
+    // Metal drivers are shipped with the OS
+    char osVersion[256] = {};
+    size_t osVersionSize = sizeof(osVersion);
+    if (sysctlbyname("kern.osversion", osVersion, &osVersionSize, nullptr, 0) == 0) {
+        fingerprint += osVersion;
+    }
+#endif
+    return fingerprint;
+}
+
+// Identifies the host and its display adapters, so that a cache shared between hosts
+// (e.g. through a network home directory) or a GPU replacement does not reuse a foreign device list
+std::string GetHostFingerprint() {
+    std::string fingerprint;
+#ifdef WIN32
+    char hostName[MAX_COMPUTERNAME_LENGTH + 1] = {};
+    DWORD hostNameSize = sizeof(hostName);
+    if (GetComputerNameA(hostName, &hostNameSize)) {
+        fingerprint += TfStringPrintf("host:%s;", hostName);
+    }
+
+    // DeviceID holds PCI vendor and device ids of the adapter
+    DISPLAY_DEVICEA displayDevice = {};
+    displayDevice.cb = sizeof(displayDevice);
+    for (DWORD i = 0; EnumDisplayDevicesA(nullptr, i, &displayDevice, 0); ++i) {
+        fingerprint += TfStringPrintf("%s:%s;", displayDevice.DeviceString, displayDevice.DeviceID);
+    }
+#else
+    char hostName[256] = {};
+    if (gethostname(hostName, sizeof(hostName) - 1) == 0) {
+        fingerprint += TfStringPrintf("host:%s;", hostName);
+    }
+
+#if defined(__linux__)
+    // uevent of DRM card holds its driver, PCI ids and slot name
+    const std::string drmDir = "/sys/class/drm";
+    std::vector<std::string> dirnames, filenames, symlinknames;
+    if (TfReadDir(drmDir, &dirnames, &filenames, &symlinknames)) {
+        std::vector<std::string> cards;
+        for (auto const* names : {&dirnames, &symlinknames}) {
+            for (auto& name : *names) {
+                // Skip connectors, e.g. card0-HDMI-A-1
+                if (TfStringStartsWith(name, "card") && name.find('-') == std::string::npos) {
+                    cards.push_back(name);
+                }
+            }
+        }
+        std::sort(cards.begin(), cards.end());
+
+        for (auto& card : cards) {
+            fingerprint += GetFileContentFingerprint(TfStringCatPaths(drmDir, card + "/device/uevent"));
+        }
+    }
+#elif defined(__APPLE__)
+    char hwModel[256] = {};
+    size_t hwModelSize = sizeof(hwModel);
+    if (sysctlbyname("hw.model", hwModel, &hwModelSize, nullptr, 0) == 0) {
+        fingerprint += TfStringPrintf("model:%s;", hwModel);
+    }
+#endif
+#endif // WIN32
+    return fingerprint;
+}
+
+std::string GetDevicesInfoFingerprint(RprUsdPluginType pluginType) {
+    std::string fingerprint = TfStringPrintf("api:%#x;", RPR_API_VERSION);
+    fingerprint += GetHostFingerprint();
+    fingerprint += GetFileFingerprint(GetPluginPath(pluginType));
+    fingerprint += GetDriverFingerprint();
+    return fingerprint;
+}
+
+std::string GetDevicesInfoCacheFilepath() {
+    std::string deviceConfigurationFilepath;
+    {
+        RprUsdConfig* config;
+        auto configLock = RprUsdConfig::GetInstance(&config);
+        deviceConfigurationFilepath = config->GetDeviceConfigurationFilepath();
+    }
+    return TfStringCatPaths(TfGetPathName(deviceConfigurationFilepath), "devicesInfoCache.json");
+}
+
+bool LoadCachedGpus(RprUsdPluginType pluginType, std::string const& fingerprint, std::vector<RprUsdDevicesInfo::GPU>* gpus) {
+    if (!TfGetEnvSetting(RPRUSD_DEVICES_INFO_CACHE)) {
+        return false;
+    }
+
+    try {
+        std::ifstream cacheFile(GetDevicesInfoCacheFilepath());
+        if (!cacheFile.is_open()) {
+            return false;
+        }
+
+        json cache;
+        cacheFile >> cache;
+
+        auto& entry = cache.at(TfEnum::GetName(pluginType));
+        if (entry.at("fingerprint").get<std::string>() != fingerprint) {
+            return false;
+        }
+
+        gpus->clear();
+        for (auto& gpu : entry.at("gpus")) {
+            gpus->emplace_back(gpu.at("index").get<int>(), gpu.at("name").get<std::string>());
+        }
+        return true;
+    } catch (std::exception& e) {
+        PRINT_CONTEXT_CREATION_DEBUG_INFO("Failed to load devices info cache: %s", e.what());
+        return false;
+    }
+}
+
+// Atomically replaces dst with src, readers observe either the old or the new file
+bool AtomicReplaceFile(std::string const& src, std::string const& dst) {
+#ifdef WIN32
+    return MoveFileExA(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(src.c_str(), dst.c_str()) == 0;
+#endif // WIN32
+}
+
+void StoreCachedGpus(RprUsdPluginType pluginType, std::string const& fingerprint, std::vector<RprUsdDevicesInfo::GPU> const& gpus) {
+    // Empty list is cached as well so that CPU-only hosts do not enumerate GPUs on each launch,
+    // installing a GPU or a driver changes the fingerprint and invalidates the entry
+    if (!TfGetEnvSetting(RPRUSD_DEVICES_INFO_CACHE)) {
+        return;
+    }
+
+    auto cacheFilepath = GetDevicesInfoCacheFilepath();
+
+    json cache = json::object();
+    try {
+        std::ifstream cacheFile(cacheFilepath);
+        if (cacheFile.is_open()) {
+            cacheFile >> cache;
+        }
+        if (!cache.is_object()) {
+            cache = json::object();
+        }
+    } catch (std::exception&) {
+        // Corrupted cache will be overwritten
+        cache = json::object();
+    }
+
+    json entry;
+    entry["fingerprint"] = fingerprint;
+    entry["gpus"] = json::array();
+    for (auto& gpu : gpus) {
+        entry["gpus"].push_back({{"index", gpu.index}, {"name", gpu.name}});
+    }
+    cache[TfEnum::GetName(pluginType)] = std::move(entry);
+
+    // Several processes might enumerate devices at the same time, write to a unique file and atomically replace the cache
+    auto tmpFilepath = TfStringPrintf("%s.%zu.tmp", cacheFilepath.c_str(), std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ size_t(ArchGetTickTime()));
+    {
+        std::ofstream tmpFile(tmpFilepath);
+        if (!tmpFile.is_open()) {
+            return;
+        }
+        tmpFile << cache.dump(4);
+        if (!tmpFile) {
+            tmpFile.close();
+            ArchUnlinkFile(tmpFilepath.c_str());
+            return;
+        }
+    }
+
+    if (!AtomicReplaceFile(tmpFilepath, cacheFilepath)) {
+        // The previous cache file is left intact, the next run will retry
+        ArchUnlinkFile(tmpFilepath.c_str());
+    }
+}
+
 std::string GetGpuName(RprUsdPluginType pluginType, rpr_int pluginID, rpr::CreationFlags creationFlag, rpr::ContextInfo gpuNameId, const char* cachePath) {
     rpr::CreationFlags additionalFlags = 0x0;
 
@@ -446,30 +677,36 @@ RprUsdDevicesInfo RprUsdGetDevicesInfo(RprUsdPluginType pluginType) {
     }
 
     RprUsdDevicesInfo ret = {};
+    ret.cpu.numThreads = RprUsdIsHybrid(pluginType) ? 0 : std::thread::hardware_concurrency();
 
-    if (RprUsdIsHybrid(pluginType)) {
-        ret.cpu.numThreads = 0;
+    if (RprUsdIsCpuOnly()) {
+        return ret;
+    }
 
-        if (!RprUsdIsCpuOnly()) {
-            std::string name = GetGpuName(pluginType, pluginID, RPR_CREATION_FLAGS_ENABLE_GPU0, RPR_CONTEXT_GPU0_NAME, cachePath.c_str());
-            if (!name.empty()) {
-                ret.gpus.push_back({ 0, name });
-            }
+    // Querying GPU names requires creating RPR context for each GPU which is really slow,
+    // so the result is cached until the host GPUs, RPR plugin or GPU drivers are changed
+    std::string fingerprint = GetDevicesInfoFingerprint(pluginType);
+    if (LoadCachedGpus(pluginType, fingerprint, &ret.gpus)) {
+        return ret;
+    }
+
+    if (RprUsdIsHybrid(pluginType)) {
+        std::string name = GetGpuName(pluginType, pluginID, RPR_CREATION_FLAGS_ENABLE_GPU0, RPR_CONTEXT_GPU0_NAME, cachePath.c_str());
+        if (!name.empty()) {
+            ret.gpus.push_back({ 0, name });
         }
     } else {
-        ret.cpu.numThreads = std::thread::hardware_concurrency();
-
-        if (!RprUsdIsCpuOnly()) {
-            ForEachGpu(pluginType, pluginID, cachePath.c_str(),
-                [&ret](int index, rpr::CreationFlags, std::string const& name) {
-                if (!name.empty()) {
-                    ret.gpus.push_back({index, name});
-                }
+        ForEachGpu(pluginType, pluginID, cachePath.c_str(),
+            [&ret](int index, rpr::CreationFlags, std::string const& name) {
+            if (!name.empty()) {
+                ret.gpus.push_back({index, name});
             }
-            );
         }
+        );
     }
 
+    StoreCachedGpus(pluginType, fingerprint, ret.gpus);
+
     return ret;
 }
 
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "pxr/imaging/rprUsd/coreImage.h"
 #include "pxr/imaging/rprUsd/helpers.h"
+#include "pxr/base/work/loops.h"
+
+#include <algorithm>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -39,19 +42,30 @@ rpr::ImageDesc GetRprImageDesc(rpr::ImageFormat format, uint32_t width, uint32_t
 }
 
 template <typename ComponentT, typename PixelConverterFunc>
-std::unique_ptr<uint8_t[]> _ConvertTexture(RprUsdTextureData* textureData, rpr::ImageFormat const& srcFormat, uint32_t dstNumComponents, PixelConverterFunc&& converter) {
-    uint8_t* src = textureData->GetData();
+std::unique_ptr<uint8_t[]> _ConvertTexture(void const* srcData, size_t numPixels, rpr::ImageFormat const& srcFormat, uint32_t dstNumComponents, PixelConverterFunc&& converter) {
+    auto src = static_cast<uint8_t const*>(srcData);
 
     size_t srcPixelStride = srcFormat.num_components * sizeof(ComponentT);
     size_t dstPixelStride = dstNumComponents * sizeof(ComponentT);
 
-    size_t numPixels = size_t(textureData->GetWidth()) * textureData->GetHeight();
     auto dstData = std::make_unique<uint8_t[]>(numPixels * dstPixelStride);
     uint8_t* dst = dstData.get();
 
-    for (size_t i = 0; i < numPixels; ++i) {
-        converter((ComponentT*)(dst + i * dstPixelStride), (ComponentT*)(src + i * srcPixelStride));
-    }
+    // Split conversion into chunks that are big enough
+    // to amortize scheduling and keep the per-pixel loop tight for the compiler to vectorize it
+    constexpr size_t kNumPixelsPerChunk = 64 * 1024;
+    size_t numChunks = (numPixels + kNumPixelsPerChunk - 1) / kNumPixelsPerChunk;
+    WorkParallelForN(numChunks,
+        [&](size_t beginChunk, size_t endChunk) {
+            size_t begin = beginChunk * kNumPixelsPerChunk;
+            size_t end = std::min(endChunk * kNumPixelsPerChunk, numPixels);
+            auto chunkSrc = src + begin * srcPixelStride;
+            auto chunkDst = dst + begin * dstPixelStride;
+            for (size_t i = 0; i < end - begin; ++i) {
+                converter((ComponentT*)(chunkDst + i * dstPixelStride), (ComponentT const*)(chunkSrc + i * srcPixelStride));
+            }
+        }
+    );
 
     return dstData;
 }
@@ -66,11 +80,11 @@ template <> struct WhiteColor<uint8_t> {
 };
 
 template <typename ComponentT>
-std::unique_ptr<uint8_t[]> ConvertTexture(RprUsdTextureData* textureData, rpr::ImageFormat const& format, uint32_t dstNumComponents) {
+std::unique_ptr<uint8_t[]> ConvertTexture(void const* srcData, size_t numPixels, rpr::ImageFormat const& format, uint32_t dstNumComponents) {
     if (dstNumComponents < format.num_components) {
         // Trim excessive channels
-        return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-            [=](ComponentT* dst, ComponentT* src) {
+        return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+            [=](ComponentT* dst, ComponentT const* src) {
                 for (size_t i = 0; i < dstNumComponents; ++i) {
                     dst[i] = src[i];
                 }
@@ -82,15 +96,15 @@ std::unique_ptr<uint8_t[]> ConvertTexture(RprUsdTextureData* textureData, rpr::I
         // Expand to a required amount of channels. Example: greyscale texture that is stored as single-channel.
         if (dstNumComponents == 4) {
             // r -> rrr1
-            return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-                [](ComponentT* dst, ComponentT* src) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
                     dst[0] = dst[1] = dst[2] = src[0];
                     dst[3] = WhiteColor<ComponentT>{}.value;
                 }
             );
         } else {
-            return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-                [=](ComponentT* dst, ComponentT* src) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [=](ComponentT* dst, ComponentT const* src) {
                     for (size_t i = 0; i < dstNumComponents; ++i) {
                         dst[i] = src[0];
                     }
@@ -100,24 +114,24 @@ std::unique_ptr<uint8_t[]> ConvertTexture(RprUsdTextureData* textureData, rpr::I
     } else if (format.num_components == 2) {
         if (dstNumComponents == 4) {
             // rg -> rrrg
-            return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-                [](ComponentT* dst, ComponentT* src) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
                     dst[0] = dst[1] = dst[2] = src[0];
                     dst[3] = src[1];
                 }
             );
         } else {
             // rg -> rrr
-            return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-                [](ComponentT* dst, ComponentT* src) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
                     dst[0] = dst[1] = dst[2] = src[0];
                 }
             );
         }
-    } else if (format.num_components == 3) {
+    } else if (format.num_components == 3 && dstNumComponents == 4) {
         // rgb -> rgb1
-        return _ConvertTexture<ComponentT>(textureData, format, dstNumComponents,
-            [](ComponentT* dst, ComponentT* src) {
+        return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+            [](ComponentT* dst, ComponentT const* src) {
                 dst[0] = src[0];
                 dst[1] = src[1];
                 dst[2] = src[2];
@@ -129,7 +143,15 @@ std::unique_ptr<uint8_t[]> ConvertTexture(RprUsdTextureData* textureData, rpr::I
     return nullptr;
 }
 
-rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData, uint32_t numComponentsRequired) {
+// Data of rpr::Image that is prepared without calling into RPR, so it does not require the context to be locked
+struct RprImageData {
+    rpr::ImageFormat format = {};
+    rpr::ImageDesc desc = {};
+    void const* data = nullptr;
+    std::unique_ptr<uint8_t[]> convertedData;
+};
+
+bool PrepareRprImageData(RprUsdTextureData* textureData, uint32_t numComponentsRequired, RprImageData* imageData) {
     rpr::ImageFormat format = {};
 
     auto imageMetadata = textureData->GetGLMetadata();
@@ -146,7 +168,7 @@ rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData
             break;
         default:
             TF_RUNTIME_ERROR("Unsupported pixel data GLtype: %#x", imageMetadata.glType);
-            return nullptr;
+            return false;
     }
 
     switch (imageMetadata.glFormat) {
@@ -161,7 +183,7 @@ rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData
             break;
         default:
             TF_RUNTIME_ERROR("Unsupported pixel data GLformat: %#x", imageMetadata.glFormat);
-            return nullptr;
+            return false;
     }
     rpr::ImageDesc desc = GetRprImageDesc(format, textureData->GetWidth(), textureData->GetHeight());
 
@@ -170,13 +192,8 @@ rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData
     std::unique_ptr<uint8_t[]> convertedData;
     if (numComponentsRequired != 0 &&
         numComponentsRequired != format.num_components) {
-        if (format.type == RPR_COMPONENT_TYPE_UINT8) {
-            convertedData = ConvertTexture<uint8_t>(textureData, format, numComponentsRequired);
-        } else if (format.type == RPR_COMPONENT_TYPE_FLOAT16) {
-            convertedData = ConvertTexture<GfHalf>(textureData, format, numComponentsRequired);
-        } else if (format.type == RPR_COMPONENT_TYPE_FLOAT32) {
-            convertedData = ConvertTexture<float>(textureData, format, numComponentsRequired);
-        }
+        size_t numPixels = size_t(textureData->GetWidth()) * textureData->GetHeight();
+        convertedData = RprUsdConvertImageChannels(textureBuffer, numPixels, format, numComponentsRequired);
 
         if (convertedData) {
             textureBuffer = convertedData.get();
@@ -185,8 +202,16 @@ rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData
         }
     }
 
+    imageData->format = format;
+    imageData->desc = desc;
+    imageData->data = textureBuffer;
+    imageData->convertedData = std::move(convertedData);
+    return true;
+}
+
+rpr::Image* CreateRprImage(rpr::Context* context, RprImageData const& imageData) {
     rpr::Status status;
-    auto rprImage = context->CreateImage(format, desc, textureBuffer, &status);
+    auto rprImage = context->CreateImage(imageData.format, imageData.desc, imageData.data, &status);
     if (!rprImage) {
         RPR_ERROR_CHECK(status, "Failed to create image from data", context);
         return nullptr;
@@ -197,6 +222,21 @@ rpr::Image* CreateRprImage(rpr::Context* context, RprUsdTextureData* textureData
 
 } // namespace anonymous
 
+std::unique_ptr<uint8_t[]> RprUsdConvertImageChannels(void const* srcData, size_t numPixels, rpr::ImageFormat const& srcFormat, uint32_t dstNumComponents) {
+    if (dstNumComponents == 0 || dstNumComponents > 4 || dstNumComponents == srcFormat.num_components) {
+        return nullptr;
+    }
+
+    if (srcFormat.type == RPR_COMPONENT_TYPE_UINT8) {
+        return ConvertTexture<uint8_t>(srcData, numPixels, srcFormat, dstNumComponents);
+    } else if (srcFormat.type == RPR_COMPONENT_TYPE_FLOAT16) {
+        return ConvertTexture<GfHalf>(srcData, numPixels, srcFormat, dstNumComponents);
+    } else if (srcFormat.type == RPR_COMPONENT_TYPE_FLOAT32) {
+        return ConvertTexture<float>(srcData, numPixels, srcFormat, dstNumComponents);
+    }
+    return nullptr;
+}
+
 RprUsdCoreImage* RprUsdCoreImage::Create(rpr::Context* context, std::string const& path, uint32_t numComponentsRequired) {
     auto textureData = RprUsdTextureData::New(path);
     if (!textureData) {
@@ -218,15 +258,26 @@ RprUsdCoreImage* RprUsdCoreImage::Create(rpr::Context* context, uint32_t width,
 RprUsdCoreImage* RprUsdCoreImage::Create(
     rpr::Context* context,
     std::vector<UDIMTile> const& tiles,
-    uint32_t numComponentsRequired) {
+    uint32_t numComponentsRequired,
+    std::mutex* contextMutex) {
 
     if (tiles.empty()) {
         return nullptr;
     }
 
+    auto lockContext = [contextMutex]() {
+        return contextMutex ? std::unique_lock<std::mutex>(*contextMutex) : std::unique_lock<std::mutex>();
+    };
+
     if (tiles.size() == 1 && tiles[0].id == 0) {
         // Single non-UDIM tile
-        auto rprImage = CreateRprImage(context, tiles[0].textureData, numComponentsRequired);
+        RprImageData imageData;
+        if (!PrepareRprImageData(tiles[0].textureData, numComponentsRequired, &imageData)) {
+            return nullptr;
+        }
+
+        auto contextLock = lockContext();
+        auto rprImage = CreateRprImage(context, imageData);
         if (!rprImage) {
             return nullptr;
         }
@@ -242,7 +293,13 @@ RprUsdCoreImage* RprUsdCoreImage::Create(
                 continue;
             }
 
-            auto rprImage = CreateRprImage(context, tile.textureData, numComponentsRequired);
+            RprImageData imageData;
+            if (!PrepareRprImageData(tile.textureData, numComponentsRequired, &imageData)) {
+                continue;
+            }
+
+            auto contextLock = lockContext();
+            auto rprImage = CreateRprImage(context, imageData);
             if (!rprImage) {
                 continue;
             }
@@ -314,6 +371,30 @@ rpr::Status RprUsdCoreImage::GetInfo(rpr::ImageInfo imageInfo, size_t size, void
     return GetBaseImage()->GetInfo(imageInfo, size, data, size_ret);
 }
 
+size_t RprUsdCoreImage::GetDataSize() {
+    size_t dataSize = 0;
+    ForEachImage([&dataSize](rpr::Image* image) {
+        rpr::ImageFormat format = {};
+        rpr::ImageDesc desc = {};
+        if (RPR_ERROR_CHECK(image->GetInfo(RPR_IMAGE_FORMAT, sizeof(format), &format, nullptr), "Failed to get image format") ||
+            RPR_ERROR_CHECK(image->GetInfo(RPR_IMAGE_DESC, sizeof(desc), &desc, nullptr), "Failed to get image desc")) {
+            // Do not interrupt iteration, count as much as possible
+            return RPR_SUCCESS;
+        }
+
+        size_t componentSize = 1;
+        if (format.type == RPR_COMPONENT_TYPE_FLOAT16) {
+            componentSize = 2;
+        } else if (format.type == RPR_COMPONENT_TYPE_FLOAT32) {
+            componentSize = 4;
+        }
+
+        dataSize += size_t(desc.image_width) * desc.image_height * std::max(desc.image_depth, 1u) * format.num_components * componentSize;
+        return RPR_SUCCESS;
+    });
+    return dataSize;
+}
+
 rpr::Status RprUsdCoreImage::SetWrap(rpr::ImageWrapType type) {
     return ForEachImage([type](rpr::Image* image) { return image->SetWrap(type); });
 }
@@ -19,10 +19,18 @@ limitations under the License.
 
 #include <RadeonProRender.hpp>
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+/// Converts tightly packed pixels of srcFormat to dstNumComponents channels of the same component type.
+/// Excessive channels are trimmed, r is expanded to rrr1 (or replicated), rg to rrrg (or rrr) and rgb to rgb1.
+/// Returns nullptr if the conversion is not supported or not required.
+RPRUSD_API
+std::unique_ptr<uint8_t[]> RprUsdConvertImageChannels(void const* srcData, size_t numPixels, rpr::ImageFormat const& srcFormat, uint32_t dstNumComponents);
+
 class RprUsdCoreImage {
 public:
     RPRUSD_API
@@ -34,8 +42,10 @@ public:
 
         UDIMTile(uint32_t id, RprUsdTextureData* textureData) : id(id), textureData(textureData) {}
     };
+    /// When contextMutex is not null, it is locked only around the calls into RPR,
+    /// so that texture data of different images can be converted concurrently
     RPRUSD_API
-    static RprUsdCoreImage* Create(rpr::Context* context, std::vector<UDIMTile> const& textureData, uint32_t numComponentsRequired);
+    static RprUsdCoreImage* Create(rpr::Context* context, std::vector<UDIMTile> const& textureData, uint32_t numComponentsRequired, std::mutex* contextMutex = nullptr);
 
     RPRUSD_API
     static RprUsdCoreImage* Create(rpr::Context* context, uint32_t width, uint32_t height, rpr::ImageFormat format, void const* data, rpr::Status* status = nullptr);
@@ -55,6 +65,10 @@ public:
     RPRUSD_API
     rpr::Status GetInfo(rpr::ImageInfo imageInfo, size_t size, void* data, size_t* size_ret);
 
+    /// Returns the amount of memory occupied by the image data (including all UDIM tiles) in bytes
+    RPRUSD_API
+    size_t GetDataSize();
+
     RPRUSD_API
     rpr::Status SetWrap(rpr::ImageWrapType type);
 
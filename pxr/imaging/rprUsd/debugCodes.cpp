@@ -23,6 +23,7 @@ TF_REGISTRY_FUNCTION(TfDebug) {
     TF_DEBUG_ENVIRONMENT_SYMBOL(RPR_USD_DEBUG_DUMP_MATERIALS, "Dump material networks to the files in the current working directory")
     TF_DEBUG_ENVIRONMENT_SYMBOL(RPR_USD_DEBUG_LEAKS, "signal about rpr_context leaks");
     TF_DEBUG_ENVIRONMENT_SYMBOL(RPR_USD_DEBUG_MATERIAL_REGISTRY, "Print debug info about material registry");
+    TF_DEBUG_ENVIRONMENT_SYMBOL(RPR_USD_DEBUG_IMAGE_CACHE, "Print debug info about image cache retention and evictions");
 }
 
 bool RprUsdIsLeakCheckEnabled() {
@@ -24,7 +24,8 @@ TF_DEBUG_CODES(
     RPR_USD_DEBUG_CORE_UNSUPPORTED_ERROR,
     RPR_USD_DEBUG_DUMP_MATERIALS,
     RPR_USD_DEBUG_LEAKS,
-    RPR_USD_DEBUG_MATERIAL_REGISTRY
+    RPR_USD_DEBUG_MATERIAL_REGISTRY,
+    RPR_USD_DEBUG_IMAGE_CACHE
 );
 
 RPRUSD_API
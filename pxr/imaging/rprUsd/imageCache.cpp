@@ -15,8 +15,20 @@ limitations under the License.
 #include "pxr/imaging/rprUsd/imageCache.h"
 #include "pxr/imaging/rprUsd/coreImage.h"
 #include "pxr/imaging/rprUsd/helpers.h"
+#include "pxr/imaging/rprUsd/debugCodes.h"
 #include "pxr/base/arch/fileSystem.h"
 #include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/envSetting.h"
+
+#if PXR_VERSION >= 2111
+#include "pxr/base/work/withScopedParallelism.h"
+#else
+#include <tbb/task_arena.h>
+#endif
+
+#include <algorithm>
+#include <exception>
+#include <utility>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -31,9 +43,70 @@ double GetModificationTime(std::string const& path) {
     return modificationTime;
 }
 
+// Runs f in a task arena isolated from the outer parallel work, so that a thread that waits
+// for the nested tasks of f does not pick up an outer task that waits for the result of f
+template <typename F>
+void WithScopedParallelism(F&& f) {
+#if PXR_VERSION >= 2111
+    WorkWithScopedParallelism(std::forward<F>(f));
+#else
+    tbb::this_task_arena::isolate(std::forward<F>(f));
+#endif
+}
+
 RprUsdImageCache::RprUsdImageCache(rpr::Context* context)
-    : m_context(context) {
+    : m_context(context)
+    , m_retentionBudget(0) {
+
+}
+
+RprUsdImageCache::~RprUsdImageCache() {
+    m_retainedImages.clear();
+    for (auto& shard : m_shards) {
+        shard.cache.clear();
+    }
+    m_releasedImages.clear();
+}
+
+void RprUsdImageCache::SetRetentionBudget(size_t numBytes) {
+    {
+        std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+        m_retentionBudget = numBytes;
+    }
+    EvictRetainedImages();
+}
+
+size_t RprUsdImageCache::GetRetentionBudget() {
+    std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+    return m_retentionBudget;
+}
+
+void RprUsdImageCache::DestroyReleasedImages() {
+    std::vector<std::shared_ptr<RprUsdCoreImage>> releasedImages;
+    {
+        std::lock_guard<std::mutex> releasedImagesLock(m_releasedImagesMutex);
+        releasedImages.swap(m_releasedImages);
+    }
+    if (releasedImages.empty()) {
+        return;
+    }
 
+    std::lock_guard<std::mutex> contextLock(m_context->GetMutex());
+    releasedImages.clear();
+}
+
+void RprUsdImageCache::DeferDestruction(std::shared_ptr<RprUsdCoreImage> image) {
+    if (!image) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> releasedImagesLock(m_releasedImagesMutex);
+    m_releasedImages.push_back(std::move(image));
+}
+
+RprUsdImageCache::Stats RprUsdImageCache::GetStats() {
+    std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+    return m_stats;
 }
 
 std::shared_ptr<RprUsdCoreImage>
@@ -51,26 +124,116 @@ RprUsdImageCache::GetImage(
     key.path = path;
     key.colorspace = colorspace;
     key.wrapType = wrapType;
-    key.hash = GetHash(path) ^ GetHash(colorspace) ^ GetHash(wrapType);
+    key.loadOptions = m_textureLoadOptions;
+    key.hash = GetHash(path) ^ GetHash(colorspace) ^ GetHash(wrapType) ^ m_textureLoadOptions.GetHash();
 
-    auto it = m_cache.find(key);
-    if (it != m_cache.end()) {
-        CacheValue& cacheValue = it->second;
-        if (auto image = cacheValue.Lock(key)) {
-            return image;
-        } else {
-            m_cache.erase(it);
-            it = m_cache.end();
+    Shard& shard = GetShard(key);
+    std::promise<std::shared_ptr<RprUsdCoreImage>> handlePromise;
+    {
+        std::unique_lock<std::mutex> shardLock(shard.mutex);
+
+        auto it = shard.cache.find(key);
+        if (it != shard.cache.end()) {
+            CacheValue& cacheValue = it->second;
+            if (cacheValue.pendingHandle.valid()) {
+                // The image is being created by another thread.
+                // The creator does not steal outer tasks while creating the image, so waiting for it cannot deadlock
+                auto pendingHandle = cacheValue.pendingHandle;
+                shardLock.unlock();
+                return pendingHandle.get();
+            } else if (cacheValue.IsOutdated(key)) {
+                Erase(shard, it);
+            } else if (auto image = cacheValue.handle.lock()) {
+                std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+                m_stats.numHits++;
+                return image;
+            } else if (cacheValue.retainedImage) {
+                {
+                    std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+                    m_stats.numHits++;
+
+                    m_retainedImages.erase(cacheValue.retainedImageIt);
+                    m_stats.numRetainedImages--;
+                    m_stats.retainedDataSize -= cacheValue.dataSize;
+                }
+
+                return CreateHandle(it, std::move(cacheValue.retainedImage));
+            } else {
+                // The last handle is being released by another thread
+                Erase(shard, it);
+            }
+        }
+
+        if (tiles.empty()) {
+            return nullptr;
         }
+
+        {
+            std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+            m_stats.numMisses++;
+        }
+
+        // Reserve the entry so that concurrent requests of the image wait for it instead of creating it once more.
+        // Pending entries are erased only by the thread that has reserved them
+        CacheValue pendingValue;
+        pendingValue.pendingHandle = handlePromise.get_future().share();
+        shard.cache.emplace(key, std::move(pendingValue));
     }
 
-    auto coreImage = RprUsdCoreImage::Create(m_context, tiles, numComponentsRequired);
-    if (!coreImage) {
-        return nullptr;
+    // Texture data conversion runs nested parallel loops. Without isolation this thread could steal
+    // an outer task that requests the same image and wait for the pending entry that only this thread can fulfill
+    CacheValue cacheValue;
+    RprUsdCoreImage* coreImage = nullptr;
+    try {
+        WithScopedParallelism([&]() {
+            coreImage = CreateImage(key, tiles, numComponentsRequired, &cacheValue);
+        });
+    } catch (...) {
+        // Release the reservation, otherwise threads waiting for the image would wait forever
+        {
+            std::lock_guard<std::mutex> shardLock(shard.mutex);
+            shard.cache.erase(key);
+        }
+        handlePromise.set_exception(std::current_exception());
+        throw;
     }
 
-    if (RprUsdIsLeakCheckEnabled()) {
-        coreImage->SetName(path.c_str());
+    std::shared_ptr<RprUsdCoreImage> handle;
+    {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+
+        auto it = shard.cache.find(key);
+        if (coreImage) {
+            it->second = std::move(cacheValue);
+            handle = CreateHandle(it, std::shared_ptr<RprUsdCoreImage>(coreImage));
+        } else {
+            shard.cache.erase(it);
+        }
+    }
+
+    handlePromise.set_value(handle);
+    return handle;
+}
+
+RprUsdCoreImage* RprUsdImageCache::CreateImage(
+    CacheKey const& key,
+    std::vector<RprUsdCoreImage::UDIMTile> const& tiles,
+    uint32_t numComponentsRequired,
+    CacheValue* cacheValue) {
+    if (tiles.size() != 1 || tiles[0].id != 0) {
+        // UDIM tiles
+        std::string formatString;
+        if (!RprUsdGetUDIMFormatString(key.path, &formatString)) {
+            return nullptr;
+        }
+
+        cacheValue->tileModificationTimes.reserve(tiles.size());
+        for (auto& tile : tiles) {
+            auto tilePath = TfStringPrintf(formatString.c_str(), tile.id);
+            cacheValue->tileModificationTimes.emplace_back(tile.id, GetModificationTime(tilePath));
+        }
+    } else {
+        cacheValue->tileModificationTimes.emplace_back(0, GetModificationTime(key.path));
     }
 
     float gamma = 1.0f;
@@ -93,45 +256,117 @@ RprUsdImageCache::GetImage(
         }
     }
 
+    // Texture data is converted concurrently with other images, RPR context is locked only to create rpr objects
+    std::mutex& contextMutex = m_context->GetMutex();
+    auto coreImage = RprUsdCoreImage::Create(m_context, tiles, numComponentsRequired, &contextMutex);
+    if (!coreImage) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> contextLock(contextMutex);
+
+    if (RprUsdIsLeakCheckEnabled()) {
+        coreImage->SetName(key.path.c_str());
+    }
+
     RPR_ERROR_CHECK(coreImage->SetGamma(gamma), "Failed to set image gamma");
     RPR_ERROR_CHECK(coreImage->SetWrap(key.wrapType), "Failed to set image wrap type");
 
-    CacheValue cacheValue;
-    if (tiles.size() != 1 || tiles[0].id != 0) {
-        // UDIM tiles
-        std::string formatString;
-        if (!RprUsdGetUDIMFormatString(path, &formatString)) {
-            return nullptr;
+    cacheValue->image = coreImage;
+    cacheValue->dataSize = coreImage->GetDataSize();
+
+    return coreImage;
+}
+
+std::shared_ptr<RprUsdCoreImage> RprUsdImageCache::CreateHandle(Cache::iterator it, std::shared_ptr<RprUsdCoreImage> image) {
+    // Users share a separate handle whose release moves the image into the retained list instead of destroying it
+    auto imagePtr = image.get();
+    std::shared_ptr<RprUsdCoreImage> handle(imagePtr,
+        [this, key = it->first, imagePtr, ownedImage = std::move(image)](RprUsdCoreImage*) mutable {
+            OnHandleReleased(key, imagePtr, std::move(ownedImage));
         }
+    );
+    it->second.handle = handle;
+    return handle;
+}
 
-        cacheValue.tileModificationTimes.reserve(tiles.size());
-        for (auto& tile : tiles) {
-            auto tilePath = TfStringPrintf(formatString.c_str(), tile.id);
-            cacheValue.tileModificationTimes.emplace_back(tile.id, GetModificationTime(tilePath));
+void RprUsdImageCache::OnHandleReleased(CacheKey const& key, RprUsdCoreImage* image, std::shared_ptr<RprUsdCoreImage> ownedImage) {
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+
+        auto it = shard.cache.find(key);
+        if (it == shard.cache.end() || it->second.image != image) {
+            // The entry was already replaced by a newer version of the image
+            DeferDestruction(std::move(ownedImage));
+            return;
         }
-    } else {
-        cacheValue.tileModificationTimes.emplace_back(0, GetModificationTime(path));
-    }
 
-    std::shared_ptr<RprUsdCoreImage> cachedImage(coreImage,
-        [this, key](RprUsdCoreImage* coreImage) {
-            delete coreImage;
-            m_cache.erase(key);
+        CacheValue& cacheValue = it->second;
+
+        std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+        if (cacheValue.dataSize > m_retentionBudget) {
+            shard.cache.erase(it);
+            DeferDestruction(std::move(ownedImage));
+            return;
         }
-    );
-    cacheValue.handle = cachedImage;
 
-    it = m_cache.emplace(std::move(key), std::move(cacheValue)).first;
+        m_retainedImages.push_front(key);
+        cacheValue.retainedImageIt = m_retainedImages.begin();
+        cacheValue.retainedImage = std::move(ownedImage);
+        m_stats.numRetainedImages++;
+        m_stats.retainedDataSize += cacheValue.dataSize;
+    }
 
-    return cachedImage;
+    EvictRetainedImages();
 }
 
-std::shared_ptr<RprUsdCoreImage> RprUsdImageCache::CacheValue::Lock(CacheKey const& key) const {
-    auto image = handle.lock();
-    if (!image) {
-        return nullptr;
+void RprUsdImageCache::Erase(Shard& shard, Cache::iterator it) {
+    CacheValue& cacheValue = it->second;
+    if (cacheValue.retainedImage) {
+        std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+        m_retainedImages.erase(cacheValue.retainedImageIt);
+        m_stats.numRetainedImages--;
+        m_stats.retainedDataSize -= cacheValue.dataSize;
+    }
+    DeferDestruction(std::move(cacheValue.retainedImage));
+
+    // In-use images stay alive until all handles are released, see OnHandleReleased
+    shard.cache.erase(it);
+}
+
+void RprUsdImageCache::EvictRetainedImages() {
+    while (true) {
+        CacheKey key;
+        {
+            std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+            if (m_stats.retainedDataSize <= m_retentionBudget || m_retainedImages.empty()) {
+                return;
+            }
+            key = m_retainedImages.back();
+        }
+
+        // The shard mutex cannot be locked while the retention mutex is locked,
+        // so the image might have been taken back into use in between
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+
+        auto it = shard.cache.find(key);
+        if (it == shard.cache.end() || !it->second.retainedImage) {
+            continue;
+        }
+
+        TF_DEBUG(RPR_USD_DEBUG_IMAGE_CACHE).Msg("RprUsdImageCache: evicting %s (%zu bytes)\n",
+            it->first.path.c_str(), it->second.dataSize);
+
+        Erase(shard, it);
+
+        std::lock_guard<std::mutex> retentionLock(m_retentionMutex);
+        m_stats.numEvictions++;
     }
+}
 
+bool RprUsdImageCache::CacheValue::IsOutdated(CacheKey const& key) const {
     std::string udimFormatString;
 
     // Check if image files were not changed
@@ -160,12 +395,11 @@ std::shared_ptr<RprUsdCoreImage> RprUsdImageCache::CacheValue::Lock(CacheKey con
         }
 
         if (modificationTime != currentModificationTime) {
-            return nullptr;
+            return true;
         }
     }
 
-    return image;
-
+    return false;
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
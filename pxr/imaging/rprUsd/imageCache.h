@@ -16,9 +16,14 @@ limitations under the License.
 
 #include "pxr/imaging/rprUsd/coreImage.h"
 
+#include <array>
+#include <future>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -27,6 +32,13 @@ public:
     RPRUSD_API
     RprUsdImageCache(rpr::Context* context);
 
+    RPRUSD_API
+    ~RprUsdImageCache();
+
+    /// Returns the cached image or creates it from the tiles when there is no such image and tiles are not empty.
+    /// Can be called from multiple threads, the caller must not hold the mutex of the RPR context.
+    /// Concurrent calls for the same image wait for the one that creates it.
+    /// The image is created in an isolated task arena, so the creator does not steal tasks that wait for it
     RPRUSD_API
     std::shared_ptr<RprUsdCoreImage> GetImage(
         std::string const& path,
@@ -35,16 +47,44 @@ public:
         std::vector<RprUsdCoreImage::UDIMTile> const& data,
         uint32_t numComponentsRequired);
 
-private:
-    rpr::Context* m_context;
+    /// Images that are not referenced anymore are kept alive until their total size exceeds the budget,
+    /// the least recently released images are evicted first. Zero budget (the default) disables retention
+    RPRUSD_API
+    void SetRetentionBudget(size_t numBytes);
+    RPRUSD_API
+    size_t GetRetentionBudget();
+
+    /// Images can be released by threads that hold the mutex of the RPR context as well as by threads that do not,
+    /// so the cache does not destroy them right away but keeps them until this function is called.
+    /// Destroys the released images under the mutex of the RPR context, the caller must not hold it
+    RPRUSD_API
+    void DestroyReleasedImages();
+
+    /// Options of the textures that are loaded for this cache, see RprUsdTextureData::New.
+    /// Images are cached per options, so changing them does not discard the images loaded with other options.
+    /// Must not be called concurrently with GetImage
+    void SetTextureLoadOptions(RprUsdTextureLoadOptions const& options) { m_textureLoadOptions = options; }
+    RprUsdTextureLoadOptions const& GetTextureLoadOptions() const { return m_textureLoadOptions; }
 
+    struct Stats {
+        size_t numHits = 0;
+        size_t numMisses = 0;
+        size_t numEvictions = 0;
+        size_t numRetainedImages = 0;
+        size_t retainedDataSize = 0;
+    };
+    RPRUSD_API
+    Stats GetStats();
+
+private:
     struct CacheKey {
         std::string path;
         std::string colorspace;
         rpr::ImageWrapType wrapType;
+        RprUsdTextureLoadOptions loadOptions;
 
         bool operator==(CacheKey const& rhs) const {
-            return wrapType == rhs.wrapType && colorspace == rhs.colorspace && path == rhs.path;
+            return wrapType == rhs.wrapType && loadOptions == rhs.loadOptions && colorspace == rhs.colorspace && path == rhs.path;
         }
 
         size_t hash;
@@ -53,13 +93,60 @@ private:
 
     struct CacheValue {
         std::vector<std::pair<uint32_t, double>> tileModificationTimes;
+        RprUsdCoreImage* image = nullptr;
+        size_t dataSize = 0;
+
+        // Handle that is shared between all users of the image
         std::weak_ptr<RprUsdCoreImage> handle;
 
-        // Convenience wrapper over std::weak_ptr::lock that includes checking if image files are outdated
-        std::shared_ptr<RprUsdCoreImage> Lock(CacheKey const& key) const;
+        // Valid while the image is being created, concurrent users of the image wait for it
+        std::shared_future<std::shared_ptr<RprUsdCoreImage>> pendingHandle;
+
+        // Owns the image while nobody uses it, see m_retainedImages
+        std::shared_ptr<RprUsdCoreImage> retainedImage;
+        std::list<CacheKey>::iterator retainedImageIt;
+
+        bool IsOutdated(CacheKey const& key) const;
+    };
+    using Cache = std::unordered_map<CacheKey, CacheValue, CacheKey::Hash>;
+
+    // Images are distributed between shards by the key hash, so that lookups of different images rarely contend
+    struct Shard {
+        std::mutex mutex;
+        Cache cache;
     };
+    static constexpr size_t kNumShards = 16;
+    Shard& GetShard(CacheKey const& key) { return m_shards[key.hash % kNumShards]; }
+
+    RprUsdCoreImage* CreateImage(CacheKey const& key, std::vector<RprUsdCoreImage::UDIMTile> const& tiles, uint32_t numComponentsRequired, CacheValue* cacheValue);
+
+    // Functions below require the mutex of the shard that owns the entry to be locked
+    std::shared_ptr<RprUsdCoreImage> CreateHandle(Cache::iterator it, std::shared_ptr<RprUsdCoreImage> image);
+    void Erase(Shard& shard, Cache::iterator it);
+
+    void OnHandleReleased(CacheKey const& key, RprUsdCoreImage* image, std::shared_ptr<RprUsdCoreImage> ownedImage);
+    void EvictRetainedImages();
+
+    void DeferDestruction(std::shared_ptr<RprUsdCoreImage> image);
+
+private:
+    rpr::Context* m_context;
+    std::array<Shard, kNumShards> m_shards;
+
+    // Guards m_retainedImages, m_retentionBudget and m_stats.
+    // Can be locked while a shard mutex is locked, but not vice versa
+    std::mutex m_retentionMutex;
+
+    // Keys of the images that are not used anymore, the most recently released at the front
+    std::list<CacheKey> m_retainedImages;
+    size_t m_retentionBudget;
+    RprUsdTextureLoadOptions m_textureLoadOptions;
+
+    Stats m_stats;
 
-    std::unordered_map<CacheKey, CacheValue, CacheKey::Hash> m_cache;
+    // Guards m_releasedImages. Can be locked while any other mutex of the cache is locked
+    std::mutex m_releasedImagesMutex;
+    std::vector<std::shared_ptr<RprUsdCoreImage>> m_releasedImages;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -81,6 +81,10 @@ bool RprUsdMaterial::AttachTo(rpr::Shape* mesh, bool displacementEnabled) const
     return !fail;
 }
 
+bool RprUsdMaterial::AttachToFaces(rpr::Shape* mesh, int const* faceIndices, size_t numFaces) const {
+    return !RPR_ERROR_CHECK(rprShapeSetMaterialFaces(GetRprObject(mesh), GetRprObject(m_surfaceNode), const_cast<rpr_int*>(faceIndices), numFaces), "Failed to set shape per-face material");
+}
+
 bool RprUsdMaterial::AttachTo(rpr::Curve* curve) const {
     return !RPR_ERROR_CHECK(curve->SetMaterial(m_surfaceNode), "Failed to set curve material");
 }
@@ -30,12 +30,25 @@ public:
     RPRUSD_API
     TfToken const& GetUvPrimvarName() const { return m_uvPrimvarName; }
 
+    RPRUSD_API
+    bool HasDisplacement() const { return m_displacementNode || m_hybridDisplacementAdd; }
+
     RPRUSD_API
     bool AttachTo(rpr::Shape* mesh, bool displacementEnabled) const;
 
     RPRUSD_API
     bool AttachTo(rpr::Curve* curve) const;
 
+    /// Whether the material can be assigned to a subset of mesh faces.
+    /// Displacement, volume and catcher properties can be set only for the whole shape
+    RPRUSD_API
+    bool CanAttachToFaces() const { return !HasDisplacement() && !m_volumeNode && !m_isShadowCatcher && !m_isReflectionCatcher; }
+
+    /// Assigns the surface of the material to the given faces of the mesh,
+    /// the rest of the faces keep the material that was attached to the whole mesh
+    RPRUSD_API
+    bool AttachToFaces(rpr::Shape* mesh, int const* faceIndices, size_t numFaces) const;
+
     RPRUSD_API
     static void DetachFrom(rpr::Shape* mesh);
 
@@ -14,6 +14,9 @@ limitations under the License.
 #include "pxr/imaging/rprUsd/util.h"
 #include "pxr/imaging/rprUsd/materialRegistry.h"
 #include "pxr/imaging/rprUsd/imageCache.h"
+#include "pxr/imaging/rprUsd/textureDiskCache.h"
+#include "pxr/imaging/rprUsd/timeline.h"
+#include "pxr/imaging/rprUsd/config.h"
 #include "pxr/imaging/rprUsd/debugCodes.h"
 #include "pxr/imaging/rprUsd/material.h"
 #include "pxr/imaging/rprUsd/tokens.h"
@@ -29,6 +32,7 @@ limitations under the License.
 #include "pxr/base/tf/getenv.h"
 #include "pxr/base/work/loops.h"
 #include "pxr/usd/sdr/registry.h"
+#include "pxr/usd/sdf/assetPath.h"
 #include "pxr/usd/usd/schemaBase.h"
 #include "pxr/usd/usdShade/tokens.h"
 #include "pxr/imaging/hd/sceneDelegate.h"
@@ -38,6 +42,9 @@ limitations under the License.
 #include "materialNodes/rprApiMtlxNode.h"
 #include "materialNodes/houdiniPrincipledShaderNode.h"
 
+#include <algorithm>
+#include <tuple>
+
 #include <MaterialXCore/Document.h>
 #include <MaterialXFormat/Util.h>
 namespace mx = MaterialX;
@@ -110,6 +117,8 @@ TF_INSTANTIATE_SINGLETON(RprUsdMaterialRegistry);
 
 TF_DEFINE_ENV_SETTING(RPRUSD_MATERIAL_NETWORK_SELECTOR, "rpr",
     "Material network selector to be used in hdRpr");
+TF_DEFINE_ENV_SETTING(RPRUSD_MATERIAL_DEDUPLICATION, true,
+    "Whether to share one RPR material between material prims with identical networks and cryptomatte names");
 
 #ifdef USE_CUSTOM_MATERIALX_LOADER
 TF_DEFINE_ENV_SETTING(RPRUSD_USE_RPRMTLXLOADER, true,
@@ -204,6 +213,7 @@ void RprUsdMaterialRegistry::EnqueueTextureLoadRequest(std::weak_ptr<TextureLoad
 
 void RprUsdMaterialRegistry::CommitResources(
     RprUsdImageCache* imageCache) {
+    RprUsdTimelineZone zone("RprUsdMaterialRegistry::CommitResources");
 
     std::vector<std::shared_ptr<TextureLoadRequest>> textureLoadRequests;
     textureLoadRequests.reserve(m_textureLoadRequests.size());
@@ -218,9 +228,6 @@ void RprUsdMaterialRegistry::CommitResources(
         return;
     }
 
-    using LoadRequestUniqueTextureIndices = std::vector<size_t>;
-    auto uniqueTextureIndicesPerLoadRequest = std::make_unique<LoadRequestUniqueTextureIndices[]>(textureLoadRequests.size());
-
     struct UniqueTextureInfo {
         std::string path;
         uint32_t udimTileId;
@@ -240,6 +247,23 @@ void RprUsdMaterialRegistry::CommitResources(
         return status.first->second;
     };
 
+    // UDIM tiles are discovered by listing the directory of the texture once per directory for the whole batch
+    // instead of probing every possible tile path, which is slow on network filesystems
+    //
+    RprUsdDirectoryListingCache directoryListings;
+
+    // Load requests of the same image are grouped, so each image is created by a single task.
+    // Tasks never wait for each other in the image cache that way
+    //
+    struct ImageInfo {
+        std::vector<size_t> loadRequestIndices;
+        std::vector<size_t> uniqueTextureIndices;
+
+        std::shared_ptr<RprUsdCoreImage> image;
+    };
+    std::vector<ImageInfo> images;
+    std::map<std::tuple<std::string, std::string, rpr::ImageWrapType>, size_t> imagesMapping;
+
     // Iterate over all texture load requests and collect unique textures including UDIM tiles
     //
     std::string formatString;
@@ -250,29 +274,53 @@ void RprUsdMaterialRegistry::CommitResources(
             continue;
         }
 
-        auto& loadRequestTexIndices = uniqueTextureIndicesPerLoadRequest[i];
+        // Image cache treats the default wrap type as repeat
+        rpr::ImageWrapType wrapType = loadRequest->wrapType ? loadRequest->wrapType : RPR_IMAGE_WRAP_TYPE_REPEAT;
+        auto status = imagesMapping.emplace(std::make_tuple(loadRequest->filepath, loadRequest->colorspace, wrapType), images.size());
+        if (!status.second) {
+            images[status.first->second].loadRequestIndices.push_back(i);
+            continue;
+        }
+
+        images.emplace_back();
+        images.back().loadRequestIndices.push_back(i);
+        auto& loadRequestTexIndices = images.back().uniqueTextureIndices;
 
         if (RprUsdGetUDIMFormatString(loadRequest->filepath, &formatString)) {
-            constexpr uint32_t kStartTile = 1001;
-            constexpr uint32_t kEndTile = 1100;
-
-            for (uint32_t tileId = kStartTile; tileId <= kEndTile; ++tileId) {
+            for (uint32_t tileId : RprUsdFindUDIMTiles(formatString, &directoryListings)) {
                 auto tilePath = TfStringPrintf(formatString.c_str(), tileId);
-                if (ArchFileAccess(tilePath.c_str(), F_OK) == 0) {
-                    loadRequestTexIndices.push_back(getUniqueTextureIndex(tilePath, tileId));
-                }
+                loadRequestTexIndices.push_back(getUniqueTextureIndex(tilePath, tileId));
             }
         } else {
             loadRequestTexIndices.push_back(getUniqueTextureIndex(loadRequest->filepath));
         }
     }
 
-    // Read all textures from disk from multi threads
+    std::string textureCacheDir;
+    {
+        RprUsdConfig* config;
+        auto configLock = RprUsdConfig::GetInstance(&config);
+        textureCacheDir = config->GetTextureCacheDir();
+    }
+    // The disk cache keeps its running size between commits, it is recreated only when the directory changes
+    if (!m_textureDiskCache || m_textureCacheDir != textureCacheDir) {
+        m_textureDiskCache = std::make_unique<RprUsdTextureDiskCache>(textureCacheDir);
+        m_textureCacheDir = textureCacheDir;
+    }
+    auto& textureDiskCache = *m_textureDiskCache;
+    RprUsdTextureLoadOptions textureLoadOptions = imageCache->GetTextureLoadOptions();
+
+    // Read all textures from disk from multi threads.
+    // Already decoded textures are taken from the disk cache when possible
     //
     WorkParallelForN(uniqueTextures.size(),
-        [&uniqueTextures](size_t begin, size_t end) {
+        [&uniqueTextures, &textureDiskCache, &textureLoadOptions](size_t begin, size_t end) {
             for (size_t i = begin; i < end; ++i) {
-                if (auto textureData = RprUsdTextureData::New(uniqueTextures[i].path)) {
+                RprUsdTimelineZone readZone("ReadTexture", uniqueTextures[i].path.c_str());
+                if (auto cachedTextureData = textureDiskCache.Load(uniqueTextures[i].path, textureLoadOptions)) {
+                    uniqueTextures[i].data = cachedTextureData;
+                } else if (auto textureData = RprUsdTextureData::New(uniqueTextures[i].path, textureLoadOptions)) {
+                    textureDiskCache.Store(uniqueTextures[i].path, textureLoadOptions, *textureData);
                     uniqueTextures[i].data = textureData;
                 } else {
                     TF_RUNTIME_ERROR("Failed to load %s texture", uniqueTextures[i].path.c_str());
@@ -281,25 +329,39 @@ void RprUsdMaterialRegistry::CommitResources(
         }
     );
 
-    // Create rpr::Image for each previously read unique texture
-    // XXX(RPR): so as RPR API is single-threaded we cannot parallelize this
+    textureDiskCache.Trim();
+
+    // Create rpr::Image for each image from previously read unique textures.
+    // Texture data of different images is converted concurrently, RPR context is locked only to create rpr objects
     //
-    for (size_t i = 0; i < textureLoadRequests.size(); ++i) {
-        auto& loadRequestTexIndices = uniqueTextureIndicesPerLoadRequest[i];
-        if (loadRequestTexIndices.empty()) continue;
+    WorkParallelForN(images.size(),
+        [&images, &uniqueTextures, &textureLoadRequests, imageCache](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& image = images[i];
+                if (image.uniqueTextureIndices.empty()) continue;
+
+                std::vector<RprUsdCoreImage::UDIMTile> tiles;
+                tiles.reserve(image.uniqueTextureIndices.size());
+                for (auto uniqueTextureIdx : image.uniqueTextureIndices) {
+                    auto& texture = uniqueTextures[uniqueTextureIdx];
+                    if (!texture.data) continue;
 
-        std::vector<RprUsdCoreImage::UDIMTile> tiles;
-        tiles.reserve(loadRequestTexIndices.size());
-        for (auto uniqueTextureIdx : loadRequestTexIndices) {
-            auto& texture = uniqueTextures[uniqueTextureIdx];
-            if (!texture.data) continue;
+                    tiles.emplace_back(texture.udimTileId, texture.data.operator->());
+                }
 
-            tiles.emplace_back(texture.udimTileId, texture.data.operator->());
+                auto& loadRequest = textureLoadRequests[image.loadRequestIndices[0]];
+                RprUsdTimelineZone createZone("CreateRprImage", loadRequest->filepath.c_str());
+                image.image = imageCache->GetImage(loadRequest->filepath, loadRequest->colorspace, loadRequest->wrapType, tiles, loadRequest->numComponentsRequired);
+            }
         }
+    );
 
-        auto& loadRequest = textureLoadRequests[i];
-        auto coreImage = imageCache->GetImage(loadRequest->filepath, loadRequest->colorspace, loadRequest->wrapType, tiles, loadRequest->numComponentsRequired);
-        loadRequest->onDidLoadTexture(coreImage);
+    for (auto& image : images) {
+        if (image.uniqueTextureIndices.empty()) continue;
+
+        for (auto loadRequestIdx : image.loadRequestIndices) {
+            textureLoadRequests[loadRequestIdx]->onDidLoadTexture(image.image);
+        }
     }
 }
 
@@ -509,6 +571,156 @@ RprUsdMaterial* CreateMaterialXFromUsdShade(
 
 } // namespace anonymous
 
+namespace {
+
+size_t HashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+SdfPath GetCanonicalNodePath(SdfPath const& materialId, SdfPath const& nodePath) {
+    if (!materialId.IsEmpty() && nodePath.HasPrefix(materialId)) {
+        return nodePath.MakeRelativePath(materialId);
+    }
+    return nodePath;
+}
+
+VtValue GetCanonicalParameterValue(VtValue const& value) {
+    // Material nodes read textures by the resolved path,
+    // so different relative paths to the same file produce the same material
+    if (value.IsHolding<SdfAssetPath>()) {
+        auto& assetPath = value.UncheckedGet<SdfAssetPath>();
+        auto& path = assetPath.GetResolvedPath().empty() ? assetPath.GetAssetPath() : assetPath.GetResolvedPath();
+        return VtValue(SdfAssetPath(path));
+    }
+
+    return value;
+}
+
+RprUsd_MaterialNetworkConnection GetCanonicalConnection(SdfPath const& materialId, RprUsd_MaterialNetworkConnection const& connection) {
+    RprUsd_MaterialNetworkConnection ret;
+    ret.upstreamNode = GetCanonicalNodePath(materialId, connection.upstreamNode);
+    ret.upstreamOutputName = connection.upstreamOutputName;
+    return ret;
+}
+
+// Returns the copy of the network with node paths taken relative to the material,
+// so that copies of the same network under different material prims are equal
+RprUsd_MaterialNetwork GetCanonicalMaterialNetwork(SdfPath const& materialId, RprUsd_MaterialNetwork const& network) {
+    RprUsd_MaterialNetwork ret;
+    for (auto& entry : network.nodes) {
+        auto& node = entry.second;
+        auto& canonicalNode = ret.nodes[GetCanonicalNodePath(materialId, entry.first)];
+
+        canonicalNode.nodeTypeId = node.nodeTypeId;
+        for (auto& parameter : node.parameters) {
+            canonicalNode.parameters.emplace(parameter.first, GetCanonicalParameterValue(parameter.second));
+        }
+        for (auto& inputConnection : node.inputConnections) {
+            auto& canonicalConnections = canonicalNode.inputConnections[inputConnection.first];
+            for (auto& connection : inputConnection.second) {
+                canonicalConnections.push_back(GetCanonicalConnection(materialId, connection));
+            }
+        }
+    }
+
+    for (auto& terminal : network.terminals) {
+        ret.terminals.emplace(terminal.first, GetCanonicalConnection(materialId, terminal.second));
+    }
+
+    return ret;
+}
+
+// Houdini's principled shader is identified by the scene delegate, not by nodeTypeId
+std::vector<uint8_t> GetHoudiniPrincipledShaderFlags(
+    HdSceneDelegate* sceneDelegate,
+    RprUsd_MaterialNetwork const& network,
+    std::map<TfToken, size_t> const& registeredNodesLookup) {
+
+    std::vector<uint8_t> ret;
+    for (auto& entry : network.nodes) {
+        if (!registeredNodesLookup.count(entry.second.nodeTypeId)) {
+            bool isSurfaceNode = false;
+            bool isHoudiniPrincipledShader = IsHoudiniPrincipledShaderHydraNode(sceneDelegate, entry.first, &isSurfaceNode);
+            ret.push_back(uint8_t(isHoudiniPrincipledShader) | (uint8_t(isSurfaceNode) << 1));
+        }
+    }
+    return ret;
+}
+
+bool IsEqualConnection(RprUsd_MaterialNetworkConnection const& lhs, RprUsd_MaterialNetworkConnection const& rhs) {
+    return lhs.upstreamNode == rhs.upstreamNode && lhs.upstreamOutputName == rhs.upstreamOutputName;
+}
+
+bool IsEqualMaterialNetwork(RprUsd_MaterialNetwork const& lhs, RprUsd_MaterialNetwork const& rhs) {
+    if (lhs.nodes.size() != rhs.nodes.size() || lhs.terminals.size() != rhs.terminals.size()) {
+        return false;
+    }
+
+    for (auto lhsIt = lhs.nodes.begin(), rhsIt = rhs.nodes.begin(); lhsIt != lhs.nodes.end(); ++lhsIt, ++rhsIt) {
+        auto& lhsNode = lhsIt->second;
+        auto& rhsNode = rhsIt->second;
+        if (lhsIt->first != rhsIt->first ||
+            lhsNode.nodeTypeId != rhsNode.nodeTypeId ||
+            lhsNode.parameters != rhsNode.parameters ||
+            lhsNode.inputConnections.size() != rhsNode.inputConnections.size()) {
+            return false;
+        }
+
+        for (auto lhsInputIt = lhsNode.inputConnections.begin(), rhsInputIt = rhsNode.inputConnections.begin();
+             lhsInputIt != lhsNode.inputConnections.end(); ++lhsInputIt, ++rhsInputIt) {
+            if (lhsInputIt->first != rhsInputIt->first ||
+                !std::equal(lhsInputIt->second.begin(), lhsInputIt->second.end(),
+                            rhsInputIt->second.begin(), rhsInputIt->second.end(), IsEqualConnection)) {
+                return false;
+            }
+        }
+    }
+
+    for (auto lhsIt = lhs.terminals.begin(), rhsIt = rhs.terminals.begin(); lhsIt != lhs.terminals.end(); ++lhsIt, ++rhsIt) {
+        if (lhsIt->first != rhsIt->first || !IsEqualConnection(lhsIt->second, rhsIt->second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t HashConnection(RprUsd_MaterialNetworkConnection const& connection) {
+    return HashCombine(connection.upstreamNode.GetHash(), connection.upstreamOutputName.Hash());
+}
+
+// Computes the hash of the canonical network, see GetCanonicalMaterialNetwork
+size_t HashMaterialNetwork(RprUsd_MaterialNetwork const& network) {
+    size_t hash = network.nodes.size();
+    for (auto& entry : network.nodes) {
+        auto& node = entry.second;
+
+        hash = HashCombine(hash, entry.first.GetHash());
+        hash = HashCombine(hash, node.nodeTypeId.Hash());
+
+        for (auto& parameter : node.parameters) {
+            hash = HashCombine(hash, parameter.first.Hash());
+            hash = HashCombine(hash, parameter.second.GetHash());
+        }
+
+        for (auto& inputConnection : node.inputConnections) {
+            hash = HashCombine(hash, inputConnection.first.Hash());
+            for (auto& connection : inputConnection.second) {
+                hash = HashCombine(hash, HashConnection(connection));
+            }
+        }
+    }
+
+    for (auto& terminal : network.terminals) {
+        hash = HashCombine(hash, terminal.first.Hash());
+        hash = HashCombine(hash, HashConnection(terminal.second));
+    }
+
+    return hash;
+}
+
+} // namespace anonymous
+
 RprUsdMaterial* RprUsdMaterialRegistry::CreateMaterial(
     SdfPath const& materialId,
     HdSceneDelegate* sceneDelegate,
@@ -532,6 +744,127 @@ RprUsdMaterial* RprUsdMaterialRegistry::CreateMaterial(
         entry.second.upstreamOutputName = entry.first;
     }
 
+    int materialRprId = sceneDelegate->GetLightParamValue(materialId, RprUsdTokens->rprMaterialId).GetWithDefault(-1);
+    std::string cryptomatteName = sceneDelegate->GetLightParamValue(materialId, RprUsdTokens->rprMaterialAssetName).GetWithDefault(std::string{});
+    if (cryptomatteName.empty()) {
+        cryptomatteName = materialId.GetString();
+    }
+
+    if (!TfGetEnvSetting(RPRUSD_MATERIAL_DEDUPLICATION)) {
+        return CreateMaterialImpl(materialId, sceneDelegate, network, isVolume, cryptomatteName, materialRprId, rprContext, imageCache, isHybrid, hybridEnableDisplacement);
+    }
+
+    // The material ID and the cryptomatte name are set on the material node, so they are part of the key.
+    // Materials without an authored asset name are named by their path, hence only materials
+    // with the same asset name can be shared without merging them in the cryptomatte material AOV
+    SharedMaterialDesc desc;
+    desc.network = GetCanonicalMaterialNetwork(materialId, network);
+    desc.houdiniPrincipledShaderFlags = GetHoudiniPrincipledShaderFlags(sceneDelegate, network, m_registeredNodesLookup);
+    desc.isVolume = isVolume;
+    desc.materialRprId = materialRprId;
+    desc.cryptomatteName = cryptomatteName;
+    desc.imageCache = imageCache;
+    desc.isHybrid = isHybrid;
+    desc.hybridEnableDisplacement = hybridEnableDisplacement;
+
+    size_t key = HashMaterialNetwork(desc.network);
+    for (auto flags : desc.houdiniPrincipledShaderFlags) {
+        key = HashCombine(key, flags);
+    }
+    key = HashCombine(key, size_t(isVolume));
+    key = HashCombine(key, std::hash<int>{}(materialRprId));
+    key = HashCombine(key, std::hash<std::string>{}(desc.cryptomatteName));
+    key = HashCombine(key, std::hash<void*>{}(rprContext));
+    key = HashCombine(key, std::hash<void*>{}(imageCache));
+    key = HashCombine(key, size_t(isHybrid) | (size_t(hybridEnableDisplacement) << 1));
+
+    auto isSameMaterial = [&desc, rprContext](SharedMaterial const& sharedMaterial) {
+        auto& sharedDesc = sharedMaterial.desc;
+        return sharedMaterial.rprContext == rprContext &&
+            sharedDesc.isVolume == desc.isVolume &&
+            sharedDesc.materialRprId == desc.materialRprId &&
+            sharedDesc.cryptomatteName == desc.cryptomatteName &&
+            sharedDesc.imageCache == desc.imageCache &&
+            sharedDesc.isHybrid == desc.isHybrid &&
+            sharedDesc.hybridEnableDisplacement == desc.hybridEnableDisplacement &&
+            sharedDesc.houdiniPrincipledShaderFlags == desc.houdiniPrincipledShaderFlags &&
+            IsEqualMaterialNetwork(sharedDesc.network, desc.network);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMaterialsMutex);
+        auto it = m_sharedMaterials.find(key);
+        if (it != m_sharedMaterials.end()) {
+            if (isSameMaterial(it->second)) {
+                it->second.numReferences++;
+                TF_DEBUG(RPR_USD_DEBUG_MATERIAL_REGISTRY).Msg("Reusing material with the same network for %s\n", materialId.GetText());
+                return it->second.material;
+            }
+            // Otherwise it's a hash collision, such a material is created as usual and is not shared
+        }
+    }
+
+    auto material = CreateMaterialImpl(materialId, sceneDelegate, network, isVolume, cryptomatteName, materialRprId, rprContext, imageCache, isHybrid, hybridEnableDisplacement);
+    if (material) {
+        std::lock_guard<std::mutex> lock(m_sharedMaterialsMutex);
+
+        // If a concurrent call or a colliding network has already registered the same key, our material stays unshared
+        if (m_sharedMaterials.emplace(key, SharedMaterial{material, rprContext, 1, std::move(desc)}).second) {
+            m_sharedMaterialKeys.emplace(material, key);
+        }
+    }
+
+    return material;
+}
+
+bool RprUsdMaterialRegistry::ReleaseMaterial(RprUsdMaterial* material) {
+    if (!material) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sharedMaterialsMutex);
+
+    auto keyIt = m_sharedMaterialKeys.find(material);
+    if (keyIt == m_sharedMaterialKeys.end()) {
+        return true;
+    }
+
+    auto it = m_sharedMaterials.find(keyIt->second);
+    if (it == m_sharedMaterials.end() || --it->second.numReferences == 0) {
+        if (it != m_sharedMaterials.end()) {
+            m_sharedMaterials.erase(it);
+        }
+        m_sharedMaterialKeys.erase(keyIt);
+        return true;
+    }
+
+    return false;
+}
+
+size_t RprUsdMaterialRegistry::GetNumDeduplicatedMaterials(rpr::Context* rprContext) {
+    std::lock_guard<std::mutex> lock(m_sharedMaterialsMutex);
+
+    size_t numDeduplicatedMaterials = 0;
+    for (auto& entry : m_sharedMaterials) {
+        if (entry.second.rprContext == rprContext) {
+            numDeduplicatedMaterials += entry.second.numReferences - 1;
+        }
+    }
+    return numDeduplicatedMaterials;
+}
+
+RprUsdMaterial* RprUsdMaterialRegistry::CreateMaterialImpl(
+    SdfPath const& materialId,
+    HdSceneDelegate* sceneDelegate,
+    RprUsd_MaterialNetwork const& network,
+    bool isVolume,
+    std::string const& cryptomatteName,
+    int materialRprId,
+    rpr::Context* rprContext,
+    RprUsdImageCache* imageCache,
+    bool isHybrid,
+    bool hybridEnableDisplacement) {
+
     RprUsd_MaterialBuilderContext context = {};
     context.materialNetwork = &network;
     context.rprContext = rprContext;
@@ -742,12 +1075,6 @@ RprUsdMaterial* RprUsdMaterialRegistry::CreateMaterial(
         displacementOutput = VtValue();
     }
 
-    int materialRprId = sceneDelegate->GetLightParamValue(materialId, RprUsdTokens->rprMaterialId).GetWithDefault(-1);
-    std::string cryptomatteName = sceneDelegate->GetLightParamValue(materialId, RprUsdTokens->rprMaterialAssetName).GetWithDefault(std::string{});
-    if (cryptomatteName.empty()) {
-        cryptomatteName = materialId.GetString();
-    }
-
     if (out->Finalize(context, surfaceOutput, displacementOutput, volumeOutput, cryptomatteName.c_str(), materialRprId, isHybrid, rprContext)) {
         return out.release();
     }
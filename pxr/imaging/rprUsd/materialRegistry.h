@@ -24,11 +24,15 @@ limitations under the License.
 
 #include <RadeonProRender.hpp>
 
+#include <mutex>
+#include <unordered_map>
+
 class RPRMtlxLoader;
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 class RprUsdImageCache;
+class RprUsdTextureDiskCache;
 class RprUsdCoreImage;
 class RprUsdMaterial;
 class RprUsdMaterialNodeInfo;
@@ -104,6 +108,16 @@ public:
         bool isHybrid,
         bool hybridEnableDisplacement);
 
+    /// Releases material created with CreateMaterial.
+    /// Materials with identical networks are shared between material prims,
+    /// returns true when the last reference is gone and the caller should destroy the material
+    RPRUSD_API
+    bool ReleaseMaterial(RprUsdMaterial* material);
+
+    /// Returns the number of materials that currently reuse another material with the same network
+    RPRUSD_API
+    size_t GetNumDeduplicatedMaterials(rpr::Context* rprContext);
+
     RPRUSD_API
     TfToken const& GetMaterialNetworkSelector();
 
@@ -141,6 +155,18 @@ private:
     friend class TfSingleton<RprUsdMaterialRegistry>;
     RprUsdMaterialRegistry();
 
+    RprUsdMaterial* CreateMaterialImpl(
+        SdfPath const& materialId,
+        HdSceneDelegate* sceneDelegate,
+        RprUsd_MaterialNetwork const& network,
+        bool isVolume,
+        std::string const& cryptomatteName,
+        int materialRprId,
+        rpr::Context* rprContext,
+        RprUsdImageCache* imageCache,
+        bool isHybrid,
+        bool hybridEnableDisplacement);
+
 private:
     /// Material network selector for the current session, controlled via env variable
     TfToken m_materialNetworkSelector;
@@ -158,6 +184,33 @@ private:
     std::map<TfToken, size_t> m_registeredNodesLookup;
 
     std::vector<std::weak_ptr<TextureLoadRequest>> m_textureLoadRequests;
+
+    std::string m_textureCacheDir;
+    std::unique_ptr<RprUsdTextureDiskCache> m_textureDiskCache;
+
+    /// Everything that affects the material created from a network.
+    /// Node paths of the network are relative to the material
+    struct SharedMaterialDesc {
+        RprUsd_MaterialNetwork network;
+        std::vector<uint8_t> houdiniPrincipledShaderFlags;
+        bool isVolume;
+        int materialRprId;
+        std::string cryptomatteName;
+        RprUsdImageCache* imageCache;
+        bool isHybrid;
+        bool hybridEnableDisplacement;
+    };
+    struct SharedMaterial {
+        RprUsdMaterial* material;
+        rpr::Context* rprContext;
+        size_t numReferences;
+
+        /// Confirms that materials with equal keys are indeed the same
+        SharedMaterialDesc desc;
+    };
+    std::mutex m_sharedMaterialsMutex;
+    std::unordered_map<size_t, SharedMaterial> m_sharedMaterials;
+    std::unordered_map<RprUsdMaterial*, size_t> m_sharedMaterialKeys;
 };
 
 class RprUsdMaterialNodeInput;
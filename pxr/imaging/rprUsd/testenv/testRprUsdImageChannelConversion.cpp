@@ -0,0 +1,241 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks that the parallel texture channel conversion is bit-exact with the serial implementation
+// RprUsdCoreImage used before.
+// Usage: testRprUsdImageChannelConversion [--benchmark [width] [height]]
+
+#include "pxr/imaging/rprUsd/coreImage.h"
+#include "testUtils.h"
+
+#include "pxr/base/gf/half.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+// Serial implementation that RprUsdCoreImage used before
+namespace reference {
+
+template <typename ComponentT, typename PixelConverterFunc>
+std::unique_ptr<uint8_t[]> _ConvertTexture(uint8_t const* src, size_t numPixels, rpr::ImageFormat const& srcFormat, uint32_t dstNumComponents, PixelConverterFunc&& converter) {
+    size_t srcPixelStride = srcFormat.num_components * sizeof(ComponentT);
+    size_t dstPixelStride = dstNumComponents * sizeof(ComponentT);
+
+    auto dstData = std::make_unique<uint8_t[]>(numPixels * dstPixelStride);
+    uint8_t* dst = dstData.get();
+
+    for (size_t i = 0; i < numPixels; ++i) {
+        converter((ComponentT*)(dst + i * dstPixelStride), (ComponentT const*)(src + i * srcPixelStride));
+    }
+
+    return dstData;
+}
+
+template <typename T>
+struct WhiteColor {
+    const T value = static_cast<T>(1);
+};
+
+template <> struct WhiteColor<uint8_t> {
+    const uint8_t value = 255u;
+};
+
+template <typename ComponentT>
+std::unique_ptr<uint8_t[]> ConvertTexture(uint8_t const* srcData, size_t numPixels, rpr::ImageFormat const& format, uint32_t dstNumComponents) {
+    if (dstNumComponents < format.num_components) {
+        return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+            [=](ComponentT* dst, ComponentT const* src) {
+                for (size_t i = 0; i < dstNumComponents; ++i) {
+                    dst[i] = src[i];
+                }
+            }
+        );
+    }
+
+    if (format.num_components == 1) {
+        if (dstNumComponents == 4) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
+                    dst[0] = dst[1] = dst[2] = src[0];
+                    dst[3] = WhiteColor<ComponentT>{}.value;
+                }
+            );
+        } else {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [=](ComponentT* dst, ComponentT const* src) {
+                    for (size_t i = 0; i < dstNumComponents; ++i) {
+                        dst[i] = src[0];
+                    }
+                }
+            );
+        }
+    } else if (format.num_components == 2) {
+        if (dstNumComponents == 4) {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
+                    dst[0] = dst[1] = dst[2] = src[0];
+                    dst[3] = src[1];
+                }
+            );
+        } else {
+            return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+                [](ComponentT* dst, ComponentT const* src) {
+                    dst[0] = dst[1] = dst[2] = src[0];
+                }
+            );
+        }
+    } else if (format.num_components == 3) {
+        return _ConvertTexture<ComponentT>(srcData, numPixels, format, dstNumComponents,
+            [](ComponentT* dst, ComponentT const* src) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = WhiteColor<ComponentT>{}.value;
+            }
+        );
+    }
+
+    return nullptr;
+}
+
+} // namespace reference
+
+template <typename ComponentT>
+ComponentT GenerateComponent(std::mt19937& generator, size_t index);
+
+template <>
+uint8_t GenerateComponent<uint8_t>(std::mt19937& generator, size_t index) {
+    return uint8_t(generator() & 0xFF);
+}
+
+template <>
+float GenerateComponent<float>(std::mt19937& generator, size_t index) {
+    // HDR values, negative zero, infinities and denormals are copied as is
+    const float kSpecialValues[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 1e-40f, 65504.0f, 1e30f,
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+    };
+    const size_t kNumSpecialValues = sizeof(kSpecialValues) / sizeof(kSpecialValues[0]);
+    if (index < kNumSpecialValues) {
+        return kSpecialValues[index];
+    }
+    return std::uniform_real_distribution<float>(-10.0f, 1000.0f)(generator);
+}
+
+template <>
+GfHalf GenerateComponent<GfHalf>(std::mt19937& generator, size_t index) {
+    GfHalf value;
+    value.setBits(uint16_t(generator() & 0xFFFF));
+    // Keep NaNs out, their bits are not guaranteed to survive float conversions
+    return value.isNan() ? GfHalf(0.5f) : value;
+}
+
+template <typename ComponentT>
+std::vector<ComponentT> GenerateImage(size_t numPixels, uint32_t numComponents) {
+    std::mt19937 generator(42);
+    std::vector<ComponentT> srcData(numPixels * numComponents);
+    for (size_t i = 0; i < srcData.size(); ++i) {
+        srcData[i] = GenerateComponent<ComponentT>(generator, i);
+    }
+    return srcData;
+}
+
+template <typename ComponentT>
+void TestConversion(rpr_component_type componentType, size_t numPixels) {
+    for (uint32_t srcNumComponents = 1; srcNumComponents <= 4; ++srcNumComponents) {
+        auto srcData = GenerateImage<ComponentT>(numPixels, srcNumComponents);
+
+        rpr::ImageFormat format = {};
+        format.num_components = srcNumComponents;
+        format.type = componentType;
+
+        // Unsupported number of destination components
+        TF_AXIOM(!RprUsdConvertImageChannels(srcData.data(), numPixels, format, 0));
+        TF_AXIOM(!RprUsdConvertImageChannels(srcData.data(), numPixels, format, 5));
+
+        for (uint32_t dstNumComponents = 1; dstNumComponents <= 4; ++dstNumComponents) {
+            if (dstNumComponents == srcNumComponents) {
+                // Nothing to convert
+                TF_AXIOM(!RprUsdConvertImageChannels(srcData.data(), numPixels, format, dstNumComponents));
+                continue;
+            }
+
+            auto expected = reference::ConvertTexture<ComponentT>((uint8_t const*)srcData.data(), numPixels, format, dstNumComponents);
+            auto result = RprUsdConvertImageChannels(srcData.data(), numPixels, format, dstNumComponents);
+
+            TF_AXIOM(expected && result);
+            TF_AXIOM(RprUsdTestIsBitwiseEqual(expected.get(), result.get(), numPixels * dstNumComponents * sizeof(ComponentT)));
+        }
+    }
+}
+
+template <typename ComponentT>
+void Benchmark(rpr_component_type componentType, const char* typeName, size_t numPixels) {
+    for (uint32_t srcNumComponents = 1; srcNumComponents <= 4; ++srcNumComponents) {
+        auto srcData = GenerateImage<ComponentT>(numPixels, srcNumComponents);
+
+        rpr::ImageFormat format = {};
+        format.num_components = srcNumComponents;
+        format.type = componentType;
+
+        for (uint32_t dstNumComponents = 1; dstNumComponents <= 4; ++dstNumComponents) {
+            if (dstNumComponents == srcNumComponents) {
+                continue;
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s %u -> %u", typeName, srcNumComponents, dstNumComponents);
+            RprUsdTestCompareSpeed(name,
+                [&]() { RprUsdConvertImageChannels(srcData.data(), numPixels, format, dstNumComponents); },
+                [&]() { reference::ConvertTexture<ComponentT>((uint8_t const*)srcData.data(), numPixels, format, dstNumComponents); });
+        }
+    }
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    RprUsdTestArgs args(argc, argv);
+
+    // Include sizes that are not a multiple of the parallel chunk size
+    for (size_t numPixels : {size_t(1), size_t(17), size_t(64 * 1024 + 1), size_t(3 * 64 * 1024 - 7)}) {
+        TestConversion<uint8_t>(RPR_COMPONENT_TYPE_UINT8, numPixels);
+        TestConversion<GfHalf>(RPR_COMPONENT_TYPE_FLOAT16, numPixels);
+        TestConversion<float>(RPR_COMPONENT_TYPE_FLOAT32, numPixels);
+    }
+
+    if (args.IsBenchmark()) {
+        size_t width = args.GetSize(0, 4096);
+        size_t height = args.GetSize(1, 4096);
+        size_t numPixels = width * height;
+
+        printf("Channel conversion of %zux%zu texture:\n", width, height);
+        Benchmark<uint8_t>(RPR_COMPONENT_TYPE_UINT8, "UInt8", numPixels);
+        Benchmark<GfHalf>(RPR_COMPONENT_TYPE_FLOAT16, "Float16", numPixels);
+        Benchmark<float>(RPR_COMPONENT_TYPE_FLOAT32, "Float32", numPixels);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks the box filter that downsamples textures exceeding the maximum resolution against a scalar reference implementation.
+// Usage: testRprUsdTextureDownsampling
+
+#include "pxr/imaging/rprUsd/util.h"
+
+#include "pxr/base/gf/half.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+#if PXR_VERSION >= 2105
+
+namespace {
+
+namespace reference {
+
+// Average of all source pixels covered by each destination pixel computed in double precision
+template <typename ComponentT>
+std::vector<double> Downsample(std::vector<ComponentT> const& src, int srcWidth, int srcHeight, int numComponents, int factor) {
+    int dstWidth = (srcWidth + factor - 1) / factor;
+    int dstHeight = (srcHeight + factor - 1) / factor;
+
+    std::vector<double> dst(size_t(dstWidth) * dstHeight * numComponents);
+    for (int dstY = 0; dstY < dstHeight; ++dstY) {
+        for (int dstX = 0; dstX < dstWidth; ++dstX) {
+            for (int c = 0; c < numComponents; ++c) {
+                double sum = 0.0;
+                int numPixels = 0;
+                for (int srcY = dstY * factor; srcY < std::min((dstY + 1) * factor, srcHeight); ++srcY) {
+                    for (int srcX = dstX * factor; srcX < std::min((dstX + 1) * factor, srcWidth); ++srcX) {
+                        sum += double(src[(size_t(srcY) * srcWidth + srcX) * numComponents + c]);
+                        ++numPixels;
+                    }
+                }
+                dst[(size_t(dstY) * dstWidth + dstX) * numComponents + c] = sum / numPixels;
+            }
+        }
+    }
+    return dst;
+}
+
+} // namespace reference
+
+template <typename ComponentT>
+std::vector<ComponentT> Downsample(std::vector<ComponentT> const& src, HioFormat format, int srcWidth, int srcHeight, int factor) {
+    HioImage::StorageSpec srcSpec;
+    srcSpec.width = srcWidth;
+    srcSpec.height = srcHeight;
+    srcSpec.depth = 1;
+    srcSpec.format = format;
+    srcSpec.flipped = false;
+    srcSpec.data = const_cast<ComponentT*>(src.data());
+
+    HioImage::StorageSpec dstSpec = srcSpec;
+    dstSpec.width = (srcWidth + factor - 1) / factor;
+    dstSpec.height = (srcHeight + factor - 1) / factor;
+
+    std::vector<ComponentT> dst(size_t(dstSpec.width) * dstSpec.height * HioGetComponentCount(format));
+    dstSpec.data = dst.data();
+
+    TF_AXIOM(RprUsdDownsampleImage(srcSpec, &dstSpec, factor));
+    return dst;
+}
+
+template <typename ComponentT>
+std::vector<ComponentT> GenerateImage(size_t numComponents, double minValue, double maxValue) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(minValue, maxValue);
+
+    std::vector<ComponentT> image(numComponents);
+    for (auto& value : image) {
+        value = ComponentT(std::is_integral<ComponentT>::value ? std::round(distribution(generator)) : distribution(generator));
+    }
+    return image;
+}
+
+// Integer images are rounded to the nearest value, floating point images hold the average within the precision of the type.
+// maxError accounts for the precision of the accumulator and the destination type
+template <typename ComponentT>
+void TestConversion(HioFormat baseFormat, double minValue, double maxValue, double maxError) {
+    // Odd sizes produce partial blocks at the right and bottom edges, factors larger than the image produce a single pixel
+    const int kSizes[][2] = {{1, 1}, {5, 3}, {7, 7}, {16, 9}, {33, 17}};
+    const int kFactors[] = {1, 2, 3, 4, 8, 64};
+
+    for (int numComponents = 1; numComponents <= 4; ++numComponents) {
+        HioFormat format = HioFormat(baseFormat + numComponents - 1);
+        TF_AXIOM(HioGetComponentCount(format) == numComponents);
+
+        for (auto& size : kSizes) {
+            int width = size[0];
+            int height = size[1];
+            auto src = GenerateImage<ComponentT>(size_t(width) * height * numComponents, minValue, maxValue);
+
+            for (int factor : kFactors) {
+                auto result = Downsample(src, format, width, height, factor);
+                auto expected = reference::Downsample(src, width, height, numComponents, factor);
+                TF_AXIOM(result.size() == expected.size());
+
+                for (size_t i = 0; i < result.size(); ++i) {
+                    double expectedValue = std::is_integral<ComponentT>::value ? std::round(expected[i]) : expected[i];
+                    TF_AXIOM(std::abs(double(result[i]) - expectedValue) <= maxError);
+                }
+
+                if (factor == 1) {
+                    // Nothing to average
+                    TF_AXIOM(std::equal(result.begin(), result.end(), src.begin(),
+                        [](ComponentT lhs, ComponentT rhs) { return double(lhs) == double(rhs); }));
+                }
+            }
+        }
+    }
+}
+
+void TestPartialBlocks() {
+    // The last pixel of each row and column covers only a part of the block and is averaged over the pixels it covers
+    std::vector<uint8_t> src = {
+        10, 20, 31,
+        30, 40, 51,
+        90, 91, 200,
+    };
+    auto result = Downsample(src, HioFormatUNorm8, 3, 3, 2);
+    TF_AXIOM(result == (std::vector<uint8_t>{25, 41, 91, 200}));
+
+    // Rounding to nearest
+    std::vector<uint8_t> roundingSrc = {0, 1, 1, 1};
+    TF_AXIOM(Downsample(roundingSrc, HioFormatUNorm8, 2, 2, 2) == std::vector<uint8_t>{1});
+    roundingSrc = {0, 0, 0, 1};
+    TF_AXIOM(Downsample(roundingSrc, HioFormatUNorm8, 2, 2, 2) == std::vector<uint8_t>{0});
+}
+
+void TestUnsupportedFormats() {
+    // Block compressed data can't be averaged per pixel
+    std::vector<uint8_t> src(4 * 4 * 4);
+    std::vector<uint8_t> dst(2 * 2 * 4);
+
+    HioImage::StorageSpec srcSpec;
+    srcSpec.width = 4;
+    srcSpec.height = 4;
+    srcSpec.depth = 1;
+    srcSpec.format = HioFormatBC7UNorm8Vec4;
+    srcSpec.flipped = false;
+    srcSpec.data = src.data();
+
+    HioImage::StorageSpec dstSpec = srcSpec;
+    dstSpec.width = 2;
+    dstSpec.height = 2;
+    dstSpec.data = dst.data();
+
+    TF_AXIOM(!RprUsdDownsampleImage(srcSpec, &dstSpec, 2));
+}
+
+} // namespace anonymous
+
+#endif // PXR_VERSION >= 2105
+
+int main(int argc, char* argv[]) {
+#if PXR_VERSION >= 2105
+    TestConversion<uint8_t>(HioFormatUNorm8, 0.0, 255.0, 0.0);
+    TestConversion<int8_t>(HioFormatSNorm8, -128.0, 127.0, 0.0);
+    TestConversion<uint16_t>(HioFormatUInt16, 0.0, 65535.0, 1.0);
+    TestConversion<int32_t>(HioFormatInt32, -1e6, 1e6, 0.0);
+    TestConversion<GfHalf>(HioFormatFloat16, -100.0, 1000.0, 1.0);
+    TestConversion<float>(HioFormatFloat32, -100.0, 1000.0, 0.1);
+    TestPartialBlocks();
+    TestUnsupportedFormats();
+#endif // PXR_VERSION >= 2105
+
+    return EXIT_SUCCESS;
+}
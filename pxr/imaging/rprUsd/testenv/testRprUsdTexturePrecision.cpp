@@ -0,0 +1,224 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks that textures are stored with the smallest component type that represents them within the error threshold.
+// Usage: testRprUsdTexturePrecision
+
+#include "pxr/imaging/rprUsd/util.h"
+
+#include "pxr/base/gf/half.h"
+#include "pxr/base/tf/diagnostic.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+#if PXR_VERSION >= 2105
+
+namespace {
+
+struct Texture {
+    HioImage::StorageSpec spec;
+    std::unique_ptr<uint8_t[]> data;
+};
+
+template <typename T>
+Texture MakeTexture(HioFormat format, int width, int height, std::vector<T> const& values) {
+    TF_AXIOM(values.size() == size_t(width) * height * HioGetComponentCount(format));
+
+    Texture texture;
+    texture.data = std::make_unique<uint8_t[]>(values.size() * sizeof(T));
+    std::memcpy(texture.data.get(), values.data(), values.size() * sizeof(T));
+
+    texture.spec.width = width;
+    texture.spec.height = height;
+    texture.spec.depth = 1;
+    texture.spec.format = format;
+    texture.spec.flipped = false;
+    texture.spec.data = texture.data.get();
+    return texture;
+}
+
+template <typename T>
+std::vector<T> GetValues(Texture const& texture) {
+    TF_AXIOM(texture.spec.data == texture.data.get());
+    size_t numComponents = size_t(texture.spec.width) * texture.spec.height * HioGetComponentCount(texture.spec.format);
+    TF_AXIOM(HioGetDataSizeOfFormat(texture.spec.format) == HioGetComponentCount(texture.spec.format) * sizeof(T));
+
+    std::vector<T> values(numComponents);
+    std::memcpy(values.data(), texture.data.get(), numComponents * sizeof(T));
+    return values;
+}
+
+template <typename T>
+HioFormat Reduce(HioFormat format, std::vector<T> const& values, float maxError, Texture* outTexture = nullptr) {
+    auto texture = MakeTexture(format, int(values.size()), 1, values);
+    RprUsdReducePrecision(&texture.spec, &texture.data, maxError);
+    auto reducedFormat = texture.spec.format;
+    if (outTexture) {
+        *outTexture = std::move(texture);
+    }
+    return reducedFormat;
+}
+
+void TestFloat32() {
+    Texture texture;
+
+    // Values that are exactly representable by 8-bit normalized integers
+    std::vector<float> ldrValues = {0.0f, 1.0f, 51.0f / 255.0f, 128.0f / 255.0f};
+    TF_AXIOM(Reduce(HioFormatFloat32, ldrValues, 0.0f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{0, 255, 51, 128}));
+
+    // LDR values that need quantization are reduced to 8-bit only within the error threshold
+    std::vector<float> roughness = {0.31f, 0.71f, 0.0f, 1.0f};
+    TF_AXIOM(Reduce(HioFormatFloat32, roughness, 0.0f, &texture) == HioFormatFloat32);
+    TF_AXIOM(GetValues<float>(texture) == roughness);
+    TF_AXIOM(Reduce(HioFormatFloat32, roughness, 0.01f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{79, 181, 0, 255}));
+
+    // HDR and negative values that are exactly representable by half
+    std::vector<float> hdrValues = {2.5f, -0.5f, 1024.0f, 65504.0f, 0.0f};
+    TF_AXIOM(Reduce(HioFormatFloat32, hdrValues, 0.0f, &texture) == HioFormatFloat16);
+    auto halfValues = GetValues<GfHalf>(texture);
+    for (size_t i = 0; i < hdrValues.size(); ++i) {
+        TF_AXIOM(float(halfValues[i]) == hdrValues[i]);
+    }
+
+    // Infinities are preserved by half
+    std::vector<float> infinities = {2.0f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+    TF_AXIOM(Reduce(HioFormatFloat32, infinities, 0.0f, &texture) == HioFormatFloat16);
+    halfValues = GetValues<GfHalf>(texture);
+    TF_AXIOM(halfValues[0] == GfHalf(2.0f) && halfValues[1].isInfinity() && halfValues[2].isInfinity() && halfValues[2].isNegative());
+
+    // Half rounding is within the relative error threshold
+    std::vector<float> inexactValues = {2.3f, 100.1f};
+    TF_AXIOM(Reduce(HioFormatFloat32, inexactValues, 0.0f) == HioFormatFloat32);
+    TF_AXIOM(Reduce(HioFormatFloat32, inexactValues, 1e-3f, &texture) == HioFormatFloat16);
+    halfValues = GetValues<GfHalf>(texture);
+    for (size_t i = 0; i < inexactValues.size(); ++i) {
+        TF_AXIOM(std::abs(float(halfValues[i]) - inexactValues[i]) <= 1e-3f * inexactValues[i]);
+    }
+
+    // Values that overflow half
+    TF_AXIOM(Reduce(HioFormatFloat32, std::vector<float>{1.0f, 65520.0f}, 0.0f) == HioFormatFloat32);
+    TF_AXIOM(Reduce(HioFormatFloat32, std::vector<float>{1.0f, 1e6f}, 1e-3f) == HioFormatFloat32);
+
+    // NaN is not LDR data and is kept as is
+    TF_AXIOM(Reduce(HioFormatFloat32, std::vector<float>{0.0f, std::numeric_limits<float>::quiet_NaN()}, 0.0f) == HioFormatFloat16);
+
+    // Negative threshold is treated as lossless
+    TF_AXIOM(Reduce(HioFormatFloat32, roughness, -1.0f) == HioFormatFloat32);
+}
+
+void TestFloat16() {
+    Texture texture;
+
+    std::vector<GfHalf> maskValues = {GfHalf(0.0f), GfHalf(1.0f), GfHalf(1.0f), GfHalf(0.0f)};
+    TF_AXIOM(Reduce(HioFormatFloat16, maskValues, 0.0f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{0, 255, 255, 0}));
+
+    // Half data that does not fit 8-bit stays as is
+    std::vector<GfHalf> values = {GfHalf(0.25f), GfHalf(4.0f)};
+    TF_AXIOM(Reduce(HioFormatFloat16, values, 0.0f, &texture) == HioFormatFloat16);
+    auto halfValues = GetValues<GfHalf>(texture);
+    TF_AXIOM(halfValues[0].bits() == values[0].bits() && halfValues[1].bits() == values[1].bits());
+}
+
+void TestUInt16() {
+    Texture texture;
+
+    // 16-bit data is normalized, multiples of 257 are exactly representable by 8-bit normalized integers
+    std::vector<uint16_t> ldrValues = {0, 65535, 257 * 51, 257 * 128};
+    TF_AXIOM(Reduce(HioFormatUInt16, ldrValues, 0.0f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{0, 255, 51, 128}));
+
+    std::vector<uint16_t> values = {1000, 0, 65535, 32767};
+    TF_AXIOM(Reduce(HioFormatUInt16, values, 0.01f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{4, 0, 255, 127}));
+
+    // RPR does not support 16-bit integer images, data that can't be reduced is converted to float without loss
+    TF_AXIOM(Reduce(HioFormatUInt16, values, 0.0f, &texture) == HioFormatFloat32);
+    auto floatValues = GetValues<float>(texture);
+    for (size_t i = 0; i < values.size(); ++i) {
+        TF_AXIOM(floatValues[i] == float(double(values[i]) / 65535.0));
+        TF_AXIOM(uint16_t(std::round(double(floatValues[i]) * 65535.0)) == values[i]);
+    }
+}
+
+void TestMultipleComponents() {
+    // The analysis is per component, not per pixel
+    std::vector<float> values = {
+        0.0f, 1.0f, 0.0f,
+        1.0f, 0.0f, 1.0f,
+    };
+    auto texture = MakeTexture(HioFormatFloat32Vec3, 1, 2, values);
+    RprUsdReducePrecision(&texture.spec, &texture.data, 0.0f);
+    TF_AXIOM(texture.spec.format == HioFormatUNorm8Vec3);
+    TF_AXIOM(texture.spec.width == 1 && texture.spec.height == 2);
+    TF_AXIOM(GetValues<uint8_t>(texture) == (std::vector<uint8_t>{0, 255, 0, 255, 0, 255}));
+
+    values[4] = 3.0f;
+    texture = MakeTexture(HioFormatFloat32Vec2, 3, 1, values);
+    RprUsdReducePrecision(&texture.spec, &texture.data, 0.0f);
+    TF_AXIOM(texture.spec.format == HioFormatFloat16Vec2);
+}
+
+void TestMultipleChunks() {
+    // The analysis is split into chunks, a single value in the last chunk must be taken into account
+    std::vector<float> values(1000 * 1000 + 3, 1.0f);
+    TF_AXIOM(Reduce(HioFormatFloat32, values, 0.0f) == HioFormatUNorm8);
+
+    values.back() = 2.0f;
+    TF_AXIOM(Reduce(HioFormatFloat32, values, 0.0f) == HioFormatFloat16);
+
+    values.back() = 2.3f;
+    TF_AXIOM(Reduce(HioFormatFloat32, values, 0.0f) == HioFormatFloat32);
+
+    values.back() = 1.0f;
+    values.front() = 2.3f;
+    TF_AXIOM(Reduce(HioFormatFloat32, values, 0.0f) == HioFormatFloat32);
+}
+
+void TestUnsupportedFormats() {
+    Texture texture;
+
+    // 8-bit data is already the smallest type
+    std::vector<uint8_t> values = {0, 1, 2, 3};
+    TF_AXIOM(Reduce(HioFormatUNorm8, values, 0.0f, &texture) == HioFormatUNorm8);
+    TF_AXIOM(GetValues<uint8_t>(texture) == values);
+
+    TF_AXIOM(Reduce(HioFormatInt32, std::vector<int32_t>{0, 1}, 0.0f) == HioFormatInt32);
+}
+
+} // namespace anonymous
+
+#endif // PXR_VERSION >= 2105
+
+int main(int argc, char* argv[]) {
+#if PXR_VERSION >= 2105
+    TestFloat32();
+    TestFloat16();
+    TestUInt16();
+    TestMultipleComponents();
+    TestMultipleChunks();
+    TestUnsupportedFormats();
+#endif // PXR_VERSION >= 2105
+
+    return EXIT_SUCCESS;
+}
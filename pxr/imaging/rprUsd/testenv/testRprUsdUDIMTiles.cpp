@@ -0,0 +1,137 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Checks discovery of UDIM tiles from a directory listing.
+// Usage: testRprUsdUDIMTiles
+
+#include "pxr/imaging/rprUsd/util.h"
+
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+void CreateEmptyFile(std::string const& path) {
+    TF_AXIOM(TfMakeDirs(TfGetPathName(path), -1, true));
+    std::ofstream file(path);
+    TF_AXIOM(file.good());
+}
+
+std::vector<uint32_t> FindTiles(std::string const& filepath, RprUsdDirectoryListingCache* listingCache = nullptr) {
+    std::string formatString;
+    TF_AXIOM(RprUsdGetUDIMFormatString(filepath, &formatString));
+    return RprUsdFindUDIMTiles(formatString, listingCache);
+}
+
+void TestFormatString() {
+    std::string formatString;
+    TF_AXIOM(RprUsdGetUDIMFormatString("textures/albedo.<UDIM>.png", &formatString));
+    TF_AXIOM(formatString == "textures/albedo.%i.png");
+    TF_AXIOM(RprUsdGetUDIMFormatString("textures/albedo.%(UDIM)d.png", &formatString));
+    TF_AXIOM(formatString == "textures/albedo.%i.png");
+    TF_AXIOM(!RprUsdGetUDIMFormatString("textures/albedo.1001.png", &formatString));
+}
+
+void TestListing(std::string const& root) {
+    auto directory = TfStringCatPaths(root, "listing");
+
+    // Tiles
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1001.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1002.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1010.png"));
+    // Tiles above 1100 are not limited anymore
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1200.png"));
+
+    // Files that only look like tiles
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo..png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.999.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.01003.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.10a4.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.-1005.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1006.exr"));
+    CreateEmptyFile(TfStringCatPaths(directory, "roughness.1007.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.99999999999.png"));
+    // Directories are not tiles
+    TF_AXIOM(TfMakeDirs(TfStringCatPaths(directory, "albedo.1008.png"), -1, true));
+
+    std::vector<uint32_t> expectedTiles = {1001, 1002, 1010, 1200};
+
+#if !defined(ARCH_OS_WINDOWS)
+    // Symlinked tiles are included
+    TF_AXIOM(TfSymlink(TfStringCatPaths(directory, "albedo.1001.png"), TfStringCatPaths(directory, "albedo.1009.png")));
+    expectedTiles = {1001, 1002, 1009, 1010, 1200};
+#endif
+
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.<UDIM>.png")) == expectedTiles);
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.%(UDIM)d.png")) == expectedTiles);
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "roughness.<UDIM>.png")) == std::vector<uint32_t>{1007});
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.<UDIM>.exr")) == std::vector<uint32_t>{1006});
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "normal.<UDIM>.png")).empty());
+
+    TF_AXIOM(FindTiles(TfStringCatPaths(root, "missing/albedo.<UDIM>.png")).empty());
+}
+
+void TestListingCache(std::string const& root) {
+    auto directory = TfStringCatPaths(root, "cache");
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1001.png"));
+
+    RprUsdDirectoryListingCache listingCache;
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.<UDIM>.png"), &listingCache) == std::vector<uint32_t>{1001});
+    TF_AXIOM(listingCache.size() == 1);
+
+    // The directory is listed once per cache, textures in the same directory reuse the listing
+    CreateEmptyFile(TfStringCatPaths(directory, "albedo.1002.png"));
+    CreateEmptyFile(TfStringCatPaths(directory, "roughness.1001.png"));
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.<UDIM>.png"), &listingCache) == std::vector<uint32_t>{1001});
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "roughness.<UDIM>.png"), &listingCache).empty());
+    TF_AXIOM(listingCache.size() == 1);
+
+    std::vector<uint32_t> expectedTiles = {1001, 1002};
+    TF_AXIOM(FindTiles(TfStringCatPaths(directory, "albedo.<UDIM>.png")) == expectedTiles);
+}
+
+void TestTagInDirectoryName(std::string const& root) {
+    // There is no single directory to list, tiles are probed
+    CreateEmptyFile(TfStringCatPaths(root, "tiles_1001/albedo.png"));
+    CreateEmptyFile(TfStringCatPaths(root, "tiles_1003/albedo.png"));
+    CreateEmptyFile(TfStringCatPaths(root, "tiles_1004/roughness.png"));
+
+    std::vector<uint32_t> expectedTiles = {1001, 1003};
+    TF_AXIOM(FindTiles(TfStringCatPaths(root, "tiles_<UDIM>/albedo.png")) == expectedTiles);
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[]) {
+    std::string root = ArchMakeTmpSubdir(ArchGetTmpDir(), "testRprUsdUDIMTiles");
+    TF_AXIOM(!root.empty());
+
+    TestFormatString();
+    TestListing(root);
+    TestListingCache(root);
+    TestTagInDirectoryName(root);
+
+    TfRmTree(root);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef RPRUSD_TESTENV_TEST_UTILS_H
+#define RPRUSD_TESTENV_TEST_UTILS_H
+
+#include "pxr/pxr.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Command line of the unit tests: `testName [--benchmark] [size...]`.
+/// Tests registered with ctest run only behavioral checks,
+/// timings against the reference implementation are collected with --benchmark on the given problem size
+class RprUsdTestArgs {
+public:
+    RprUsdTestArgs(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--benchmark") == 0) {
+                m_isBenchmark = true;
+            } else {
+                m_sizes.push_back(argv[i]);
+            }
+        }
+    }
+
+    bool IsBenchmark() const { return m_isBenchmark; }
+
+    /// Returns the size passed at the given position or defaultValue when it is not specified
+    size_t GetSize(size_t index, size_t defaultValue) const {
+        return index < m_sizes.size() ? size_t(std::atoll(m_sizes[index].c_str())) : defaultValue;
+    }
+
+    double GetReal(size_t index, double defaultValue) const {
+        return index < m_sizes.size() ? std::atof(m_sizes[index].c_str()) : defaultValue;
+    }
+
+private:
+    bool m_isBenchmark = false;
+    std::vector<std::string> m_sizes;
+};
+
+/// Returns the median wall time of numRuns calls of f in milliseconds
+template <typename F>
+double RprUsdTestMeasureMilliseconds(F&& f, int numRuns = 5) {
+    std::vector<double> times(std::max(numRuns, 1));
+    for (auto& time : times) {
+        auto startTime = std::chrono::steady_clock::now();
+        f();
+        time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/// Measures an implementation and the reference implementation it replaces and prints both timings
+template <typename F, typename ReferenceF>
+void RprUsdTestCompareSpeed(const char* name, F&& f, ReferenceF&& reference, int numRuns = 5) {
+    double referenceTime = RprUsdTestMeasureMilliseconds(reference, numRuns);
+    double time = RprUsdTestMeasureMilliseconds(f, numRuns);
+    printf("  %s: %.2f ms (reference: %.2f ms, x%.2f)\n", name, time, referenceTime, time > 0.0 ? referenceTime / time : 0.0);
+}
+
+/// Checks that two buffers hold exactly the same bytes, e.g. that an optimized conversion is bit-exact
+inline bool RprUsdTestIsBitwiseEqual(void const* lhs, void const* rhs, size_t numBytes) {
+    return numBytes == 0 || std::memcmp(lhs, rhs, numBytes) == 0;
+}
+
+template <typename T>
+bool RprUsdTestIsBitwiseEqual(std::vector<T> const& lhs, std::vector<T> const& rhs) {
+    return lhs.size() == rhs.size() && RprUsdTestIsBitwiseEqual(lhs.data(), rhs.data(), lhs.size() * sizeof(T));
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // RPRUSD_TESTENV_TEST_UTILS_H
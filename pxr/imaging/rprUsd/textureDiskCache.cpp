@@ -0,0 +1,335 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "pxr/imaging/rprUsd/textureDiskCache.h"
+#include "pxr/imaging/rprUsd/debugCodes.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/envSetting.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+
+#include <ghc/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace fs = ghc::filesystem;
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(RPRUSD_TEXTURE_DISK_CACHE_SIZE, 4096,
+    "Maximum size in megabytes of decoded textures stored in the texture cache directory. Zero disables the cache");
+
+namespace {
+
+const char kEntryExtension[] = ".rprtex";
+const char kTmpExtension[] = ".rprtex.tmp";
+const char kEntryMagic[8] = {'R', 'P', 'R', 'T', 'E', 'X', '0', '3'};
+
+// Temporary files of crashed writers are removed after this amount of seconds
+const double kStaleTmpFileAge = 60.0 * 60.0;
+
+// Eviction frees some headroom below the budget so that the directory is not rescanned after every new entry
+const double kTrimTargetRatio = 0.9;
+
+struct EntryHeader {
+    char magic[8];
+    uint32_t headerSize;
+    uint32_t pxrVersion;
+
+    double sourceModificationTime;
+    int64_t sourceFileSize;
+    uint32_t sourcePathLength;
+    int32_t maxResolution;
+    int32_t reducePrecision;
+    float maxPrecisionError;
+
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    uint64_t dataSize;
+};
+
+struct SourceFileInfo {
+    double modificationTime = 0.0;
+    int64_t size = -1;
+
+    bool IsValid() const { return modificationTime != 0.0 && size > 0; }
+};
+
+SourceFileInfo GetSourceFileInfo(std::string const& filepath) {
+    SourceFileInfo info;
+    ArchGetModificationTime(filepath.c_str(), &info.modificationTime);
+    info.size = ArchGetFileLength(filepath.c_str());
+    return info;
+}
+
+std::string GetEntryFilename(std::string const& filepath, RprUsdTextureLoadOptions const& options, SourceFileInfo const& info) {
+    size_t hash = std::hash<std::string>{}(filepath);
+    hash ^= std::hash<double>{}(info.modificationTime) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int64_t>{}(info.size) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= options.GetHash() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return TfStringPrintf("%016llx%s", static_cast<unsigned long long>(hash), kEntryExtension);
+}
+
+std::string GetUniqueTmpSuffix() {
+    thread_local std::mt19937_64 generator(std::random_device{}() ^ std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    return TfStringPrintf(".%016llx%s", static_cast<unsigned long long>(generator()), kTmpExtension);
+}
+
+} // namespace anonymous
+
+RprUsdTextureDiskCache::RprUsdTextureDiskCache(std::string const& cacheDir)
+    : m_maxSize(size_t(std::max(TfGetEnvSetting(RPRUSD_TEXTURE_DISK_CACHE_SIZE), 0)) * 1024 * 1024) {
+#if PXR_VERSION >= 2105
+    if (cacheDir.empty() || !m_maxSize) {
+        return;
+    }
+
+    // Keep decoded textures separately from the files that RPR core stores in the same directory
+    auto dir = TfStringCatPaths(cacheDir, "decoded");
+    if (!TfIsDir(dir) && !TfMakeDirs(dir, -1, true)) {
+        TF_RUNTIME_ERROR("Failed to create texture disk cache directory: %s", dir.c_str());
+        return;
+    }
+
+    m_cacheDir = std::move(dir);
+#endif // PXR_VERSION >= 2105
+}
+
+RprUsdTextureDataRefPtr RprUsdTextureDiskCache::Load(std::string const& filepath, RprUsdTextureLoadOptions const& options) const {
+#if PXR_VERSION >= 2105
+    if (!IsEnabled()) {
+        return nullptr;
+    }
+
+    auto sourceInfo = GetSourceFileInfo(filepath);
+    if (!sourceInfo.IsValid()) {
+        // Non-filesystem images (e.g. usdz embedded) are not cached
+        return nullptr;
+    }
+
+    auto entryPath = TfStringCatPaths(m_cacheDir, GetEntryFilename(filepath, options, sourceInfo));
+    FILE* file = ArchOpenFile(entryPath.c_str(), "rb");
+    if (!file) {
+        return nullptr;
+    }
+
+    RprUsdTextureDataRefPtr ret;
+
+    EntryHeader header;
+    std::string sourcePath;
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, kEntryMagic, sizeof(kEntryMagic)) == 0 &&
+        header.headerSize == sizeof(EntryHeader) &&
+        header.pxrVersion == PXR_VERSION &&
+        header.sourceModificationTime == sourceInfo.modificationTime &&
+        header.sourceFileSize == sourceInfo.size &&
+        header.sourcePathLength == filepath.size() &&
+        header.maxResolution == options.maxResolution &&
+        header.reducePrecision == int32_t(options.reducePrecision) &&
+        header.maxPrecisionError == options.maxPrecisionError &&
+        header.format >= 0 && header.format < HioFormatCount &&
+        header.width > 0 && header.height > 0 &&
+        header.dataSize == size_t(header.width) * header.height * HioGetDataSizeOfFormat(HioFormat(header.format))) {
+
+        sourcePath.resize(header.sourcePathLength);
+        if (fread(&sourcePath[0], 1, sourcePath.size(), file) == sourcePath.size() &&
+            sourcePath == filepath) {
+
+            auto data = std::make_unique<uint8_t[]>(header.dataSize);
+            if (fread(data.get(), 1, header.dataSize, file) == header.dataSize) {
+                HioImage::StorageSpec storageSpec;
+                storageSpec.width = header.width;
+                storageSpec.height = header.height;
+                storageSpec.depth = 1;
+                storageSpec.format = HioFormat(header.format);
+                storageSpec.flipped = false;
+
+                ret = RprUsdTextureData::New(storageSpec, std::move(data));
+            }
+        }
+    }
+
+    fclose(file);
+
+    if (ret) {
+        // Trim evicts the least recently used entries first
+        std::error_code ec;
+        fs::last_write_time(entryPath, fs::file_time_type::clock::now(), ec);
+    }
+
+    TF_DEBUG(RPR_USD_DEBUG_IMAGE_CACHE).Msg("RprUsdTextureDiskCache: %s %s\n", ret ? "hit" : "invalid entry for", filepath.c_str());
+
+    return ret;
+#else
+    return nullptr;
+#endif // PXR_VERSION >= 2105
+}
+
+void RprUsdTextureDiskCache::Store(std::string const& filepath, RprUsdTextureLoadOptions const& options, RprUsdTextureData const& textureData) {
+#if PXR_VERSION >= 2105
+    if (!IsEnabled()) {
+        return;
+    }
+
+    auto sourceInfo = GetSourceFileInfo(filepath);
+    if (!sourceInfo.IsValid()) {
+        return;
+    }
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+    header.headerSize = sizeof(EntryHeader);
+    header.pxrVersion = PXR_VERSION;
+    header.sourceModificationTime = sourceInfo.modificationTime;
+    header.sourceFileSize = sourceInfo.size;
+    header.sourcePathLength = uint32_t(filepath.size());
+    header.maxResolution = options.maxResolution;
+    header.reducePrecision = int32_t(options.reducePrecision);
+    header.maxPrecisionError = options.maxPrecisionError;
+    header.format = textureData.GetFormat();
+    header.width = textureData.GetWidth();
+    header.height = textureData.GetHeight();
+    header.dataSize = size_t(header.width) * header.height * HioGetDataSizeOfFormat(textureData.GetFormat());
+
+    if (!textureData.GetData() || !header.dataSize || header.dataSize > m_maxSize) {
+        return;
+    }
+
+    auto entryPath = TfStringCatPaths(m_cacheDir, GetEntryFilename(filepath, options, sourceInfo));
+    if (TfIsFile(entryPath)) {
+        // Another process has already stored it
+        return;
+    }
+
+    // Write into a uniquely named file first so that other processes never observe partially written entries
+    auto tmpPath = entryPath + GetUniqueTmpSuffix();
+    FILE* file = ArchOpenFile(tmpPath.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+
+    bool isWritten = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(filepath.data(), 1, filepath.size(), file) == filepath.size() &&
+        fwrite(textureData.GetData(), 1, header.dataSize, file) == header.dataSize;
+    isWritten = (fclose(file) == 0) && isWritten;
+
+    if (!isWritten || std::rename(tmpPath.c_str(), entryPath.c_str()) != 0) {
+        // Either we are out of disk space or a concurrent process has won the race, both are fine
+        ArchUnlinkFile(tmpPath.c_str());
+        return;
+    }
+
+    m_totalSize += sizeof(header) + filepath.size() + header.dataSize;
+    m_isDirty = true;
+#endif // PXR_VERSION >= 2105
+}
+
+void RprUsdTextureDiskCache::Trim() {
+    if (!IsEnabled() || !m_isDirty.exchange(false)) {
+        return;
+    }
+
+    // The directory is scanned on the first trim to learn its size, afterwards only when
+    // the running size exceeds the budget. Entries stored by other processes are accounted by the next scan
+    if (m_isTotalSizeKnown && m_totalSize <= m_maxSize) {
+        return;
+    }
+
+    struct Entry {
+        std::string path;
+        double modificationTime;
+        size_t size;
+    };
+    std::vector<Entry> entries;
+    size_t totalSize = 0;
+
+    std::vector<std::string> dirnames, filenames, symlinknames;
+    if (!TfReadDir(m_cacheDir, &dirnames, &filenames, &symlinknames)) {
+        return;
+    }
+
+    double now = 0.0;
+    for (auto& filename : filenames) {
+        auto path = TfStringCatPaths(m_cacheDir, filename);
+
+        double modificationTime = 0.0;
+        if (!ArchGetModificationTime(path.c_str(), &modificationTime)) {
+            // Already removed by a concurrent process
+            continue;
+        }
+
+        if (TfStringEndsWith(filename, kTmpExtension)) {
+            now = std::max(now, modificationTime);
+            continue;
+        }
+
+        if (!TfStringEndsWith(filename, kEntryExtension)) {
+            continue;
+        }
+
+        int64_t size = ArchGetFileLength(path.c_str());
+        if (size < 0) {
+            continue;
+        }
+
+        now = std::max(now, modificationTime);
+        totalSize += size_t(size);
+        entries.push_back({std::move(path), modificationTime, size_t(size)});
+    }
+
+    // Remove temporary files that were left by crashed writers.
+    // The newest file in the directory serves as the current time to avoid clock differences between cache users
+    for (auto& filename : filenames) {
+        if (TfStringEndsWith(filename, kTmpExtension)) {
+            auto path = TfStringCatPaths(m_cacheDir, filename);
+            double modificationTime = 0.0;
+            if (ArchGetModificationTime(path.c_str(), &modificationTime) &&
+                now - modificationTime > kStaleTmpFileAge) {
+                ArchUnlinkFile(path.c_str());
+            }
+        }
+    }
+
+    m_isTotalSizeKnown = true;
+    if (totalSize <= m_maxSize) {
+        m_totalSize = totalSize;
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](Entry const& lhs, Entry const& rhs) {
+        return lhs.modificationTime < rhs.modificationTime;
+    });
+
+    size_t targetSize = size_t(m_maxSize * kTrimTargetRatio);
+    for (auto& entry : entries) {
+        if (totalSize <= targetSize) {
+            break;
+        }
+
+        // Concurrent processes may remove the same entries, ignore failures.
+        // On Windows, the entry that is being read at the moment cannot be removed, it will be removed next time
+        TF_DEBUG(RPR_USD_DEBUG_IMAGE_CACHE).Msg("RprUsdTextureDiskCache: evicting %s\n", entry.path.c_str());
+        ArchUnlinkFile(entry.path.c_str());
+        totalSize -= entry.size;
+    }
+
+    m_totalSize = totalSize;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
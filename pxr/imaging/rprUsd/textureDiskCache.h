@@ -0,0 +1,69 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef PXR_IMAGING_RPR_USD_TEXTURE_DISK_CACHE_H
+#define PXR_IMAGING_RPR_USD_TEXTURE_DISK_CACHE_H
+
+#include "pxr/imaging/rprUsd/api.h"
+#include "pxr/imaging/rprUsd/util.h"
+
+#include <atomic>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Persistent cache of decoded texture payloads.
+///
+/// Payloads are keyed by the source file path, its modification time and size
+/// and the load options the texture was loaded with, so a warm start reads raw pixels instead of decoding the source image.
+/// Because entries store the final payload, the result of precision analysis is cached as well.
+/// Entries are written to a temporary file and atomically renamed,
+/// which makes it safe to share one cache directory between several processes.
+/// Hits refresh the modification time of an entry, so eviction removes the least recently used entries.
+/// The object is meant to be long-lived: it keeps a running size of the cache
+/// and scans the directory only when the size exceeds the budget.
+class RprUsdTextureDiskCache {
+public:
+    /// cacheDir is the texture cache directory, see RprUsdConfig::GetTextureCacheDir.
+    /// The cache is disabled when the directory is empty or the size budget is zero
+    RPRUSD_API
+    explicit RprUsdTextureDiskCache(std::string const& cacheDir);
+
+    bool IsEnabled() const { return !m_cacheDir.empty(); }
+
+    /// Returns nullptr when there is no valid entry for the filepath and options,
+    /// see RprUsdTextureData::New. Can be called from multiple threads
+    RPRUSD_API
+    RprUsdTextureDataRefPtr Load(std::string const& filepath, RprUsdTextureLoadOptions const& options) const;
+
+    /// Can be called from multiple threads for different files
+    RPRUSD_API
+    void Store(std::string const& filepath, RprUsdTextureLoadOptions const& options, RprUsdTextureData const& textureData);
+
+    /// Removes the least recently used entries until the total size of the cache fits the budget.
+    /// Does nothing if nothing was stored by this object since the last call.
+    /// Must not be called concurrently with Store
+    RPRUSD_API
+    void Trim();
+
+private:
+    std::string m_cacheDir;
+    size_t m_maxSize;
+    std::atomic<bool> m_isDirty{false};
+    std::atomic<size_t> m_totalSize{0};
+    bool m_isTotalSizeKnown = false;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // PXR_IMAGING_RPR_USD_TEXTURE_DISK_CACHE_H
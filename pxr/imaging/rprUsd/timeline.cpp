@@ -0,0 +1,196 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "pxr/imaging/rprUsd/timeline.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/envSetting.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(RPRUSD_TIMELINE_FILE, "",
+    "Path to the Chrome trace JSON file where the timeline of hdRpr zones is written. Empty disables the timeline");
+
+namespace {
+
+struct Zone {
+    const char* name;
+    std::string detail;
+    RprUsdTimeline::Clock::time_point begin;
+    RprUsdTimeline::Clock::time_point end;
+};
+
+// Each thread records into its own buffer so that threads never wait for each other,
+// the buffer mutex is contended only while the timeline is flushed
+struct ThreadZones {
+    std::mutex mutex;
+    std::vector<Zone> zones;
+    size_t threadIndex;
+};
+
+// Zones are moved out of the thread buffers on each flush. The file keeps all zones written so far:
+// subsequent flushes append new zones in place of the closing part of the JSON
+struct TimelineData {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadZones>> threads;
+    size_t nextThreadIndex = 0;
+    RprUsdTimeline::Clock::time_point start = RprUsdTimeline::Clock::now();
+
+    bool isFileStarted = false;
+    long fileEventsEnd = 0;
+    size_t numWrittenZones = 0;
+};
+
+// Threads that record a lot of zones flush the timeline themselves so that buffers stay bounded
+// even if the timeline is flushed rarely, e.g. only when the render delegate is destroyed
+const size_t kMaxBufferedZones = 1 << 16;
+
+TimelineData& GetTimelineData() {
+    // Never destroyed: thread local buffers may be released after static destructors have run
+    static TimelineData* data = new TimelineData;
+    return *data;
+}
+
+ThreadZones& GetThreadZones() {
+    thread_local std::shared_ptr<ThreadZones> threadZones;
+    if (!threadZones) {
+        threadZones = std::make_shared<ThreadZones>();
+
+        auto& data = GetTimelineData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        threadZones->threadIndex = data.nextThreadIndex++;
+        data.threads.push_back(threadZones);
+    }
+    return *threadZones;
+}
+
+void WriteEscaped(FILE* file, const char* str) {
+    for (; *str; ++str) {
+        auto c = static_cast<unsigned char>(*str);
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+}
+
+} // namespace anonymous
+
+bool RprUsdTimeline::IsEnabled() {
+    static const bool isEnabled = []() {
+        if (TfGetEnvSetting(RPRUSD_TIMELINE_FILE).empty()) {
+            return false;
+        }
+        // Set the timeline start before the first zone begins
+        GetTimelineData();
+        return true;
+    }();
+    return isEnabled;
+}
+
+void RprUsdTimeline::AddZone(const char* name, std::string detail, Clock::time_point begin, Clock::time_point end) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    auto& threadZones = GetThreadZones();
+    size_t numZones;
+    {
+        std::lock_guard<std::mutex> lock(threadZones.mutex);
+        threadZones.zones.push_back({name, std::move(detail), begin, end});
+        numZones = threadZones.zones.size();
+    }
+
+    if (numZones >= kMaxBufferedZones) {
+        Flush();
+    }
+}
+
+void RprUsdTimeline::Flush() {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    auto& data = GetTimelineData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+
+    auto& filepath = TfGetEnvSetting(RPRUSD_TIMELINE_FILE);
+    FILE* file = ArchOpenFile(filepath.c_str(), data.isFileStarted ? "r+b" : "wb");
+    if (!file) {
+        TF_RUNTIME_ERROR("Failed to open timeline file: %s", filepath.c_str());
+        return;
+    }
+
+    if (data.isFileStarted) {
+        fseek(file, data.fileEventsEnd, SEEK_SET);
+    } else {
+        fputs("{\"traceEvents\":[\n", file);
+        data.isFileStarted = true;
+    }
+
+    auto toMicroseconds = [&data](Clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - data.start).count();
+    };
+
+    for (auto threadIt = data.threads.begin(); threadIt != data.threads.end();) {
+        auto& threadZones = *threadIt;
+
+        std::vector<Zone> zones;
+        {
+            std::lock_guard<std::mutex> threadLock(threadZones->mutex);
+            zones.swap(threadZones->zones);
+        }
+
+        for (auto& zone : zones) {
+            fputs(data.numWrittenZones ? ",\n" : "", file);
+            data.numWrittenZones++;
+
+            fputs("{\"name\":\"", file);
+            WriteEscaped(file, zone.name);
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f",
+                threadZones->threadIndex, toMicroseconds(zone.begin), toMicroseconds(zone.end) - toMicroseconds(zone.begin));
+            if (!zone.detail.empty()) {
+                fputs(",\"args\":{\"detail\":\"", file);
+                WriteEscaped(file, zone.detail.c_str());
+                fputs("\"}", file);
+            }
+            fputs("}", file);
+        }
+
+        // Buffers of exited threads are owned only by the timeline
+        if (threadZones.use_count() == 1 && threadZones->zones.empty()) {
+            threadIt = data.threads.erase(threadIt);
+        } else {
+            ++threadIt;
+        }
+    }
+
+    data.fileEventsEnd = ftell(file);
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+
+    if (fclose(file) != 0) {
+        TF_RUNTIME_ERROR("Failed to write timeline file: %s", filepath.c_str());
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,78 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#ifndef PXR_IMAGING_RPR_USD_TIMELINE_H
+#define PXR_IMAGING_RPR_USD_TIMELINE_H
+
+#include "pxr/imaging/rprUsd/api.h"
+
+#include <chrono>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// Timeline of the work done by hdRpr itself, e.g. prim syncs, texture loading, rendering and resolves.
+///
+/// Recording is enabled by setting RPRUSD_TIMELINE_FILE to the output path.
+/// Zones are written in Chrome trace event format that can be opened in chrome://tracing or Perfetto.
+/// When the timeline is disabled, a zone costs a single check of a cached flag
+class RprUsdTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RPRUSD_API
+    static bool IsEnabled();
+
+    /// Can be called from multiple threads. name must outlive the timeline, e.g. be a string literal
+    RPRUSD_API
+    static void AddZone(const char* name, std::string detail, Clock::time_point begin, Clock::time_point end);
+
+    /// Appends zones recorded since the previous flush to the timeline file and releases them.
+    /// Threads flush on their own once they buffer too many zones
+    RPRUSD_API
+    static void Flush();
+};
+
+/// Records the lifetime of the scope as a timeline zone.
+/// detail is copied only when the timeline is enabled
+class RprUsdTimelineZone {
+public:
+    explicit RprUsdTimelineZone(const char* name, const char* detail = nullptr)
+        : m_name(RprUsdTimeline::IsEnabled() ? name : nullptr) {
+        if (m_name) {
+            if (detail) {
+                m_detail = detail;
+            }
+            m_begin = RprUsdTimeline::Clock::now();
+        }
+    }
+
+    ~RprUsdTimelineZone() {
+        if (m_name) {
+            RprUsdTimeline::AddZone(m_name, std::move(m_detail), m_begin, RprUsdTimeline::Clock::now());
+        }
+    }
+
+    RprUsdTimelineZone(RprUsdTimelineZone const&) = delete;
+    RprUsdTimelineZone& operator=(RprUsdTimelineZone const&) = delete;
+
+private:
+    const char* m_name;
+    std::string m_detail;
+    RprUsdTimeline::Clock::time_point m_begin;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // PXR_IMAGING_RPR_USD_TIMELINE_H
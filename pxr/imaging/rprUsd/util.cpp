@@ -13,10 +13,20 @@ limitations under the License.
 
 #include "util.h"
 
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/fileUtils.h"
 #include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/gf/half.h"
+#include "pxr/base/work/loops.h"
 #include "pxr/imaging/glf/utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
+#include <type_traits>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -39,6 +49,67 @@ bool RprUsdGetUDIMFormatString(std::string const& filepath, std::string* out_for
     return false;
 }
 
+std::vector<uint32_t> RprUsdFindUDIMTiles(std::string const& formatString, RprUsdDirectoryListingCache* listingCache) {
+    constexpr uint32_t kStartTile = 1001;
+
+    std::vector<uint32_t> tileIds;
+
+    auto directory = TfGetPathName(formatString);
+    auto filenamePattern = formatString.substr(directory.size());
+    auto tileIdIdx = filenamePattern.find("%i");
+    if (tileIdIdx == std::string::npos) {
+        // UDIM tag is a part of the directory name, there is nothing to list
+        constexpr uint32_t kEndTile = 1100;
+        for (uint32_t tileId = kStartTile; tileId <= kEndTile; ++tileId) {
+            if (ArchFileAccess(TfStringPrintf(formatString.c_str(), tileId).c_str(), F_OK) == 0) {
+                tileIds.push_back(tileId);
+            }
+        }
+        return tileIds;
+    }
+
+    RprUsdDirectoryListingCache localListingCache;
+    if (!listingCache) {
+        listingCache = &localListingCache;
+    }
+
+    auto status = listingCache->emplace(directory, std::vector<std::string>());
+    auto& filenames = status.first->second;
+    if (status.second) {
+        std::vector<std::string> dirnames, symlinknames;
+        if (TfReadDir(directory.empty() ? "." : directory, &dirnames, &filenames, &symlinknames)) {
+            // Tiles may be symlinks to the actual files
+            filenames.insert(filenames.end(), symlinknames.begin(), symlinknames.end());
+        }
+    }
+
+    auto prefix = filenamePattern.substr(0, tileIdIdx);
+    auto suffix = filenamePattern.substr(tileIdIdx + 2);
+
+    for (auto& filename : filenames) {
+        if (filename.size() <= prefix.size() + suffix.size() ||
+            !TfStringStartsWith(filename, prefix) ||
+            !TfStringEndsWith(filename, suffix)) {
+            continue;
+        }
+
+        auto tileIdString = filename.substr(prefix.size(), filename.size() - prefix.size() - suffix.size());
+        if (tileIdString.size() > 9 ||
+            !std::all_of(tileIdString.begin(), tileIdString.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+
+        uint32_t tileId = uint32_t(std::stoul(tileIdString));
+        // Reject zero-padded names, tile paths are constructed from the format string
+        if (tileId >= kStartTile && std::to_string(tileId) == tileIdString) {
+            tileIds.push_back(tileId);
+        }
+    }
+
+    std::sort(tileIds.begin(), tileIds.end());
+    return tileIds;
+}
+
 bool RprUsdInitGLApi() {
 #if PXR_VERSION >= 2102
     return GarchGLApiLoad();
@@ -120,13 +191,282 @@ static const RprUsdTextureData::GLMetadata g_GLMetadata[HioFormatCount] =
 
 #if PXR_VERSION >= 2105
 
-std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(std::string const& filepath) {
+namespace {
+
+// Box filter: each destination pixel is the average of a factor x factor block of source pixels
+template <typename ComponentT, typename AccumulatorT>
+void DownsampleImage(
+    ComponentT const* src, int srcWidth, int srcHeight,
+    ComponentT* dst, int dstWidth, int dstHeight,
+    int numComponents, int factor) {
+    WorkParallelForN(dstHeight,
+        [=](size_t begin, size_t end) {
+            std::vector<AccumulatorT> sum(numComponents);
+            for (int dstY = int(begin); dstY < int(end); ++dstY) {
+                int srcYBegin = dstY * factor;
+                int srcYEnd = std::min(srcYBegin + factor, srcHeight);
+
+                for (int dstX = 0; dstX < dstWidth; ++dstX) {
+                    int srcXBegin = dstX * factor;
+                    int srcXEnd = std::min(srcXBegin + factor, srcWidth);
+
+                    std::fill(sum.begin(), sum.end(), AccumulatorT(0));
+                    for (int srcY = srcYBegin; srcY < srcYEnd; ++srcY) {
+                        auto srcPixel = src + (size_t(srcY) * srcWidth + srcXBegin) * numComponents;
+                        for (int srcX = srcXBegin; srcX < srcXEnd; ++srcX) {
+                            for (int c = 0; c < numComponents; ++c) {
+                                sum[c] += AccumulatorT(*srcPixel++);
+                            }
+                        }
+                    }
+
+                    auto numPixels = AccumulatorT((srcYEnd - srcYBegin) * (srcXEnd - srcXBegin));
+                    auto dstPixel = dst + (size_t(dstY) * dstWidth + dstX) * numComponents;
+                    for (int c = 0; c < numComponents; ++c) {
+                        AccumulatorT average = sum[c] / numPixels;
+                        dstPixel[c] = ComponentT(std::is_integral<ComponentT>::value ? std::round(average) : average);
+                    }
+                }
+            }
+        }
+    );
+}
+
+} // namespace anonymous
+
+bool RprUsdDownsampleImage(HioImage::StorageSpec const& srcSpec, HioImage::StorageSpec* dstSpec, int factor) {
+    if (HioIsCompressed(srcSpec.format)) {
+        return false;
+    }
+
+    auto src = srcSpec.data;
+    auto dst = dstSpec->data;
+    int numComponents = HioGetComponentCount(srcSpec.format);
+
+#define DOWNSAMPLE(ComponentT, AccumulatorT) \
+    DownsampleImage<ComponentT, AccumulatorT>( \
+        static_cast<ComponentT const*>(src), srcSpec.width, srcSpec.height, \
+        static_cast<ComponentT*>(dst), dstSpec->width, dstSpec->height, \
+        numComponents, factor)
+
+    switch (HioGetHioType(srcSpec.format)) {
+        case HioTypeUnsignedByte:
+        case HioTypeUnsignedByteSRGB:
+            // XXX: sRGB data is averaged without linearization, the difference is negligible for texture previews
+            DOWNSAMPLE(uint8_t, float);
+            return true;
+        case HioTypeSignedByte:
+            DOWNSAMPLE(int8_t, float);
+            return true;
+        case HioTypeUnsignedShort:
+            DOWNSAMPLE(uint16_t, float);
+            return true;
+        case HioTypeSignedShort:
+            DOWNSAMPLE(int16_t, float);
+            return true;
+        case HioTypeUnsignedInt:
+            DOWNSAMPLE(uint32_t, double);
+            return true;
+        case HioTypeInt:
+            DOWNSAMPLE(int32_t, double);
+            return true;
+        case HioTypeHalfFloat:
+            DOWNSAMPLE(GfHalf, float);
+            return true;
+        case HioTypeFloat:
+            DOWNSAMPLE(float, float);
+            return true;
+        case HioTypeDouble:
+            DOWNSAMPLE(double, double);
+            return true;
+        default:
+            return false;
+    }
+
+#undef DOWNSAMPLE
+}
+
+namespace {
+
+// Number of components processed by one task of precision analysis and conversion
+constexpr size_t kNumComponentsPerChunk = 256 * 1024;
+
+template <typename ComponentT>
+float GetNormalizedValue(ComponentT value) { return float(value); }
+template <>
+float GetNormalizedValue(uint16_t value) { return float(double(value) / 65535.0); }
+
+struct PrecisionAnalysis {
+    bool fitsUNorm8;
+    bool fitsFloat16;
+};
+
+// Finds out whether all values can be stored as 8-bit unsigned normalized integers or half floats
+template <typename ComponentT>
+PrecisionAnalysis AnalyzePrecision(ComponentT const* data, size_t numComponents, float maxError) {
+    std::atomic<bool> fitsUNorm8(true);
+    std::atomic<bool> fitsFloat16(true);
+
+    size_t numChunks = (numComponents + kNumComponentsPerChunk - 1) / kNumComponentsPerChunk;
+    WorkParallelForN(numChunks,
+        [&](size_t beginChunk, size_t endChunk) {
+            for (size_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+                bool chunkFitsUNorm8 = fitsUNorm8;
+                bool chunkFitsFloat16 = fitsFloat16;
+                if (!chunkFitsUNorm8 && !chunkFitsFloat16) {
+                    return;
+                }
+
+                size_t begin = chunk * kNumComponentsPerChunk;
+                size_t end = std::min(begin + kNumComponentsPerChunk, numComponents);
+                for (size_t i = begin; i < end; ++i) {
+                    float value = GetNormalizedValue(data[i]);
+
+                    if (chunkFitsUNorm8) {
+                        float quantized = float(std::round(double(value) * 255.0) / 255.0);
+                        chunkFitsUNorm8 = std::isfinite(value) && value >= 0.0f && value <= 1.0f &&
+                            std::abs(quantized - value) <= maxError;
+                    }
+
+                    if (chunkFitsFloat16 && std::isfinite(value)) {
+                        // Infinities and NaNs are preserved by half
+                        float halfValue = float(GfHalf(value));
+                        chunkFitsFloat16 = std::isfinite(halfValue) &&
+                            std::abs(halfValue - value) <= maxError * std::abs(value);
+                    }
+                }
+
+                if (!chunkFitsUNorm8) fitsUNorm8 = false;
+                if (!chunkFitsFloat16) fitsFloat16 = false;
+            }
+        }
+    );
+
+    return {fitsUNorm8, fitsFloat16};
+}
+
+template <typename SrcComponentT, typename DstComponentT>
+std::unique_ptr<uint8_t[]> ConvertComponents(SrcComponentT const* src, size_t numComponents) {
+    auto dstData = std::make_unique<uint8_t[]>(numComponents * sizeof(DstComponentT));
+    auto dst = reinterpret_cast<DstComponentT*>(dstData.get());
+
+    size_t numChunks = (numComponents + kNumComponentsPerChunk - 1) / kNumComponentsPerChunk;
+    WorkParallelForN(numChunks,
+        [=](size_t beginChunk, size_t endChunk) {
+            size_t begin = beginChunk * kNumComponentsPerChunk;
+            size_t end = std::min(endChunk * kNumComponentsPerChunk, numComponents);
+            for (size_t i = begin; i < end; ++i) {
+                float value = GetNormalizedValue(src[i]);
+                if (std::is_same<DstComponentT, uint8_t>::value) {
+                    dst[i] = DstComponentT(std::round(double(std::min(std::max(value, 0.0f), 1.0f)) * 255.0));
+                } else {
+                    dst[i] = DstComponentT(value);
+                }
+            }
+        }
+    );
+
+    return dstData;
+}
+
+HioFormat GetHioFormat(HioType type, int numComponents) {
+    static const HioFormat kUNorm8Formats[] = {HioFormatUNorm8, HioFormatUNorm8Vec2, HioFormatUNorm8Vec3, HioFormatUNorm8Vec4};
+    static const HioFormat kFloat16Formats[] = {HioFormatFloat16, HioFormatFloat16Vec2, HioFormatFloat16Vec3, HioFormatFloat16Vec4};
+    static const HioFormat kFloat32Formats[] = {HioFormatFloat32, HioFormatFloat32Vec2, HioFormatFloat32Vec3, HioFormatFloat32Vec4};
+
+    if (numComponents < 1 || numComponents > 4) {
+        return HioFormatInvalid;
+    }
+
+    switch (type) {
+        case HioTypeUnsignedByte: return kUNorm8Formats[numComponents - 1];
+        case HioTypeHalfFloat: return kFloat16Formats[numComponents - 1];
+        case HioTypeFloat: return kFloat32Formats[numComponents - 1];
+        default: return HioFormatInvalid;
+    }
+}
+
+template <typename ComponentT>
+bool ReducePrecision(ComponentT const* src, size_t numComponents, float maxError, HioType* outType, std::unique_ptr<uint8_t[]>* outData) {
+    auto analysis = AnalyzePrecision(src, numComponents, maxError);
+    if (analysis.fitsUNorm8) {
+        *outType = HioTypeUnsignedByte;
+        *outData = ConvertComponents<ComponentT, uint8_t>(src, numComponents);
+    } else if (analysis.fitsFloat16 && !std::is_same<ComponentT, GfHalf>::value) {
+        *outType = HioTypeHalfFloat;
+        *outData = ConvertComponents<ComponentT, GfHalf>(src, numComponents);
+    } else if (std::is_same<ComponentT, uint16_t>::value) {
+        // RPR does not support 16-bit integer images, float represents them exactly
+        *outType = HioTypeFloat;
+        *outData = ConvertComponents<ComponentT, float>(src, numComponents);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace anonymous
+
+void RprUsdReducePrecision(HioImage::StorageSpec* spec, std::unique_ptr<uint8_t[]>* data, float maxError) {
+    if (HioIsCompressed(spec->format)) {
+        return;
+    }
+
+    int numComponentsPerPixel = HioGetComponentCount(spec->format);
+    size_t numComponents = size_t(spec->width) * spec->height * numComponentsPerPixel;
+    maxError = std::max(maxError, 0.0f);
+
+    HioType reducedType;
+    std::unique_ptr<uint8_t[]> reducedData;
+    bool isReduced = false;
+    switch (HioGetHioType(spec->format)) {
+        case HioTypeFloat:
+            isReduced = ReducePrecision(reinterpret_cast<float const*>(data->get()), numComponents, maxError, &reducedType, &reducedData);
+            break;
+        case HioTypeHalfFloat:
+            isReduced = ReducePrecision(reinterpret_cast<GfHalf const*>(data->get()), numComponents, maxError, &reducedType, &reducedData);
+            break;
+        case HioTypeUnsignedShort:
+            isReduced = ReducePrecision(reinterpret_cast<uint16_t const*>(data->get()), numComponents, maxError, &reducedType, &reducedData);
+            break;
+        default:
+            break;
+    }
+
+    auto reducedFormat = isReduced ? GetHioFormat(reducedType, numComponentsPerPixel) : HioFormatInvalid;
+    if (reducedFormat == HioFormatInvalid) {
+        return;
+    }
+
+    spec->format = reducedFormat;
+    spec->data = reducedData.get();
+    *data = std::move(reducedData);
+}
+
+std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(std::string const& filepath, RprUsdTextureLoadOptions const& options) {
     auto ret = std::make_unique<RprUsdTextureData>();
+    int maxResolution = options.maxResolution;
     auto hioImage = HioImage::OpenForReading(filepath);
     if (!hioImage) {
         return nullptr;
     }
 
+    auto exceedsMaxResolution = [maxResolution](HioImageSharedPtr const& image) {
+        return maxResolution > 0 && std::max(image->GetWidth(), image->GetHeight()) > maxResolution;
+    };
+
+    // Files with mip levels (tiled EXR and TIFF, .tx, .rat) let us read the level that fits the limit directly.
+    // If no level fits, the smallest one is taken to reduce the amount of data to decode and downsample
+    if (exceedsMaxResolution(hioImage)) {
+        for (int mip = 1, numMips = hioImage->GetNumMipLevels(); mip < numMips && exceedsMaxResolution(hioImage); ++mip) {
+            auto mipImage = HioImage::OpenForReading(filepath, 0, mip);
+            if (!mipImage) {
+                break;
+            }
+            hioImage = std::move(mipImage);
+        }
+    }
+
     ret->_hioStorageSpec.width = hioImage->GetWidth();
     ret->_hioStorageSpec.height = hioImage->GetHeight();
     ret->_hioStorageSpec.depth = 1;
@@ -141,9 +481,47 @@ std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(std::string const& fil
         return nullptr;
     }
 
+    if (exceedsMaxResolution(hioImage) && !HioIsCompressed(ret->_hioStorageSpec.format)) {
+        int maxDimension = std::max(ret->_hioStorageSpec.width, ret->_hioStorageSpec.height);
+        int factor = (maxDimension + maxResolution - 1) / maxResolution;
+
+        HioImage::StorageSpec downsampledSpec = ret->_hioStorageSpec;
+        downsampledSpec.width = (ret->_hioStorageSpec.width + factor - 1) / factor;
+        downsampledSpec.height = (ret->_hioStorageSpec.height + factor - 1) / factor;
+
+        size_t downsampledDataSize = downsampledSpec.width * downsampledSpec.height * HioGetDataSizeOfFormat(downsampledSpec.format);
+        auto downsampledData = std::make_unique<uint8_t[]>(downsampledDataSize);
+        downsampledSpec.data = downsampledData.get();
+
+        if (RprUsdDownsampleImage(ret->_hioStorageSpec, &downsampledSpec, factor)) {
+            ret->_hioStorageSpec = downsampledSpec;
+            ret->_data = std::move(downsampledData);
+        }
+    }
+
+    if (options.reducePrecision) {
+        RprUsdReducePrecision(&ret->_hioStorageSpec, &ret->_data, options.maxPrecisionError);
+    }
+
+    return ret;
+}
+
+std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(HioImage::StorageSpec const& storageSpec, std::unique_ptr<uint8_t[]> data) {
+    if (!data) {
+        return nullptr;
+    }
+
+    auto ret = std::make_unique<RprUsdTextureData>();
+    ret->_hioStorageSpec = storageSpec;
+    ret->_data = std::move(data);
+    ret->_hioStorageSpec.data = ret->_data.get();
     return ret;
 }
 
+HioFormat RprUsdTextureData::GetFormat() const {
+    return _hioStorageSpec.format;
+}
+
 uint8_t* RprUsdTextureData::GetData() const {
     return _data.get();
 }
@@ -162,7 +540,8 @@ RprUsdTextureData::GLMetadata RprUsdTextureData::GetGLMetadata() const {
 
 #else // PXR_VERSION < 2105
 
-std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(std::string const& filepath) {
+std::shared_ptr<RprUsdTextureData> RprUsdTextureData::New(std::string const& filepath, RprUsdTextureLoadOptions const& options) {
+    // XXX: load options are not supported with GlfUVTextureData
     auto ret = std::make_unique<RprUsdTextureData>();
 
     ret->_uvTextureData = GlfUVTextureData::New(filepath, INT_MAX, 0, 0, 0, 0);
@@ -32,13 +32,46 @@ limitations under the License.
 #include "pxr/imaging/glf/uvTextureData.h"
 #endif
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+/// Options that affect the content of the loaded texture data
+struct RprUsdTextureLoadOptions {
+    /// Limits the largest dimension of the loaded texture, zero means no limit.
+    /// The largest mip level of the file that fits the limit is read directly,
+    /// files without such a level are downsampled after decoding
+    int maxResolution = 0;
+
+    /// Whether float and 16-bit integer textures are stored with the smallest component type that can represent them:
+    /// 8-bit for data in [0, 1] range, half for the rest.
+    /// Values may change by at most maxPrecisionError, absolute for 8-bit and relative for half. Zero keeps the reduction lossless
+    bool reducePrecision = false;
+    float maxPrecisionError = 0.0f;
+
+    bool operator==(RprUsdTextureLoadOptions const& rhs) const {
+        return maxResolution == rhs.maxResolution &&
+            reducePrecision == rhs.reducePrecision &&
+            maxPrecisionError == rhs.maxPrecisionError;
+    }
+    bool operator!=(RprUsdTextureLoadOptions const& rhs) const { return !(*this == rhs); }
+
+    size_t GetHash() const {
+        size_t hash = std::hash<int>{}(maxResolution);
+        hash ^= std::hash<bool>{}(reducePrecision) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<float>{}(maxPrecisionError) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
 class RPRUSD_API RprUsdTextureData {
 public:
-    static std::shared_ptr<RprUsdTextureData> New(std::string const& filepath);
+    static std::shared_ptr<RprUsdTextureData> New(std::string const& filepath, RprUsdTextureLoadOptions const& options = {});
 
     uint8_t* GetData() const;
     int GetWidth() const;
@@ -51,6 +84,12 @@ public:
     };
     GLMetadata GetGLMetadata() const;
 
+#if PXR_VERSION >= 2105
+    static std::shared_ptr<RprUsdTextureData> New(HioImage::StorageSpec const& storageSpec, std::unique_ptr<uint8_t[]> data);
+
+    HioFormat GetFormat() const;
+#endif // PXR_VERSION >= 2105
+
 private:
 #if PXR_VERSION >= 2105
     HioImage::StorageSpec _hioStorageSpec;
@@ -62,9 +101,34 @@ private:
 
 using RprUsdTextureDataRefPtr = std::shared_ptr<RprUsdTextureData>;
 
+#if PXR_VERSION >= 2105
+/// Downsamples the image \p factor times with a box filter, partial blocks at the right and bottom edges are averaged over the pixels they cover.
+/// \p dstSpec must have the size rounded up from the source size divided by \p factor and point to the allocated data.
+/// Returns false when the format is not supported, e.g. compressed
+RPRUSD_API
+bool RprUsdDownsampleImage(HioImage::StorageSpec const& srcSpec, HioImage::StorageSpec* dstSpec, int factor);
+
+/// Stores the texture data with the smallest component type that represents it within \p maxError:
+/// 8-bit for data in [0, 1] range, half for the rest (see RprUsdTextureLoadOptions).
+/// 16-bit integer data is treated as normalized and is converted to float when it can't be reduced.
+/// \p spec and \p data are left untouched when the data can't be stored with a smaller type
+RPRUSD_API
+void RprUsdReducePrecision(HioImage::StorageSpec* spec, std::unique_ptr<uint8_t[]>* data, float maxError);
+#endif // PXR_VERSION >= 2105
+
 RPRUSD_API
 bool RprUsdGetUDIMFormatString(std::string const& filepath, std::string* out_formatString);
 
+/// Directory listings (file and symlink names) keyed by the directory path
+using RprUsdDirectoryListingCache = std::map<std::string, std::vector<std::string>>;
+
+/// Returns ids of the UDIM tiles that exist on disk in ascending order.
+/// \p formatString is produced by RprUsdGetUDIMFormatString.
+/// The directory of the tiles is listed once and stored in \p listingCache when it's not null,
+/// so textures that share a directory reuse the listing
+RPRUSD_API
+std::vector<uint32_t> RprUsdFindUDIMTiles(std::string const& formatString, RprUsdDirectoryListingCache* listingCache = nullptr);
+
 RPRUSD_API
 bool RprUsdInitGLApi();
 